@@ -0,0 +1,91 @@
+#include "Bench.h"
+#include "AsyncLogWriter.h"
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <future>
+#include <thread>
+
+static void removeDb(const std::string& path) {
+    std::remove(path.c_str());
+    std::remove((path + "-wal").c_str());
+    std::remove((path + "-shm").c_str());
+}
+
+// Compares one-transaction-per-call logFoodForDate with the group-commit
+// AsyncLogWriter, driven by several producer threads.
+int runAsyncLogBench(int argc, char** argv) {
+    const long long entries = argc > 0 ? std::atoll(argv[0]) : 100000;
+    const int producers = argc > 1 ? std::atoi(argv[1]) : 4;
+    const int foods = 500;
+    const std::string dbPath = "bench_asynclog.db";
+    const Date firstDay = Date::fromYmd(2026, 1, 1);
+
+    removeDb(dbPath);
+    OpenProfile profile = throughputProfile();
+    profile.verbose = false;
+    DatabaseManager db(dbPath, profile);
+    if (!db.open() || !db.createTables()) return 1;
+
+    db.beginTransaction();
+    for (int i = 0; i < foods; ++i) {
+        db.addFood({ std::to_string(7000000 + i), "Async food " + std::to_string(i), 100.0 + i % 300, 5, 10, 2 });
+    }
+    db.commit();
+
+    // Synchronous baseline: every call is its own autocommit transaction.
+    const long long syncEntries = entries / 10 > 0 ? entries / 10 : 1;
+    BenchTimer syncTimer;
+    for (long long i = 0; i < syncEntries; ++i) {
+        db.logFoodForDate(firstDay + static_cast<int>(i % 30), std::to_string(7000000 + i % foods), 100);
+    }
+    printRate("sync logFoodForDate", syncEntries, syncTimer.seconds());
+
+    AsyncLogWriter writer(dbPath, AsyncLogOptions(), profile);
+    if (!writer.start()) return 1;
+
+    std::atomic<long long> failed{ 0 };
+    auto produce = [&](bool useFutures) {
+        std::vector<std::thread> threads;
+        for (int t = 0; t < producers; ++t) {
+            threads.emplace_back([&, t] {
+                std::vector<std::future<bool>> pending;
+                for (long long i = t; i < entries; i += producers) {
+                    Date day = firstDay + static_cast<int>(i % 30);
+                    std::string barcode = std::to_string(7000000 + i % foods);
+                    if (useFutures) {
+                        pending.push_back(writer.logFoodForDate(day, std::move(barcode), 100));
+                    } else {
+                        writer.logFoodForDate(day, std::move(barcode), 100, [&](bool ok) {
+                            if (!ok) failed.fetch_add(1, std::memory_order_relaxed);
+                        });
+                    }
+                }
+                for (auto& f : pending) {
+                    if (!f.get()) failed.fetch_add(1, std::memory_order_relaxed);
+                }
+            });
+        }
+        for (auto& th : threads) th.join();
+    };
+
+    BenchTimer futureTimer;
+    produce(true);
+    printRate("async logFoodForDate, futures (" + std::to_string(producers) + " producers)",
+              entries, futureTimer.seconds());
+
+    uint64_t batchesBefore = writer.committedBatches();
+    BenchTimer callbackTimer;
+    produce(false);
+    writer.stop();
+    printRate("async logFoodForDate, callbacks (" + std::to_string(producers) + " producers)",
+              entries, callbackTimer.seconds());
+
+    std::cout << writer.committedEntries() << " entries committed in " << writer.committedBatches()
+              << " batches (" << (writer.committedBatches() - batchesBefore) << " in callback run), "
+              << failed.load() << " failed\n";
+
+    db.close();
+    removeDb(dbPath);
+    return failed.load() == 0 ? 0 : 1;
+}
@@ -0,0 +1,54 @@
+#include "Bench.h"
+#include "BarcodeCache.h"
+#include <cstdio>
+#include <cstdlib>
+
+// Compares lookups served by SQLite (cache disabled) with lookups served by the
+// in-memory barcode cache once it is warm.
+int runBarcodeCacheBench(int argc, char** argv) {
+    const int foods = argc > 0 ? std::atoi(argv[0]) : 100000;
+    const long long calls = argc > 1 ? std::atoll(argv[1]) : 200000;
+    const std::string dbPath = "bench_cache.db";
+
+    std::remove(dbPath.c_str());
+    DatabaseManager db(dbPath, throughputProfile());
+    if (!db.open() || !db.createTables()) return 1;
+
+    db.beginTransaction();
+    for (int i = 0; i < foods; ++i) {
+        Food f{ std::to_string(5000000000000LL + i), "Food " + std::to_string(i), 100.0 + i % 400, 5.0, 10.0, 2.0 };
+        db.addFood(f);
+    }
+    db.commit();
+
+    std::vector<std::string> barcodes;
+    barcodes.reserve(foods);
+    for (int i = 0; i < foods; ++i) {
+        barcodes.push_back(std::to_string(5000000000000LL + (i * 7919LL) % foods));
+    }
+
+    long long found = 0;
+
+    BenchTimer sqlite;
+    for (long long i = 0; i < calls; ++i) {
+        if (db.getFoodByBarcode(barcodes[i % foods])) ++found;
+    }
+    printRate("getFoodByBarcode (SQLite)", calls, sqlite.seconds());
+
+    db.enableBarcodeCache(true);
+    for (const auto& b : barcodes) db.getFoodByBarcode(b);
+
+    BenchTimer cached;
+    for (long long i = 0; i < calls; ++i) {
+        if (db.getFoodByBarcode(barcodes[i % foods])) ++found;
+    }
+    printRate("getFoodByBarcode (cache hit)", calls, cached.seconds());
+
+    const BarcodeCache* cache = db.barcodeCache();
+    std::cout << "cache hits " << cache->hits() << ", misses " << cache->misses()
+              << ", entries " << cache->size() << "\n";
+
+    db.close();
+    std::remove(dbPath.c_str());
+    return found == 2 * calls ? 0 : 1;
+}
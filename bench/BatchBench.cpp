@@ -0,0 +1,53 @@
+#include "Bench.h"
+#include "BatchRunner.h"
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+
+// Generates a command script (catalog adds followed by a mix of logs, lookups
+// and totals) and runs it through BatchRunner on one connection.
+int runBatchBench(int argc, char** argv) {
+    const long long commands = argc > 0 ? std::atoll(argv[0]) : 200000;
+    const long long commitEvery = argc > 1 ? std::atoll(argv[1]) : 1000;
+    const int foods = 1000;
+    const std::string dbPath = "bench_batch.db";
+
+    std::ostringstream script;
+    for (int i = 0; i < foods; ++i) {
+        script << "add " << (6000000 + i) << " " << (60 + i % 400) << " 5 12 3 Scripted food " << i << "\n";
+    }
+    for (long long i = 0; i < commands; ++i) {
+        std::string date = (Date::fromYmd(2026, 1, 1) + static_cast<int>(i % 90)).toString();
+        switch (i % 4) {
+            case 0:
+            case 1: script << "log " << date << " " << (6000000 + i % foods) << " 125\n"; break;
+            case 2: script << "lookup " << (6000000 + (i * 31) % foods) << "\n"; break;
+            default: script << "total " << date << "\n"; break;
+        }
+    }
+
+    std::remove(dbPath.c_str());
+    OpenProfile profile = throughputProfile();
+    profile.verbose = false;
+    DatabaseManager db(dbPath, profile);
+    if (!db.open() || !db.createTables()) return 1;
+
+    BatchOptions options;
+    options.writesPerTransaction = commitEvery;
+
+    std::istringstream in(script.str());
+    std::ostringstream out;
+    BatchRunner runner(db, out, options);
+    BatchStats stats = runner.run(in);
+
+    std::cout << stats.commands << " commands, " << stats.failed << " failed, "
+              << stats.transactions << " transactions\n";
+    printRate("script commands (commit every " + std::to_string(commitEvery) + " writes)",
+              stats.commands, stats.seconds);
+
+    db.close();
+    std::remove(dbPath.c_str());
+    std::remove((dbPath + "-wal").c_str());
+    std::remove((dbPath + "-shm").c_str());
+    return stats.failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Minimal timing helpers shared by the calorie_bench scenarios.
+class BenchTimer {
+public:
+    BenchTimer() : start(std::chrono::steady_clock::now()) {}
+
+    double seconds() const {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+private:
+    std::chrono::steady_clock::time_point start;
+};
+
+inline void printRate(const std::string& label, long long ops, double seconds) {
+    std::cout << label << ": " << ops << " ops in " << seconds << " s -> "
+              << (seconds > 0 ? ops / seconds : 0.0) << " ops/sec\n";
+}
+
+// Nearest-rank percentile (p in 0..100); sorts the samples in place.
+inline double percentile(std::vector<double>& samples, double p) {
+    if (samples.empty()) return 0.0;
+    std::sort(samples.begin(), samples.end());
+    size_t rank = static_cast<size_t>(p / 100.0 * (samples.size() - 1) + 0.5);
+    return samples[std::min(rank, samples.size() - 1)];
+}
+
+int runStatementCacheBench(int argc, char** argv);
+int runImportBench(int argc, char** argv);
+int runBarcodeCacheBench(int argc, char** argv);
+int runConcurrencyBench(int argc, char** argv);
+int runLogScaleBench(int argc, char** argv);
+int runSeriesBench(int argc, char** argv);
+int runBatchBench(int argc, char** argv);
+int runAsyncLogBench(int argc, char** argv);
+int runNameSearchBench(int argc, char** argv);
+int runSnapshotBench(int argc, char** argv);
+int runSuiteBench(int argc, char** argv);
+int runReportBench(int argc, char** argv);
+int runNutrientsBench(int argc, char** argv);
+int runJournalBench(int argc, char** argv);
+int runPurgeBench(int argc, char** argv);
+int runRecipeBench(int argc, char** argv);
+int runSyncBench(int argc, char** argv);
+int runDayLogBench(int argc, char** argv);
+int runWarmupBench(int argc, char** argv);
+int runGtinBench(int argc, char** argv);
@@ -0,0 +1,53 @@
+#include "Bench.h"
+#include <cstring>
+
+struct Scenario {
+    const char* name;
+    int (*run)(int argc, char** argv);
+};
+
+static const Scenario scenarios[] = {
+    { "statements", runStatementCacheBench },
+    { "import", runImportBench },
+    { "cache", runBarcodeCacheBench },
+    { "concurrency", runConcurrencyBench },
+    { "logscale", runLogScaleBench },
+    { "series", runSeriesBench },
+    { "script", runBatchBench },
+    { "asynclog", runAsyncLogBench },
+    { "search", runNameSearchBench },
+    { "snapshot", runSnapshotBench },
+    { "suite", runSuiteBench },
+    { "reports", runReportBench },
+    { "nutrients", runNutrientsBench },
+    { "journal", runJournalBench },
+    { "purge", runPurgeBench },
+    { "recipes", runRecipeBench },
+    { "sync", runSyncBench },
+    { "daylog", runDayLogBench },
+    { "warmup", runWarmupBench },
+    { "gtin", runGtinBench },
+};
+
+static void usage() {
+    std::cout << "Usage: calorie_bench <scenario> [options]\nScenarios:\n";
+    for (const auto& s : scenarios) {
+        std::cout << "  " << s.name << "\n";
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        usage();
+        return 1;
+    }
+
+    for (const auto& s : scenarios) {
+        if (std::strcmp(argv[1], s.name) == 0) {
+            return s.run(argc - 2, argv + 2);
+        }
+    }
+
+    usage();
+    return 1;
+}
@@ -0,0 +1,80 @@
+#include "BenchReport.h"
+#include <cmath>
+#include <ostream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+namespace {
+
+// Names and keys are plain identifiers, but escape defensively anyway.
+void writeString(std::ostream& out, const std::string& s) {
+    out << '"';
+    for (char c : s) {
+        if (c == '"' || c == '\\') out << '\\' << c;
+        else if (static_cast<unsigned char>(c) < 0x20) out << ' ';
+        else out << c;
+    }
+    out << '"';
+}
+
+void writeNumber(std::ostream& out, double v) {
+    out << (std::isfinite(v) ? v : 0.0);
+}
+
+} // namespace
+
+void BenchReport::writeJson(std::ostream& out) const {
+    const auto oldPrecision = out.precision(9);
+
+    out << "{\n  \"suite\": ";
+    writeString(out, suite);
+    out << ",\n  \"config\": {";
+    for (size_t i = 0; i < config.size(); ++i) {
+        out << (i ? ", " : "");
+        writeString(out, config[i].first);
+        out << ": " << config[i].second;
+    }
+    out << "},\n  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const BenchResult& r = results[i];
+        out << "    {\"name\": ";
+        writeString(out, r.name);
+        out << ", \"ops\": " << r.ops << ", \"seconds\": ";
+        writeNumber(out, r.seconds);
+        out << ", \"ops_per_sec\": ";
+        writeNumber(out, r.opsPerSecond());
+        out << ", \"p50_us\": ";
+        writeNumber(out, r.p50Us);
+        out << ", \"p99_us\": ";
+        writeNumber(out, r.p99Us);
+        out << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ],\n  \"peak_rss_bytes\": " << peakRssBytes() << "\n}\n";
+
+    out.precision(oldPrecision);
+}
+
+long long peakRssBytes() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return static_cast<long long>(counters.PeakWorkingSetSize);
+    }
+    return 0;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#ifdef __APPLE__
+    return static_cast<long long>(usage.ru_maxrss);          // bytes on macOS
+#else
+    return static_cast<long long>(usage.ru_maxrss) * 1024;   // KiB on Linux
+#endif
+#endif
+}
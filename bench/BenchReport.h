@@ -0,0 +1,38 @@
+#pragma once
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <utility>
+#include <vector>
+
+// One measured operation in a machine-readable benchmark report.
+struct BenchResult {
+    std::string name;
+    long long ops = 0;
+    double seconds = 0.0;
+    double p50Us = 0.0;
+    double p99Us = 0.0;
+
+    double opsPerSecond() const { return seconds > 0 ? ops / seconds : 0.0; }
+};
+
+// Collects results and writes them as one JSON document, e.g.
+// {"suite":"...","config":{...},"results":[...],"peak_rss_bytes":N}
+class BenchReport {
+public:
+    explicit BenchReport(std::string suiteName) : suite(std::move(suiteName)) {}
+
+    void setConfig(const std::string& key, long long value) { config.emplace_back(key, value); }
+    void add(const BenchResult& result) { results.push_back(result); }
+    const std::vector<BenchResult>& entries() const { return results; }
+
+    void writeJson(std::ostream& out) const;
+
+private:
+    std::string suite;
+    std::vector<std::pair<std::string, long long>> config;
+    std::vector<BenchResult> results;
+};
+
+// Peak resident set size of this process so far, or 0 where unsupported.
+long long peakRssBytes();
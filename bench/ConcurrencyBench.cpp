@@ -0,0 +1,105 @@
+#include "Bench.h"
+#include "ConnectionPool.h"
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+namespace {
+
+struct ThreadResult {
+    std::vector<double> latenciesUs;
+};
+
+std::string dateFor(int day) {
+    char buf[16];
+    std::snprintf(buf, sizeof(buf), "2026-%02d-%02d", 1 + (day / 28) % 12, 1 + day % 28);
+    return buf;
+}
+
+void report(const std::string& label, std::vector<ThreadResult>& results, double seconds) {
+    std::vector<double> all;
+    for (auto& r : results) all.insert(all.end(), r.latenciesUs.begin(), r.latenciesUs.end());
+    long long ops = static_cast<long long>(all.size());
+    printRate(label, ops, seconds);
+    double p50 = percentile(all, 50);
+    double p99 = percentile(all, 99);
+    std::cout << "  p50 " << p50 << " us, p99 " << p99 << " us\n";
+}
+
+} // namespace
+
+// Writers log through the pool's writer connection while readers query per-date
+// entries and totals on read-only connections.
+int runConcurrencyBench(int argc, char** argv) {
+    const int writers = argc > 0 ? std::atoi(argv[0]) : 2;
+    const int readerThreads = argc > 1 ? std::atoi(argv[1]) : 4;
+    const double seconds = argc > 2 ? std::atof(argv[2]) : 3.0;
+    const int foods = 1000;
+    const std::string dbPath = "bench_concurrency.db";
+
+    std::remove(dbPath.c_str());
+    std::remove((dbPath + "-wal").c_str());
+    std::remove((dbPath + "-shm").c_str());
+
+    ConnectionPool pool(dbPath, static_cast<size_t>(readerThreads), throughputProfile());
+    if (!pool.open()) return 1;
+
+    {
+        auto w = pool.writer();
+        w->beginTransaction();
+        for (int i = 0; i < foods; ++i) {
+            w->addFood(Food{ std::to_string(7000000 + i), "Food " + std::to_string(i), 50.0 + i % 300, 4, 12, 3 });
+        }
+        for (int i = 0; i < 20000; ++i) {
+            w->logFoodForDate(dateFor(i % 336), std::to_string(7000000 + i % foods), 100);
+        }
+        w->commit();
+    }
+
+    std::atomic<bool> stop{ false };
+    std::vector<ThreadResult> writeResults(writers), readResults(readerThreads);
+    std::vector<std::thread> threads;
+
+    for (int t = 0; t < writers; ++t) {
+        threads.emplace_back([&, t] {
+            long long i = t;
+            while (!stop.load(std::memory_order_relaxed)) {
+                BenchTimer op;
+                auto w = pool.writer();
+                w->logFoodForDate(dateFor(static_cast<int>(i % 336)), std::to_string(7000000 + i % foods), 150);
+                writeResults[t].latenciesUs.push_back(op.seconds() * 1e6);
+                i += writers;
+            }
+        });
+    }
+
+    for (int t = 0; t < readerThreads; ++t) {
+        threads.emplace_back([&, t] {
+            long long i = t;
+            while (!stop.load(std::memory_order_relaxed)) {
+                std::string date = dateFor(static_cast<int>(i % 336));
+                BenchTimer op;
+                auto r = pool.reader();
+                r->getEntriesForDate(date);
+                r->getTotalCaloriesForDate(date);
+                readResults[t].latenciesUs.push_back(op.seconds() * 1e6);
+                ++i;
+            }
+        });
+    }
+
+    std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+    stop = true;
+    for (auto& th : threads) th.join();
+
+    std::cout << writers << " writer(s), " << readerThreads << " reader(s), " << seconds << " s\n";
+    report("logFoodForDate", writeResults, seconds);
+    report("getEntriesForDate + getTotalCaloriesForDate", readResults, seconds);
+
+    pool.close();
+    std::remove(dbPath.c_str());
+    std::remove((dbPath + "-wal").c_str());
+    std::remove((dbPath + "-shm").c_str());
+    return 0;
+}
@@ -0,0 +1,54 @@
+#include "DataGenerator.h"
+#include "Migrations.h"
+#include "SqlExec.h"
+
+namespace {
+
+const char* const nameWords[] = { "Oat", "Rice", "Chicken", "Yogurt", "Apple", "Lentil", "Salmon", "Bread",
+                                  "Cheese", "Tomato", "Almond", "Banana", "Turkey", "Pasta", "Bean", "Soup" };
+
+} // namespace
+
+bool generateDatabase(DatabaseManager& db, const GeneratorSpec& spec, GeneratedData& out) {
+    BenchRng rng(spec.seed);
+    const long long perTransaction = 50000;
+
+    out.barcodes.clear();
+    out.barcodes.reserve(static_cast<size_t>(spec.foods));
+    out.firstDay = spec.firstDay;
+    out.days = spec.days > 0 ? spec.days : 1;
+
+    for (long long i = 0; i < spec.foods; ++i) {
+        if (i % perTransaction == 0) {
+            if (!db.beginTransaction() || !execSql(db.handle(), deferFoodSearchSyncSql)) return false;
+        }
+
+        Food f;
+        f.barcode = std::to_string(4000000000000LL + i);
+        f.name = std::string(nameWords[rng.below(16)]) + " " + nameWords[rng.below(16)] + " " + std::to_string(i);
+        f.calories_per_100g = 20.0 + static_cast<double>(rng.below(600));
+        f.protein = static_cast<double>(rng.below(40));
+        f.carbs = static_cast<double>(rng.below(80));
+        f.fat = static_cast<double>(rng.below(50));
+        if (!db.addFood(f)) return false;
+        out.barcodes.push_back(f.barcode);
+
+        if (i % perTransaction == perTransaction - 1 || i == spec.foods - 1) {
+            if (!execSql(db.handle(), flushFoodSearchSyncSql) || !db.commit()) return false;
+        }
+    }
+
+    if (spec.foods == 0) return spec.logs == 0;
+
+    for (long long i = 0; i < spec.logs; ++i) {
+        if (i % perTransaction == 0 && !db.beginTransaction()) return false;
+
+        Date day = out.firstDay + static_cast<int>(rng.below(static_cast<uint64_t>(out.days)));
+        long long foodId = static_cast<long long>(rng.below(static_cast<uint64_t>(spec.foods))) + 1;
+        double grams = 10.0 + static_cast<double>(rng.below(490));
+        if (!db.insertLogRow(day, foodId, grams)) return false;
+
+        if ((i % perTransaction == perTransaction - 1 || i == spec.logs - 1) && !db.commit()) return false;
+    }
+    return true;
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "DatabaseManager.h"
+
+struct GeneratorSpec {
+    long long foods = 10000;
+    long long logs = 200000;
+    int days = 365;
+    uint64_t seed = 1;
+    Date firstDay = Date::fromYmd(2025, 1, 1);
+};
+
+// What the generator wrote, so benchmarks can pick keys that exist.
+struct GeneratedData {
+    std::vector<std::string> barcodes;   // index i is foods.id i + 1
+    Date firstDay;
+    int days = 0;
+};
+
+// SplitMix64: tiny, fast and identical on every platform, so a seed always
+// produces the same database.
+class BenchRng {
+public:
+    explicit BenchRng(uint64_t seed) : state(seed) {}
+
+    uint64_t next() {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    uint64_t below(uint64_t n) { return next() % n; }
+
+private:
+    uint64_t state;
+};
+
+// Fills a freshly created (empty) database with spec.foods foods and spec.logs
+// log rows spread over spec.days days. Deterministic for a given spec.
+bool generateDatabase(DatabaseManager& db, const GeneratorSpec& spec, GeneratedData& out);
@@ -0,0 +1,143 @@
+#include "Bench.h"
+#include "DataGenerator.h"
+#include "DatabaseManager.h"
+#include "FoodDatabase.h"
+#include "UserDayLog.h"
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+// Counts every C++ heap allocation in calorie_bench. SQLite allocates through
+// malloc and is not counted.
+static std::atomic<long long> heapAllocations{ 0 };
+
+void* operator new(std::size_t size) {
+    heapAllocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, std::align_val_t align) {
+    heapAllocations.fetch_add(1, std::memory_order_relaxed);
+    const size_t alignment = static_cast<size_t>(align);
+    const size_t rounded = ((size ? size : 1) + alignment - 1) / alignment * alignment;
+#ifdef _WIN32
+    if (void* p = _aligned_malloc(rounded, alignment)) return p;
+#else
+    if (void* p = std::aligned_alloc(alignment, rounded)) return p;
+#endif
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+#ifdef _WIN32
+void operator delete(void* p, std::align_val_t) noexcept { _aligned_free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { _aligned_free(p); }
+#else
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+#endif
+
+namespace {
+
+void removeDb(const std::string& path) {
+    std::remove(path.c_str());
+    std::remove((path + "-wal").c_str());
+    std::remove((path + "-shm").c_str());
+}
+
+const int kFoods = 300;
+
+std::string foodBarcode(int i) { return std::to_string(4006000000000LL + i); }
+
+// Loads the same day `rounds` times through `load` and reports time and heap
+// allocations per load; the first load is timed separately.
+template <typename Load>
+void measure(const std::string& label, int rounds, Load load) {
+    long long before = heapAllocations.load();
+    BenchTimer first;
+    double calories = load();
+    const double firstSeconds = first.seconds();
+    const long long firstAllocations = heapAllocations.load() - before;
+
+    before = heapAllocations.load();
+    BenchTimer steady;
+    for (int r = 0; r < rounds; ++r) calories += load();
+    const double seconds = steady.seconds();
+    const long long allocations = heapAllocations.load() - before;
+
+    std::cout << label << ": first " << firstSeconds * 1e6 << " us / " << firstAllocations
+              << " allocations, then " << seconds / rounds * 1e6 << " us / "
+              << static_cast<double>(allocations) / rounds << " allocations per day"
+              << " (" << calories / (rounds + 1) << " kcal)\n";
+}
+
+} // namespace
+
+// Logs `entries` rows on one day from 300 foods, then materializes and sums
+// that day `rounds` times: as std::vector<LogEntry> (two strings per entry),
+// as a UserDayLog read from SQLite, and as a UserDayLog built from an
+// in-memory FoodDatabase.
+int runDayLogBench(int argc, char** argv) {
+    const int entries = argc > 0 ? std::atoi(argv[0]) : 1000;
+    const int rounds = argc > 1 ? std::atoi(argv[1]) : 2000;
+    const std::string dbPath = "bench_daylog.db";
+
+    removeDb(dbPath);
+    OpenProfile profile = throughputProfile();
+    profile.verbose = false;
+    DatabaseManager db(dbPath, profile);
+    if (!db.open() || !db.createTables()) return 1;
+
+    db.beginTransaction();
+    for (int i = 0; i < kFoods; ++i) {
+        db.addFood(Food{ foodBarcode(i), "Wholegrain breakfast product no. " + std::to_string(i), 80.0 + i % 350,
+                         2.0 + i % 25, 5.0 + i % 60, 1.0 + i % 30 });
+    }
+    const Date day = Date::fromYmd(2025, 3, 14);
+    BenchRng rng(22);
+    std::vector<std::pair<std::string, double>> logged;
+    for (int i = 0; i < entries; ++i) {
+        logged.emplace_back(foodBarcode(static_cast<int>(rng.below(kFoods))), 20.0 + rng.below(300));
+        db.logFoodForDate(day, logged.back().first, logged.back().second);
+    }
+    db.commit();
+
+    measure("getEntriesForDate (vector<LogEntry>)", rounds, [&] {
+        Nutrients sum;
+        for (const LogEntry& e : db.getEntriesForDate(day)) sum += e.nutrients;
+        return sum.calories();
+    });
+
+    UserDayLog log;
+    measure("UserDayLog::load (SQLite)", rounds, [&] {
+        log.load(db, day);
+        Nutrients sum;
+        for (const UserDayLog::Entry& e : log) sum += e.nutrients;
+        return sum.calories();
+    });
+    std::cout << "  " << log.size() << " entries, " << log.internedStrings() << " interned strings, arena "
+              << log.arena().capacity() / 1024 << " KiB in " << log.arena().blockCount() << " block(s)\n";
+
+    MemoryFoodDatabase catalog;
+    if (!catalog.load(db.handle())) return 1;
+    UserDayLog memoryLog;
+    measure("UserDayLog::add (MemoryFoodDatabase)", rounds, [&] {
+        memoryLog.reset(day);
+        for (const auto& entry : logged) memoryLog.add(catalog, entry.first, entry.second);
+        Nutrients sum;
+        for (const UserDayLog::Entry& e : memoryLog) sum += e.nutrients;
+        return sum.calories();
+    });
+
+    db.close();
+    removeDb(dbPath);
+    return log.size() == static_cast<size_t>(entries) && memoryLog.size() == static_cast<size_t>(entries) ? 0 : 1;
+}
@@ -0,0 +1,70 @@
+#include "Bench.h"
+#include "DataGenerator.h"
+#include "Gtin.h"
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace {
+
+char checkDigit(const std::string& body) {
+    int sum = 0;
+    for (size_t i = 0; i < body.size(); ++i) {
+        const int digit = body[body.size() - 1 - i] - '0';
+        sum += (i % 2 == 0) ? digit * 3 : digit;
+    }
+    return static_cast<char>('0' + (10 - sum % 10) % 10);
+}
+
+// Mostly valid GTIN-8/12/13/14, with misread check digits, short in-store
+// codes and text mixed in, as in a vendor catalog.
+std::string generateCode(BenchRng& rng) {
+    static const size_t lengths[] = { 8, 12, 13, 13, 13, 14 };
+    const uint64_t kind = rng.below(20);
+    if (kind == 0) return "SKU-" + std::to_string(rng.below(100000));
+    if (kind == 1) return std::to_string(rng.below(1000000));
+
+    std::string code;
+    const size_t length = lengths[rng.below(6)];
+    for (size_t i = 0; i + 1 < length; ++i) code += static_cast<char>('0' + rng.below(10));
+    char check = checkDigit(code);
+    if (kind == 2) check = static_cast<char>('0' + (check - '0' + 1) % 10);
+    code += check;
+    return code;
+}
+
+} // namespace
+
+// Times the scalar and SSE2 batch GTIN kernels and normalizeBarcode on
+// `count` generated codes. Correctness is checked by the gtin test (tests/).
+int runGtinBench(int argc, char** argv) {
+    const size_t count = argc > 0 ? static_cast<size_t>(std::atoll(argv[0])) : 4000000;
+
+    BenchRng rng(24);
+    std::vector<std::string> storage;
+    storage.reserve(count);
+    for (size_t i = 0; i < count; ++i) storage.push_back(generateCode(rng));
+    std::vector<std::string_view> codes(storage.begin(), storage.end());
+    std::vector<uint64_t> scalarKeys(count);
+    std::vector<uint64_t> simdKeys(count);
+
+    BenchTimer scalarTimer;
+    const size_t scalarValid = gtinKeysScalar(codes.data(), count, scalarKeys.data());
+    const double scalarSeconds = scalarTimer.seconds();
+    BenchTimer simdTimer;
+    const size_t simdValid = gtinKeys(codes.data(), count, simdKeys.data());
+    const double simdSeconds = simdTimer.seconds();
+
+    BenchTimer normalizeTimer;
+    size_t normalizedBytes = 0;
+    for (const std::string_view code : codes) normalizedBytes += normalizeBarcode(code).size();
+    const double normalizeSeconds = normalizeTimer.seconds();
+
+    std::cout << count << " codes, " << simdValid << " valid GTINs (scalar: " << scalarValid << ")\n"
+              << "  scalar keys:      " << count / scalarSeconds / 1e6 << " M codes/s\n"
+              << "  batch keys:       " << count / simdSeconds / 1e6 << " M codes/s (x" << scalarSeconds / simdSeconds
+              << ")\n"
+              << "  normalizeBarcode: " << count / normalizeSeconds / 1e6 << " M codes/s (" << normalizedBytes
+              << " bytes)\n";
+    return 0;
+}
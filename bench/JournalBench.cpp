@@ -0,0 +1,90 @@
+#include "Bench.h"
+#include "DatabaseManager.h"
+#include "LogJournal.h"
+#include <cstdio>
+#include <cstdlib>
+
+namespace {
+
+void removeDb(const std::string& path) {
+    std::remove(path.c_str());
+    std::remove((path + "-wal").c_str());
+    std::remove((path + "-shm").c_str());
+}
+
+const int kFoods = 100;
+const Date kDay = Date::fromYmd(2025, 6, 1);
+
+std::string barcodeFor(long long i) {
+    return std::to_string(4000000000000LL + i % kFoods);
+}
+
+bool createCatalog(const std::string& path) {
+    removeDb(path);
+    OpenProfile profile = throughputProfile();
+    profile.verbose = false;
+    DatabaseManager db(path, profile);
+    if (!db.open() || !db.createTables()) return false;
+    db.beginTransaction();
+    for (int i = 0; i < kFoods; ++i) {
+        db.addFood(Food{ barcodeFor(i), "Journal food " + std::to_string(i), 100.0 + i, 5.0, 10.0, 2.0 });
+    }
+    return db.commit();
+}
+
+} // namespace
+
+// Append throughput under several fsync policies and the replay rate. Crash
+// safety is checked by the journal test (tests/).
+int runJournalBench(int argc, char** argv) {
+    const long long records = argc > 0 ? std::atoll(argv[0]) : 200000;
+    const std::string journalPath = "bench_journal.jrnl";
+    const std::string dbPath = "bench_journal.db";
+
+    struct Policy {
+        const char* label;
+        int syncEveryRecords;
+        long long records;
+    };
+    const Policy policies[] = {
+        { "append, no fsync", 0, records },
+        { "append, fsync every 256", 256, records },
+        { "append, fsync every 64", 64, records },
+        { "append, fsync every record", 1, std::max(1LL, records / 100) },
+    };
+    for (const Policy& p : policies) {
+        std::remove(journalPath.c_str());
+        JournalOptions options;
+        options.syncEveryRecords = p.syncEveryRecords;
+        options.syncIntervalMs = 0;
+        LogJournalWriter journal;
+        if (!journal.open(journalPath, options)) return 1;
+        BenchTimer timer;
+        for (long long i = 0; i < p.records; ++i) journal.append(kDay, barcodeFor(i), static_cast<double>(i + 1));
+        journal.close();
+        printRate(p.label, p.records, timer.seconds());
+    }
+
+    // The no-fsync journal from the first policy is rebuilt for the replay rate.
+    {
+        std::remove(journalPath.c_str());
+        LogJournalWriter journal;
+        JournalOptions options;
+        options.syncEveryRecords = 0;
+        if (!journal.open(journalPath, options)) return 1;
+        for (long long i = 0; i < records; ++i) journal.append(kDay, barcodeFor(i), static_cast<double>(i + 1));
+    }
+    if (!createCatalog(dbPath)) return 1;
+    {
+        OpenProfile profile = throughputProfile();
+        profile.verbose = false;
+        DatabaseManager db(dbPath, profile);
+        if (!db.open()) return 1;
+        JournalReplayStats stats = replayJournal(db, journalPath);
+        printRate("replay (10000 per transaction)", stats.inserted, stats.seconds);
+    }
+
+    std::remove(journalPath.c_str());
+    removeDb(dbPath);
+    return 0;
+}
@@ -0,0 +1,68 @@
+#include "Bench.h"
+#include "DatabaseManager.h"
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+namespace {
+
+Date dateFor(int day) {
+    return Date::fromYmd(2016, 1, 1) + day;
+}
+
+} // namespace
+
+// Grows daily_log from 10k rows up to `maxRows` (x10 each step) and measures the
+// per-date read APIs at every size.
+int runLogScaleBench(int argc, char** argv) {
+    const long long maxRows = argc > 0 ? std::atoll(argv[0]) : 1000000;
+    const int queries = argc > 1 ? std::atoi(argv[1]) : 1000;
+    const int foods = 1000;
+    const int days = 3650;
+    const std::string dbPath = "bench_logscale.db";
+
+    std::remove(dbPath.c_str());
+    DatabaseManager db(dbPath, throughputProfile());
+    if (!db.open() || !db.createTables()) return 1;
+
+    db.beginTransaction();
+    for (int i = 0; i < foods; ++i) {
+        db.addFood(Food{ std::to_string(8000000 + i), "Food " + std::to_string(i), 50.0 + i % 300, 4, 12, 3 });
+    }
+    db.commit();
+
+    std::mt19937 rng(42);
+
+    long long rows = 0;
+    for (long long target = 10000; target <= maxRows; target *= 10) {
+        db.beginTransaction();
+        for (; rows < target; ++rows) {
+            const Date date = dateFor(static_cast<int>(rng() % days));
+            const long long foodId = 1 + static_cast<long long>(rng() % foods);
+            db.insertLogRow(date, foodId, 50 + rng() % 200);
+        }
+        db.commit();
+
+        std::vector<double> entriesUs, totalsUs;
+        for (int q = 0; q < queries; ++q) {
+            Date date = dateFor(static_cast<int>(rng() % days));
+            BenchTimer e;
+            db.getEntriesForDate(date);
+            entriesUs.push_back(e.seconds() * 1e6);
+            BenchTimer t;
+            db.getTotalCaloriesForDate(date);
+            totalsUs.push_back(t.seconds() * 1e6);
+        }
+
+        std::cout << rows << " rows: getEntriesForDate p50 " << percentile(entriesUs, 50)
+                  << " us p99 " << percentile(entriesUs, 99) << " us"
+                  << " | getTotalCaloriesForDate p50 " << percentile(totalsUs, 50)
+                  << " us p99 " << percentile(totalsUs, 99) << " us\n";
+    }
+
+    db.close();
+    std::remove(dbPath.c_str());
+    std::remove((dbPath + "-wal").c_str());
+    std::remove((dbPath + "-shm").c_str());
+    return 0;
+}
@@ -0,0 +1,122 @@
+#include "Bench.h"
+#include "FoodImporter.h"
+#include "FoodSearch.h"
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+
+namespace {
+
+const char* const brands[] = { "Acme", "Nordic", "Sunny", "Valley", "Harvest", "Golden", "Alpine", "Coastal" };
+const char* const styles[] = { "Organic", "Smoked", "Roasted", "Light", "Spicy", "Classic", "Crunchy", "Creamy",
+                               "Baked", "Fresh", "Frozen", "Honey" };
+const char* const foods[] = { "Chicken Breast", "Greek Yogurt", "Peanut Butter", "Oat Porridge", "Salmon Fillet",
+                              "Almond Milk", "Cheddar Cheese", "Tomato Soup", "Banana Bread", "Rice Crackers",
+                              "Turkey Ham", "Granola Bar", "Mango Chutney", "Lentil Curry", "Sourdough Loaf",
+                              "Blueberry Muffin" };
+
+template <size_t N>
+const char* pick(const char* const (&words)[N], uint64_t& state) {
+    state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return words[(state >> 33) % N];
+}
+
+void removeDb(const std::string& path) {
+    std::remove(path.c_str());
+    std::remove((path + "-wal").c_str());
+    std::remove((path + "-shm").c_str());
+}
+
+void report(const std::string& label, std::vector<double>& micros, long long hits, long long truncated) {
+    double total = 0;
+    for (double m : micros) total += m;
+    std::cout << label << ": " << micros.size() << " queries, avg " << total / micros.size()
+              << " us, p50 " << percentile(micros, 50) << " us, p99 " << percentile(micros, 99)
+              << " us, " << hits << " hits, " << truncated << " truncated\n";
+}
+
+} // namespace
+
+// Builds a catalog of synthetic names ("Sunny Smoked Salmon Fillet 123") and
+// measures per-query latency of full-text, fuzzy and combined search.
+int runNameSearchBench(int argc, char** argv) {
+    const long long foodCount = argc > 0 ? std::atoll(argv[0]) : 1000000;
+    const int queries = argc > 1 ? std::atoi(argv[1]) : 2000;
+    const size_t limit = 10;
+    const std::string dbPath = "bench_search.db";
+
+    removeDb(dbPath);
+    OpenProfile profile = throughputProfile();
+    profile.verbose = false;
+    DatabaseManager db(dbPath, profile);
+    if (!db.open() || !db.createTables()) return 1;
+
+    // Loaded through the importer, which indexes each batch in one statement.
+    const std::string csvPath = "bench_search.csv";
+    {
+        std::ofstream out(csvPath, std::ios::binary);
+        uint64_t state = 42;
+        for (long long i = 0; i < foodCount; ++i) {
+            out << (5000000000000LL + i) << "," << pick(brands, state) << " " << pick(styles, state) << " "
+                << pick(foods, state) << " " << (i % 1000) << "," << (100 + i % 400) << ",5,10,3\n";
+        }
+    }
+
+    FoodImporter importer(db);
+    ImportStats loaded = importer.importFile(csvPath, ImportOptions());
+    std::remove(csvPath.c_str());
+    if (!loaded.completed) return 1;
+    printRate("catalog import with foods_fts", loaded.rowsWritten, loaded.seconds);
+
+    FoodSearch search(db);
+    BenchTimer buildTimer;
+    if (!search.buildIndex()) return 1;
+    std::cout << "trigram index: " << search.trigramIndex().size() << " names, "
+              << search.trigramIndex().postingCount() << " postings, built in " << buildTimer.seconds() << " s\n";
+
+    // Prefixes, multi-word prefixes and misspellings.
+    const char* const workload[] = { "chick", "greek yog", "salmn fillet", "peanut", "sourdugh",
+                                     "alpine crunchy granola", "blueberry muf", "lentl cury", "almond",
+                                     "spicy mango chutny", "ched", "tomato sop" };
+    const size_t workloadSize = sizeof(workload) / sizeof(workload[0]);
+
+    std::vector<double> fullText, fuzzy, combined;
+    long long fullHits = 0, fuzzyHits = 0, combinedHits = 0;
+    long long fullCut = 0, fuzzyCut = 0, combinedCut = 0;
+
+    for (int i = 0; i < queries; ++i) {
+        const std::string q = workload[i % workloadSize];
+
+        BenchTimer t1;
+        SearchResult r1 = search.searchFullText(q, limit, std::chrono::milliseconds(50));
+        fullText.push_back(t1.seconds() * 1e6);
+        fullHits += static_cast<long long>(r1.hits.size());
+        fullCut += r1.truncated;
+
+        BenchTimer t2;
+        SearchResult r2 = search.searchFuzzy(q, limit, std::chrono::milliseconds(50));
+        fuzzy.push_back(t2.seconds() * 1e6);
+        fuzzyHits += static_cast<long long>(r2.hits.size());
+        fuzzyCut += r2.truncated;
+
+        BenchTimer t3;
+        SearchResult r3 = search.search(q, limit);
+        combined.push_back(t3.seconds() * 1e6);
+        combinedHits += static_cast<long long>(r3.hits.size());
+        combinedCut += r3.truncated;
+    }
+
+    report("full-text (FTS5)", fullText, fullHits, fullCut);
+    report("fuzzy (trigram)", fuzzy, fuzzyHits, fuzzyCut);
+    report("combined, 50 ms budget", combined, combinedHits, combinedCut);
+
+    SearchResult sample = search.search("salmn fillet", 3);
+    for (const SearchHit& hit : sample.hits) {
+        std::cout << "  \"salmn fillet\" -> " << hit.food.name << (hit.fuzzy ? " (fuzzy)" : "") << "\n";
+    }
+
+    db.close();
+    removeDb(dbPath);
+    return 0;
+}
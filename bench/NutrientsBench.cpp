@@ -0,0 +1,142 @@
+#include "Bench.h"
+#include "DataGenerator.h"
+#include "DatabaseManager.h"
+#include <cstdio>
+#include <cstdlib>
+
+namespace {
+
+void removeDb(const std::string& path) {
+    std::remove(path.c_str());
+    std::remove((path + "-wal").c_str());
+    std::remove((path + "-shm").c_str());
+}
+
+// The calorie-only entries query getEntriesForDate ran before it returned nutrients.
+const char* const calorieEntriesSql =
+    "SELECT f.name, f.barcode, l.grams, (f.calories_per_100g / 100.0) * l.grams AS calories "
+    "FROM daily_log l JOIN foods f ON f.id = l.food_id WHERE l.day = ? ORDER BY l.id ASC;";
+
+// One SUM per nutrient: what adding macros to the calorie-only query would cost
+// without a combined pass.
+const char* const sumSql[] = {
+    "SELECT SUM(f.calories_per_100g / 100.0 * l.grams) FROM daily_log l JOIN foods f ON f.id = l.food_id WHERE l.day = ?;",
+    "SELECT SUM(COALESCE(f.protein, 0) / 100.0 * l.grams) FROM daily_log l JOIN foods f ON f.id = l.food_id WHERE l.day = ?;",
+    "SELECT SUM(COALESCE(f.carbs, 0) / 100.0 * l.grams) FROM daily_log l JOIN foods f ON f.id = l.food_id WHERE l.day = ?;",
+    "SELECT SUM(COALESCE(f.fat, 0) / 100.0 * l.grams) FROM daily_log l JOIN foods f ON f.id = l.food_id WHERE l.day = ?;",
+};
+
+} // namespace
+
+// Compares the per-day entry scan with and without the full nutrient vector,
+// one combined pass against one SUM query per nutrient, and the lane-wise
+// Nutrients sum against a calories-only sum.
+int runNutrientsBench(int argc, char** argv) {
+    const long long entriesPerDay = argc > 0 ? std::atoll(argv[0]) : 2000;
+    const int days = argc > 1 ? std::atoi(argv[1]) : 30;
+    const std::string dbPath = "bench_nutrients.db";
+
+    removeDb(dbPath);
+    OpenProfile profile = throughputProfile();
+    profile.verbose = false;
+    DatabaseManager db(dbPath, profile);
+    if (!db.open() || !db.createTables()) return 1;
+
+    GeneratorSpec spec;
+    spec.foods = 2000;
+    spec.logs = entriesPerDay * days;
+    spec.days = days;
+    GeneratedData data;
+    if (!generateDatabase(db, spec, data)) return 1;
+    std::cout << days << " days, ~" << entriesPerDay << " entries per day\n";
+
+    const int rounds = 5;
+    double checksum = 0.0;
+
+    sqlite3_stmt* calorieOnly = nullptr;
+    sqlite3_prepare_v2(db.handle(), calorieEntriesSql, -1, &calorieOnly, nullptr);
+    BenchTimer oldScan;
+    for (int r = 0; r < rounds; ++r) {
+        for (int d = 0; d < days; ++d) {
+            sqlite3_bind_int(calorieOnly, 1, (data.firstDay + d).days());
+            std::vector<LogEntry> entries;
+            while (sqlite3_step(calorieOnly) == SQLITE_ROW) {
+                LogEntry e;
+                e.name = reinterpret_cast<const char*>(sqlite3_column_text(calorieOnly, 0));
+                e.barcode = reinterpret_cast<const char*>(sqlite3_column_text(calorieOnly, 1));
+                e.grams = sqlite3_column_double(calorieOnly, 2);
+                e.nutrients.lane[Nutrients::Calories] = sqlite3_column_double(calorieOnly, 3);
+                checksum += e.nutrients.calories();
+                entries.push_back(e);
+            }
+            sqlite3_reset(calorieOnly);
+        }
+    }
+    sqlite3_finalize(calorieOnly);
+    printRate("entries, calories only (previous query)", rounds * days, oldScan.seconds());
+
+    BenchTimer newScan;
+    for (int r = 0; r < rounds; ++r) {
+        for (int d = 0; d < days; ++d) {
+            Nutrients sum;
+            for (const LogEntry& e : db.getEntriesForDate(data.firstDay + d)) sum += e.nutrients;
+            checksum += sum.calories();
+        }
+    }
+    printRate("getEntriesForDate, all nutrients + sum", rounds * days, newScan.seconds());
+
+    sqlite3_stmt* sums[4] = {};
+    for (int i = 0; i < 4; ++i) sqlite3_prepare_v2(db.handle(), sumSql[i], -1, &sums[i], nullptr);
+    for (int queries : { 1, 4 }) {
+        BenchTimer timer;
+        for (int r = 0; r < rounds; ++r) {
+            for (int d = 0; d < days; ++d) {
+                for (int i = 0; i < queries; ++i) {
+                    sqlite3_bind_int(sums[i], 1, (data.firstDay + d).days());
+                    if (sqlite3_step(sums[i]) == SQLITE_ROW) checksum += sqlite3_column_double(sums[i], 0);
+                    sqlite3_reset(sums[i]);
+                }
+            }
+        }
+        printRate(queries == 1 ? "SUM query, calories only" : "SUM queries, one per nutrient (4)", rounds * days,
+                  timer.seconds());
+    }
+    for (sqlite3_stmt* s : sums) sqlite3_finalize(s);
+
+    const long long rollupCalls = 200000;
+    BenchTimer rollupCalories;
+    for (long long i = 0; i < rollupCalls; ++i) checksum += db.getTotalCaloriesForDate(data.firstDay + static_cast<int>(i % days));
+    printRate("getTotalCaloriesForDate (rollup)", rollupCalls, rollupCalories.seconds());
+    BenchTimer rollupNutrients;
+    for (long long i = 0; i < rollupCalls; ++i) checksum += db.getNutrientsForDate(data.firstDay + static_cast<int>(i % days)).calories();
+    printRate("getNutrientsForDate (rollup)", rollupCalls, rollupNutrients.seconds());
+
+    // In-memory summing: 1M entries, all lanes vs the calories column alone.
+    const size_t count = 1000000;
+    std::vector<Nutrients> values(count);
+    std::vector<double> calories(count);
+    BenchRng rng(7);
+    for (size_t i = 0; i < count; ++i) {
+        for (double& v : values[i].lane) v = static_cast<double>(rng.below(1000)) / 10.0;
+        calories[i] = values[i].calories();
+    }
+    const int sumRounds = 20;
+    BenchTimer laneSum;
+    for (int r = 0; r < sumRounds; ++r) checksum += sumNutrients(values.data(), count).protein();
+    const double laneSeconds = laneSum.seconds();
+    BenchTimer scalarSum;
+    for (int r = 0; r < sumRounds; ++r) {
+        double total = 0.0;
+        for (double c : calories) total += c;
+        checksum += total;
+    }
+    const double scalarSeconds = scalarSum.seconds();
+    std::cout << "sumNutrients (8 lanes): " << laneSeconds * 1e9 / (sumRounds * count) << " ns/entry, "
+              << sumRounds * count * sizeof(Nutrients) / laneSeconds / 1e9 << " GB/s\n"
+              << "calories-only double sum: " << scalarSeconds * 1e9 / (sumRounds * count) << " ns/entry\n";
+
+    std::cout << "(checksum " << checksum << ")\n";
+    db.close();
+    removeDb(dbPath);
+    return 0;
+}
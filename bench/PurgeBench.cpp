@@ -0,0 +1,205 @@
+#include "Bench.h"
+#include "DataGenerator.h"
+#include "DatabaseManager.h"
+#include "LogPartitions.h"
+#include "SqlExec.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <thread>
+
+namespace {
+
+void removeDb(const std::string& path) {
+    std::remove(path.c_str());
+    std::remove((path + "-wal").c_str());
+    std::remove((path + "-shm").c_str());
+}
+
+const int kFoods = 1000;
+const int kFirstMonth = 202301;
+
+// The unpartitioned layout daily_log had before migration 7: one table, its
+// indexes, and the rollup delete trigger that a DELETE runs per row.
+const char* const flatSchemaSql = R"(
+    CREATE TABLE foods AS SELECT * FROM src.foods;
+    CREATE UNIQUE INDEX idx_foods_id ON foods(id);
+    CREATE TABLE daily_totals AS SELECT * FROM src.daily_totals;
+    CREATE UNIQUE INDEX idx_daily_totals_day ON daily_totals(day);
+    CREATE TABLE daily_log (
+        id INTEGER PRIMARY KEY AUTOINCREMENT,
+        day INTEGER NOT NULL,
+        food_id INTEGER NOT NULL,
+        grams REAL NOT NULL
+        );
+    INSERT INTO daily_log (id, day, food_id, grams) SELECT id, day, food_id, grams FROM src.daily_log;
+    CREATE INDEX idx_daily_log_day_food ON daily_log(day, food_id, grams);
+    CREATE INDEX idx_daily_log_food ON daily_log(food_id);
+
+    CREATE TRIGGER trg_daily_log_delete AFTER DELETE ON daily_log
+    WHEN EXISTS (SELECT 1 FROM daily_totals WHERE day = OLD.day)
+    BEGIN
+        DELETE FROM daily_totals WHERE day = OLD.day;
+        INSERT INTO daily_totals (day, calories, protein, carbs, fat, entries)
+        SELECT l.day,
+               SUM(f.calories_per_100g / 100.0 * l.grams),
+               SUM(COALESCE(f.protein, 0) / 100.0 * l.grams),
+               SUM(COALESCE(f.carbs, 0) / 100.0 * l.grams),
+               SUM(COALESCE(f.fat, 0) / 100.0 * l.grams),
+               COUNT(*)
+        FROM daily_log l JOIN foods f ON f.id = l.food_id
+        WHERE l.day = OLD.day
+        GROUP BY l.day;
+    END;
+    )";
+
+int monthAfter(int month, int n) {
+    const int index = (month / 100) * 12 + month % 100 - 1 + n;
+    return (index / 12) * 100 + index % 12 + 1;
+}
+
+// Logs one row about every millisecond from its own connection while `purge`
+// runs, and reports the slowest insert: how long a purge blocks loggers.
+void withConcurrentLogger(const char* label, const std::function<bool(long long)>& logOne,
+                          const std::function<bool()>& purge) {
+    std::atomic<bool> stop{ false };
+    std::vector<double> latencyMs;
+    std::thread logger([&] {
+        for (long long i = 0; !stop.load(); ++i) {
+            BenchTimer t;
+            logOne(i);
+            latencyMs.push_back(t.seconds() * 1e3);
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    BenchTimer timer;
+    const bool ok = purge();
+    const double seconds = timer.seconds();
+    stop = true;
+    logger.join();
+
+    std::cout << label << ": " << seconds * 1e3 << " ms" << (ok ? "" : " (FAILED)")
+              << " | concurrent log inserts: " << latencyMs.size() << ", max "
+              << (latencyMs.empty() ? 0.0 : *std::max_element(latencyMs.begin(), latencyMs.end())) << " ms\n";
+}
+
+} // namespace
+
+// Loads `rows` log rows spread over `months` months, then expires all but the
+// newest `keep` months and finally clears the log: once as DELETE statements
+// on the unpartitioned layout, once by dropping monthly partitions. A second
+// connection keeps logging throughout to show how long each purge blocks it.
+int runPurgeBench(int argc, char** argv) {
+    const long long rows = argc > 0 ? std::atoll(argv[0]) : 10000000;
+    const int months = argc > 1 ? std::atoi(argv[1]) : 36;
+    const int keep = argc > 2 ? std::atoi(argv[2]) : 12;
+    const std::string partitionedPath = "bench_purge.db";
+    const std::string flatPath = "bench_purge_flat.db";
+
+    removeDb(partitionedPath);
+    removeDb(flatPath);
+    OpenProfile profile = throughputProfile();
+    profile.verbose = false;
+    DatabaseManager db(partitionedPath, profile);
+    if (!db.open() || !db.createTables()) return 1;
+
+    db.beginTransaction();
+    for (int i = 0; i < kFoods; ++i) {
+        db.addFood(Food{ std::to_string(7000000 + i), "Purge food " + std::to_string(i), 50.0 + i % 300, 4, 12, 3 });
+    }
+    db.commit();
+
+    // Rows are spread evenly over the days of the range.
+    const Date firstDay = logPartitionFirstDay(kFirstMonth);
+    const int lastMonth = monthAfter(kFirstMonth, months - 1);
+    const int days = logPartitionLastDay(lastMonth) - firstDay + 1;
+    BenchRng rng(11);
+    BenchTimer load;
+    const long long perTransaction = 100000;
+    for (long long done = 0; done < rows;) {
+        db.beginTransaction();
+        for (long long end = std::min(rows, done + perTransaction); done < end; ++done) {
+            const Date day = firstDay + static_cast<int>(done * days / rows);
+            db.insertLogRow(day, 1 + static_cast<long long>(rng.below(kFoods)), 50.0 + rng.below(200));
+        }
+        db.commit();
+    }
+    printRate("load, partitioned (insertLogRow)", rows, load.seconds());
+
+    BenchTimer copy;
+    {
+        sqlite3* flat = nullptr;
+        sqlite3_open(flatPath.c_str(), &flat);
+        const bool ok = execSql(flat, "PRAGMA journal_mode = WAL; PRAGMA synchronous = NORMAL;") &&
+                        execSql(flat, "ATTACH DATABASE '" + partitionedPath + "' AS src;") &&
+                        execSql(flat, std::string("BEGIN;") + flatSchemaSql + "COMMIT;") &&
+                        execSql(flat, "DETACH DATABASE src;");
+        sqlite3_close(flat);
+        if (!ok) return 1;
+    }
+    std::cout << "copied into the unpartitioned layout in " << copy.seconds() << " s\n";
+
+    const int oldestKept = monthAfter(lastMonth, -(keep - 1));
+    const int cutoff = logPartitionFirstDay(oldestKept).days();
+    std::cout << rows << " rows over " << months << " months; retention keeps " << keep << " months\n";
+
+    // Unpartitioned: the logger and the purge each use their own connection.
+    {
+        sqlite3* logConn = nullptr;
+        sqlite3_open(flatPath.c_str(), &logConn);
+        sqlite3_busy_timeout(logConn, 60000);
+        sqlite3_stmt* insert = nullptr;
+        sqlite3_prepare_v2(logConn, "INSERT INTO daily_log (day, food_id, grams) VALUES (?, ?, ?);", -1, &insert,
+                           nullptr);
+        auto logOne = [&](long long i) {
+            sqlite3_bind_int(insert, 1, logPartitionLastDay(lastMonth).days());
+            sqlite3_bind_int64(insert, 2, 1 + i % kFoods);
+            sqlite3_bind_double(insert, 3, 100.0);
+            const bool ok = sqlite3_step(insert) == SQLITE_DONE;
+            sqlite3_reset(insert);
+            return ok;
+        };
+
+        sqlite3* flat = nullptr;
+        sqlite3_open(flatPath.c_str(), &flat);
+        sqlite3_busy_timeout(flat, 60000);
+        withConcurrentLogger("retention, DELETE ... WHERE day < cutoff", logOne, [&] {
+            const std::string c = std::to_string(cutoff);
+            return execSql(flat, "BEGIN IMMEDIATE; DELETE FROM daily_totals WHERE day < " + c +
+                                  "; DELETE FROM daily_log WHERE day < " + c + "; COMMIT;");
+        });
+        withConcurrentLogger("clear, DELETE FROM daily_log", logOne, [&] {
+            return execSql(flat, "BEGIN IMMEDIATE; DELETE FROM daily_totals; DELETE FROM daily_log; COMMIT;");
+        });
+        sqlite3_close(flat);
+        sqlite3_finalize(insert);
+        sqlite3_close(logConn);
+    }
+
+    // Partitioned: applyLogRetention and clearAllLogs as the application runs them.
+    {
+        DatabaseManager logger(partitionedPath, profile);
+        if (!logger.open()) return 1;
+        auto logOne = [&](long long i) {
+            return logger.insertLogRow(logPartitionLastDay(lastMonth), 1 + i % kFoods, 100.0);
+        };
+
+        db.setLogRetentionMonths(keep);
+        int dropped = 0;
+        withConcurrentLogger("retention, applyLogRetention", logOne, [&] {
+            dropped = db.applyLogRetention(logPartitionLastDay(lastMonth));
+            return dropped >= 0;
+        });
+        std::cout << "  dropped " << dropped << " partitions\n";
+        withConcurrentLogger("clear, clearAllLogs", logOne, [&] { return db.clearAllLogs(); });
+    }
+
+    db.close();
+    removeDb(partitionedPath);
+    removeDb(flatPath);
+    return 0;
+}
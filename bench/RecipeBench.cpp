@@ -0,0 +1,177 @@
+#include "Bench.h"
+#include "DataGenerator.h"
+#include "DatabaseManager.h"
+#include "Recipes.h"
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+
+namespace {
+
+void removeDb(const std::string& path) {
+    std::remove(path.c_str());
+    std::remove((path + "-wal").c_str());
+    std::remove((path + "-shm").c_str());
+}
+
+const int kLeaves = 200;
+const int kMealsPerDay = 3;
+
+std::string leafBarcode(int i) { return std::to_string(8000000 + i); }
+std::string recipeBarcode(int level, int i) { return std::to_string(9000000 + level * 10000 + i); }
+
+// Grams of each plain food in one gram of `barcode`, following nested recipes.
+using Expansion = std::map<std::string, double>;
+
+const Expansion& expand(DatabaseManager& db, const std::string& barcode, std::map<std::string, Expansion>& memo) {
+    auto found = memo.find(barcode);
+    if (found != memo.end()) return found->second;
+
+    Expansion result;
+    if (auto recipe = getRecipe(db, barcode)) {
+        double weight = 0.0;
+        for (const RecipeItem& item : recipe->items) weight += item.grams;
+        if (recipe->yieldGrams > 0.0) weight = recipe->yieldGrams;
+        for (const RecipeItem& item : recipe->items) {
+            for (const auto& leaf : expand(db, item.barcode, memo)) {
+                result[leaf.first] += leaf.second * item.grams / weight;
+            }
+        }
+    } else {
+        result[barcode] = 1.0;
+    }
+    return memo[barcode] = std::move(result);
+}
+
+} // namespace
+
+// Builds `depth` levels of `width` recipes, each made of `fanout` items from
+// the level below (level 0 uses plain foods), then logs three top-level meals
+// a day for `days` days: once as recipes, once expanded into their plain
+// ingredients as a user would log them without recipes. Finally changes one
+// plain food and compares the incremental recipe refresh with recomputing all.
+int runRecipeBench(int argc, char** argv) {
+    const int depth = argc > 0 ? std::atoi(argv[0]) : 8;
+    const int width = argc > 1 ? std::atoi(argv[1]) : 50;
+    const int fanout = argc > 2 ? std::atoi(argv[2]) : 4;
+    const int days = argc > 3 ? std::atoi(argv[3]) : 365;
+    const std::string path = "bench_recipes.db";
+
+    removeDb(path);
+    OpenProfile profile = throughputProfile();
+    profile.verbose = false;
+    DatabaseManager db(path, profile);
+    if (!db.open() || !db.createTables()) return 1;
+
+    db.beginTransaction();
+    for (int i = 0; i < kLeaves; ++i) {
+        db.addFood(Food{ leafBarcode(i), "Ingredient " + std::to_string(i), 20.0 + i % 400, 1.0 + i % 20,
+                         2.0 + i % 50, 0.5 + i % 30 });
+    }
+    db.commit();
+
+    BenchRng rng(20);
+    BenchTimer create;
+    db.beginTransaction();
+    for (int level = 0; level < depth; ++level) {
+        for (int i = 0; i < width; ++i) {
+            Recipe recipe;
+            recipe.barcode = recipeBarcode(level, i);
+            recipe.name = "Recipe " + std::to_string(level) + "." + std::to_string(i);
+            for (int k = 0; k < fanout; ++k) {
+                const std::string item = level == 0 ? leafBarcode(static_cast<int>(rng.below(kLeaves)))
+                                                    : recipeBarcode(level - 1, static_cast<int>(rng.below(width)));
+                recipe.items.push_back(RecipeItem{ item, 20.0 + rng.below(200) });
+            }
+            if (!addRecipe(db, recipe)) return 1;
+        }
+    }
+    db.commit();
+    printRate("addRecipe", static_cast<long long>(depth) * width, create.seconds());
+
+    // Meals come from the top level; their expansions are what a user without
+    // recipes would have to log item by item.
+    std::map<std::string, Expansion> memo;
+    std::vector<std::string> meals;
+    size_t expandedItems = 0;
+    for (int i = 0; i < width; ++i) {
+        meals.push_back(recipeBarcode(depth - 1, i));
+        expandedItems += expand(db, meals.back(), memo).size();
+    }
+    std::cout << depth << " levels x " << width << " recipes, fanout " << fanout << "; a top-level meal expands to "
+              << expandedItems / meals.size() << " plain foods on average\n";
+
+    const Date recipeStart = Date::fromYmd(2024, 1, 1);
+    const Date expandedStart = recipeStart + days;
+    std::vector<std::string> dayMeals;
+    for (int i = 0; i < days * kMealsPerDay; ++i) dayMeals.push_back(meals[rng.below(meals.size())]);
+
+    BenchTimer logRecipes;
+    db.beginTransaction();
+    for (int i = 0; i < days * kMealsPerDay; ++i) {
+        db.logFoodForDate(recipeStart + i / kMealsPerDay, dayMeals[i], 350.0);
+    }
+    db.commit();
+    printRate("log meals as recipes (logFoodForDate)", days * kMealsPerDay, logRecipes.seconds());
+
+    BenchTimer logExpanded;
+    long long expandedRows = 0;
+    db.beginTransaction();
+    for (int i = 0; i < days * kMealsPerDay; ++i) {
+        for (const auto& leaf : memo[dayMeals[i]]) {
+            db.logFoodForDate(expandedStart + i / kMealsPerDay, leaf.first, 350.0 * leaf.second);
+            ++expandedRows;
+        }
+    }
+    db.commit();
+    const double expandedSeconds = logExpanded.seconds();
+    printRate("log meals expanded (logFoodForDate)", days * kMealsPerDay, expandedSeconds);
+    std::cout << "  " << expandedRows << " rows\n";
+
+    // Both layouts must report the same nutrition.
+    const DailyTotals recipeDay = db.getDailyTotals(recipeStart + days / 2);
+    const DailyTotals expandedDay = db.getDailyTotals(expandedStart + days / 2);
+    std::cout << "same day, recipes vs expanded: " << recipeDay.calories << " vs " << expandedDay.calories
+              << " kcal\n";
+
+    for (const auto& range : { std::make_pair("recipes", recipeStart), std::make_pair("expanded", expandedStart) }) {
+        BenchTimer entries;
+        size_t rows = 0;
+        for (int d = 0; d < days; ++d) rows += db.getEntriesForDate(range.second + d).size();
+        printRate(std::string("getEntriesForDate, ") + range.first, days, entries.seconds());
+        std::cout << "  " << rows << " entries\n";
+
+        BenchTimer totals;
+        const int reps = 100;
+        for (int r = 0; r < reps; ++r) db.getDailyTotalsRange(range.second, range.second + (days - 1));
+        printRate(std::string("getDailyTotalsRange (one year), ") + range.first, reps, totals.seconds());
+    }
+
+    // One plain food changes: only the recipes above it are recomputed. The
+    // baseline reverts the change and recomputes every recipe.
+    const std::string changed = leafBarcode(static_cast<int>(rng.below(kLeaves)));
+    const std::string bump = "UPDATE foods SET calories_per_100g = calories_per_100g + 10 WHERE barcode = '" +
+                             changed + "';";
+    const std::string revert = "UPDATE foods SET calories_per_100g = calories_per_100g - 10 WHERE barcode = '" +
+                               changed + "';";
+
+    BenchTimer incremental;
+    db.beginTransaction();
+    sqlite3_exec(db.handle(), bump.c_str(), nullptr, nullptr, nullptr);
+    const int affected = refreshRecipes(db);
+    db.commit();
+    std::cout << "ingredient change, incremental refresh: " << affected << " recipes in "
+              << incremental.seconds() * 1e3 << " ms\n";
+
+    BenchTimer full;
+    db.beginTransaction();
+    sqlite3_exec(db.handle(), revert.c_str(), nullptr, nullptr, nullptr);
+    sqlite3_exec(db.handle(), "UPDATE recipes SET dirty = 1;", nullptr, nullptr, nullptr);
+    const int all = refreshRecipes(db);
+    db.commit();
+    std::cout << "ingredient change, full recompute: " << all << " recipes in " << full.seconds() * 1e3 << " ms\n";
+
+    db.close();
+    removeDb(path);
+    return 0;
+}
@@ -0,0 +1,88 @@
+#include "Bench.h"
+#include "DataGenerator.h"
+#include "ReportEngine.h"
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+
+// Generates `users` small user databases (copies of a handful of templates of
+// different sizes, so the per-job work is uneven) and runs the full report over
+// them with increasing thread counts.
+int runReportBench(int argc, char** argv) {
+    const long long users = argc > 0 ? std::atoll(argv[0]) : 1000;
+    const long long logsPerUser = argc > 1 ? std::atoll(argv[1]) : 2000;
+    const std::string dir = "bench_reports";
+    const std::string outPath = "bench_reports.out";
+    const int templateCount = 8;
+
+    std::error_code ec;
+    std::filesystem::remove_all(dir, ec);
+    std::filesystem::create_directory(dir);
+
+    BenchTimer genTimer;
+    std::vector<std::string> templates;
+    for (int t = 0; t < templateCount; ++t) {
+        const std::string path = dir + "/template_" + std::to_string(t) + ".db";
+        OpenProfile profile = throughputProfile();
+        profile.verbose = false;
+        DatabaseManager db(path, profile);
+        if (!db.open() || !db.createTables()) return 1;
+
+        GeneratorSpec spec;
+        spec.foods = 500;
+        spec.logs = logsPerUser / 4 + logsPerUser * t / 4;   // 0.25x .. 2x the average
+        spec.seed = 100 + t;
+        GeneratedData data;
+        if (!generateDatabase(db, spec, data)) return 1;
+        db.setDailyGoal(1800 + 100 * t);
+        templates.push_back(path);
+    }
+
+    std::vector<ReportJob> jobs;
+    for (long long u = 0; u < users; ++u) {
+        char name[32];
+        std::snprintf(name, sizeof(name), "user_%05lld", u);
+        const std::string path = dir + "/" + name + ".db";
+        std::filesystem::copy_file(templates[u % templateCount], path, ec);
+        if (ec) {
+            std::cerr << "copy failed: " << ec.message() << "\n";
+            return 1;
+        }
+        jobs.push_back(ReportJob{ name, path, Date::fromYmd(2025, 1, 1), Date::fromYmd(2025, 12, 31) });
+    }
+    std::cout << "generated " << users << " user databases in " << genTimer.seconds() << " s\n";
+
+    const size_t hardware = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<size_t> threadCounts = { 1, 2, 4, 8 };
+    if (hardware > 8) threadCounts.push_back(hardware);
+
+    ReportOptions options;
+    {
+        // Warm the OS page cache so the first measured run is not the only cold one.
+        std::ofstream out(outPath, std::ios::binary);
+        options.threads = hardware;
+        runReports(jobs, options, out);
+    }
+
+    for (ReportFormat format : { ReportFormat::Csv, ReportFormat::Json }) {
+        options.format = format;
+        for (size_t threads : threadCounts) {
+            options.threads = threads;
+            std::ofstream out(outPath, std::ios::binary);
+            ReportRunStats stats = runReports(jobs, options, out);
+            out.close();
+
+            std::cout << (format == ReportFormat::Csv ? "csv " : "json") << " threads=" << threads << ": "
+                      << stats.jobs / stats.seconds << " users/s, " << stats.rowsWritten / stats.seconds
+                      << " rows/s, " << stats.steals << " steals, " << stats.failed << " failed, "
+                      << std::filesystem::file_size(outPath, ec) << " bytes\n";
+        }
+    }
+    std::cout << "(" << hardware << " hardware threads)\n";
+
+    std::filesystem::remove_all(dir, ec);
+    std::remove(outPath.c_str());
+    return 0;
+}
@@ -0,0 +1,57 @@
+#include "Bench.h"
+#include "DatabaseManager.h"
+#include <cstdio>
+#include <cstdlib>
+
+// A multi-year report: one getNutritionSeries call versus one
+// getTotalCaloriesForDate call per day.
+int runSeriesBench(int argc, char** argv) {
+    const int years = argc > 0 ? std::atoi(argv[0]) : 3;
+    const int perDay = argc > 1 ? std::atoi(argv[1]) : 5;
+    const int rounds = 20;
+    const std::string dbPath = "bench_series.db";
+
+    std::remove(dbPath.c_str());
+    DatabaseManager db(dbPath, throughputProfile());
+    if (!db.open() || !db.createTables()) return 1;
+
+    std::vector<Date> dates;
+    for (int d = 0; d < years * 365; ++d) dates.push_back(Date::fromYmd(2020, 1, 1) + d);
+
+    db.beginTransaction();
+    for (int i = 0; i < 100; ++i) {
+        db.addFood(Food{ std::to_string(9000000 + i), "Food " + std::to_string(i), 80.0 + i, 5, 15, 4 });
+    }
+    for (size_t d = 0; d < dates.size(); ++d) {
+        for (int e = 0; e < perDay; ++e) {
+            db.logFoodForDate(dates[d], std::to_string(9000000 + (d * 7 + e) % 100), 120);
+        }
+    }
+    db.commit();
+
+    double checksum = 0.0;
+
+    BenchTimer loop;
+    for (int r = 0; r < rounds; ++r) {
+        for (Date date : dates) checksum += db.getTotalCaloriesForDate(date);
+    }
+    printRate("per-date getTotalCaloriesForDate loop (reports)", rounds, loop.seconds());
+
+    BenchTimer ranged;
+    for (int r = 0; r < rounds; ++r) {
+        NutritionSeries s = db.getNutritionSeries(dates.front(), dates.back());
+        std::vector<double> daily = toDailyValues(s, s.calories, static_cast<int>(dates.size()));
+        std::vector<double> avg = rollingAverage(daily, 7);
+        std::vector<double> delta = goalDeltas(s.calories, 2000.0);
+        checksum += avg.back() + delta.front() + longestStreakWithinGoal(s, 2000.0);
+    }
+    printRate("getNutritionSeries + analytics (reports)", rounds, ranged.seconds());
+
+    std::cout << dates.size() << " days per report, checksum " << checksum << "\n";
+
+    db.close();
+    std::remove(dbPath.c_str());
+    std::remove((dbPath + "-wal").c_str());
+    std::remove((dbPath + "-shm").c_str());
+    return 0;
+}
@@ -0,0 +1,95 @@
+#include "Bench.h"
+#include "CatalogSnapshot.h"
+#include "DatabaseManager.h"
+#include "FoodImporter.h"
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+
+namespace {
+
+void removeDb(const std::string& path) {
+    std::remove(path.c_str());
+    std::remove((path + "-wal").c_str());
+    std::remove((path + "-shm").c_str());
+}
+
+} // namespace
+
+// Exports a synthetic catalog to a snapshot and compares random barcode
+// lookups through SQLite with lookups against the mapped file.
+int runSnapshotBench(int argc, char** argv) {
+    const long long foodCount = argc > 0 ? std::atoll(argv[0]) : 1000000;
+    const long long lookups = argc > 1 ? std::atoll(argv[1]) : 1000000;
+    const std::string dbPath = "bench_snapshot.db";
+    const std::string csvPath = "bench_snapshot.csv";
+    const std::string snapPath = "bench_snapshot.snap";
+
+    removeDb(dbPath);
+    {
+        std::ofstream out(csvPath, std::ios::binary);
+        for (long long i = 0; i < foodCount; ++i) {
+            out << (4006381000000LL + i * 7) << ",Snapshot food " << i << "," << (50 + i % 500) << ","
+                << (i % 30) << "," << (i % 70) << "," << (i % 40) << "\n";
+        }
+    }
+
+    OpenProfile profile = throughputProfile();
+    profile.verbose = false;
+    DatabaseManager db(dbPath, profile);
+    if (!db.open() || !db.createTables()) return 1;
+    FoodImporter importer(db);
+    if (!importer.importFile(csvPath, ImportOptions()).completed) return 1;
+    std::remove(csvPath.c_str());
+
+    SnapshotExportStats exported;
+    BenchTimer exportTimer;
+    if (!CatalogSnapshot::write(db.handle(), snapPath, exported)) return 1;
+    std::cout << "export: " << exported.foods << " foods, " << exported.bytes << " bytes in "
+              << exportTimer.seconds() << " s\n";
+
+    CatalogSnapshot snapshot;
+    BenchTimer openTimer;
+    if (!snapshot.open(snapPath)) return 1;
+    std::cout << "open (map + header check): " << openTimer.seconds() * 1e6 << " us\n";
+
+    BenchTimer verifyTimer;
+    bool intact = snapshot.verify();
+    std::cout << "verify (full CRC-32): " << (intact ? "ok" : "FAILED") << " in " << verifyTimer.seconds() << " s\n";
+
+    std::vector<std::string> probes;
+    probes.reserve(static_cast<size_t>(lookups));
+    uint64_t state = 7;
+    for (long long i = 0; i < lookups; ++i) {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        long long n = static_cast<long long>((state >> 33) % static_cast<uint64_t>(foodCount));
+        // Every eighth probe misses.
+        probes.push_back(std::to_string(4006381000000LL + n * 7 + (i % 8 == 0 ? 3 : 0)));
+    }
+
+    long long found = 0;
+    BenchTimer sqlTimer;
+    for (const std::string& b : probes) {
+        if (db.getFoodByBarcode(b)) ++found;
+    }
+    printRate("getFoodByBarcode via SQLite", lookups, sqlTimer.seconds());
+
+    long long mapped = 0;
+    double checksum = 0;
+    BenchTimer snapTimer;
+    for (const std::string& b : probes) {
+        if (auto view = snapshot.find(b)) {
+            ++mapped;
+            checksum += view->calories_per_100g + static_cast<double>(view->name.size());
+        }
+    }
+    printRate("CatalogSnapshot::find (zero copy)", lookups, snapTimer.seconds());
+    std::cout << "hits: sqlite " << found << ", snapshot " << mapped << " (checksum " << checksum << ")\n";
+
+    snapshot.close();
+    db.close();
+    std::remove(snapPath.c_str());
+    removeDb(dbPath);
+    return intact && found == mapped ? 0 : 1;
+}
@@ -0,0 +1,86 @@
+#include "Bench.h"
+#include "DatabaseManager.h"
+#include <cstdlib>
+#include <string>
+
+// The pre-cache code path: prepare, bind, step and finalize on every call.
+static bool lookupUncached(sqlite3* db, const std::string& barcode, Food& out) {
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db,
+            "SELECT barcode, name, calories_per_100g, protein, carbs, fat "
+            "FROM foods WHERE barcode = ?;", -1, &stmt, nullptr) != SQLITE_OK) {
+        return false;
+    }
+
+    sqlite3_bind_text(stmt, 1, barcode.c_str(), -1, SQLITE_TRANSIENT);
+
+    bool found = false;
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        out.barcode = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+        out.name = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
+        out.calories_per_100g = sqlite3_column_double(stmt, 2);
+        out.protein = sqlite3_column_double(stmt, 3);
+        out.carbs = sqlite3_column_double(stmt, 4);
+        out.fat = sqlite3_column_double(stmt, 5);
+        found = true;
+    }
+
+    sqlite3_finalize(stmt);
+    return found;
+}
+
+int runStatementCacheBench(int argc, char** argv) {
+    const int foods = 1000;
+    const long long calls = argc > 0 ? std::atoll(argv[0]) : 200000;
+
+    DatabaseManager db(":memory:");
+    if (!db.open() || !db.createTables()) return 1;
+
+    for (int i = 0; i < foods; ++i) {
+        Food f{ std::to_string(100000 + i), "Food " + std::to_string(i), 100.0 + i, 5.0, 10.0, 2.0 };
+        db.addFood(f);
+    }
+
+    // A second connection is not possible for :memory:, so the uncached path
+    // opens its own copy of the same catalog.
+    sqlite3* raw = nullptr;
+    sqlite3_open(":memory:", &raw);
+    sqlite3_exec(raw,
+        "CREATE TABLE foods (id INTEGER PRIMARY KEY AUTOINCREMENT, barcode TEXT UNIQUE NOT NULL, "
+        "name TEXT NOT NULL, calories_per_100g REAL NOT NULL, protein REAL, carbs REAL, fat REAL);",
+        nullptr, nullptr, nullptr);
+    sqlite3_exec(raw, "BEGIN;", nullptr, nullptr, nullptr);
+    for (int i = 0; i < foods; ++i) {
+        std::string sql = "INSERT INTO foods (barcode, name, calories_per_100g, protein, carbs, fat) VALUES ('"
+            + std::to_string(100000 + i) + "', 'Food " + std::to_string(i) + "', 100, 5, 10, 2);";
+        sqlite3_exec(raw, sql.c_str(), nullptr, nullptr, nullptr);
+    }
+    sqlite3_exec(raw, "COMMIT;", nullptr, nullptr, nullptr);
+
+    std::string barcode;
+    long long hits = 0;
+
+    BenchTimer before;
+    for (long long i = 0; i < calls; ++i) {
+        barcode = std::to_string(100000 + i % foods);
+        Food f;
+        if (lookupUncached(raw, barcode, f)) ++hits;
+    }
+    printRate("getFoodByBarcode (prepare per call)", calls, before.seconds());
+
+    BenchTimer after;
+    for (long long i = 0; i < calls; ++i) {
+        barcode = std::to_string(100000 + i % foods);
+        if (db.getFoodByBarcode(barcode)) ++hits;
+    }
+    printRate("getFoodByBarcode (cached statement)", calls, after.seconds());
+
+    BenchTimer totals;
+    for (long long i = 0; i < calls; ++i) {
+        db.getTotalCaloriesForDate("2026-01-01");
+    }
+    printRate("getTotalCaloriesForDate (cached statement)", calls, totals.seconds());
+
+    sqlite3_close(raw);
+    return hits == 2 * calls ? 0 : 1;
+}
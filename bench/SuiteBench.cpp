@@ -0,0 +1,165 @@
+#include "Bench.h"
+#include "BenchReport.h"
+#include "DataGenerator.h"
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+
+namespace {
+
+void removeDb(const std::string& path) {
+    std::remove(path.c_str());
+    std::remove((path + "-wal").c_str());
+    std::remove((path + "-shm").c_str());
+}
+
+// Times `ops` calls of fn(i) individually and records throughput and latency.
+template <typename Fn>
+BenchResult measure(const std::string& name, long long ops, Fn fn) {
+    std::vector<double> micros;
+    micros.reserve(static_cast<size_t>(ops));
+
+    BenchTimer total;
+    for (long long i = 0; i < ops; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        fn(i);
+        micros.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+    }
+
+    BenchResult r;
+    r.name = name;
+    r.ops = ops;
+    r.seconds = total.seconds();
+    r.p50Us = percentile(micros, 50);
+    r.p99Us = percentile(micros, 99);
+    std::cerr << "  " << name << ": " << static_cast<long long>(r.opsPerSecond()) << " ops/sec, p50 "
+              << r.p50Us << " us, p99 " << r.p99Us << " us\n";
+    return r;
+}
+
+// A fresh, generated database for one benchmark phase.
+struct Fixture {
+    Fixture(const std::string& path, const GeneratorSpec& spec, OpenProfile profile) : db(path, profile) {
+        removeDb(path);
+        ok = db.open() && db.createTables() && generateDatabase(db, spec, data);
+    }
+
+    DatabaseManager db;
+    GeneratedData data;
+    bool ok = false;
+};
+
+} // namespace
+
+// Repeatable microbenchmarks for every DatabaseManager operation against a
+// generated database, reported as JSON (stdout, or the given file) so runs
+// on different commits can be compared. Progress goes to stderr.
+int runSuiteBench(int argc, char** argv) {
+    GeneratorSpec spec;
+    if (argc > 0) spec.foods = std::atoll(argv[0]);
+    if (argc > 1) spec.logs = std::atoll(argv[1]);
+    if (argc > 2) spec.days = std::atoi(argv[2]);
+    const std::string outPath = argc > 3 ? argv[3] : "";
+    const long long pointOps = 20000;
+    const long long rangeOps = 2000;
+    const std::string dbPath = "bench_suite.db";
+
+    if (spec.foods <= 0 || spec.days <= 0 || spec.logs < 0) {
+        std::cerr << "foods and days must be positive\n";
+        return 1;
+    }
+
+    OpenProfile profile = throughputProfile();
+    profile.verbose = false;
+
+    BenchReport report("calorie_bench suite");
+    report.setConfig("foods", spec.foods);
+    report.setConfig("logs", spec.logs);
+    report.setConfig("days", spec.days);
+    report.setConfig("seed", static_cast<long long>(spec.seed));
+
+    std::cerr << "generating " << spec.foods << " foods, " << spec.logs << " logs over " << spec.days << " days\n";
+    BenchTimer genTimer;
+    Fixture main(dbPath, spec, profile);
+    if (!main.ok) return 1;
+    {
+        BenchResult gen;
+        gen.name = "generate";
+        gen.ops = spec.foods + spec.logs;
+        gen.seconds = genTimer.seconds();
+        report.add(gen);
+    }
+
+    DatabaseManager& db = main.db;
+    const GeneratedData& data = main.data;
+    const long long foodCount = static_cast<long long>(data.barcodes.size());
+    BenchRng rng(spec.seed + 1);
+    auto randomBarcode = [&]() -> const std::string& { return data.barcodes[rng.below(foodCount)]; };
+    auto randomDay = [&] { return data.firstDay + static_cast<int>(rng.below(data.days)); };
+
+    // Reads.
+    report.add(measure("getFoodByBarcode.hit", pointOps, [&](long long) { db.getFoodByBarcode(randomBarcode()); }));
+    report.add(measure("getFoodByBarcode.miss", pointOps, [&](long long i) {
+        db.getFoodByBarcode("999" + std::to_string(i));
+    }));
+    report.add(measure("findFoodId", pointOps, [&](long long) { db.findFoodId(randomBarcode()); }));
+    report.add(measure("getEntriesForDate", rangeOps, [&](long long) { db.getEntriesForDate(randomDay()); }));
+    report.add(measure("getTotalCaloriesForDate", pointOps, [&](long long) { db.getTotalCaloriesForDate(randomDay()); }));
+    report.add(measure("getDailyTotals", pointOps, [&](long long) { db.getDailyTotals(randomDay()); }));
+    report.add(measure("getDailyTotalsRange.30d", rangeOps, [&](long long) {
+        Date from = randomDay();
+        db.getDailyTotalsRange(from, from + 29);
+    }));
+    report.add(measure("getNutritionSeries.all", rangeOps / 10, [&](long long) {
+        db.getNutritionSeries(data.firstDay, data.firstDay + (data.days - 1));
+    }));
+    report.add(measure("searchFoodsByName", rangeOps, [&](long long i) {
+        db.searchFoodsByName(i % 2 ? "chick" : "apple oat", 10);
+    }));
+    report.add(measure("getDailyGoal", pointOps, [&](long long) { db.getDailyGoal(); }));
+
+    // Writes, each in its own autocommit transaction as the UI issues them.
+    report.add(measure("setDailyGoal", rangeOps, [&](long long i) { db.setDailyGoal(1800.0 + i % 400); }));
+    report.add(measure("addFood", rangeOps, [&](long long i) {
+        db.addFood({ std::to_string(9000000000000LL + i), "Bench food " + std::to_string(i), 120, 5, 10, 3 });
+    }));
+    report.add(measure("logFoodForDate", rangeOps, [&](long long) {
+        db.logFoodForDate(randomDay(), randomBarcode(), 150);
+    }));
+    report.add(measure("rebuildDailyTotals", 5, [&](long long) { db.rebuildDailyTotals(); }));
+    main.db.close();
+
+    // Destructive operations, each on its own freshly generated database.
+    const std::string scratchPath = "bench_suite_scratch.db";
+    struct Destructive {
+        const char* name;
+        bool (DatabaseManager::*run)();
+    };
+    const Destructive destructive[] = {
+        { "clearAllLogs", &DatabaseManager::clearAllLogs },
+        { "clearAllFoods", &DatabaseManager::clearAllFoods },
+        { "factoryReset", &DatabaseManager::factoryReset },
+    };
+    for (const Destructive& d : destructive) {
+        Fixture scratch(scratchPath, spec, profile);
+        if (!scratch.ok) return 1;
+        report.add(measure(d.name, 1, [&](long long) { (scratch.db.*d.run)(); }));
+        scratch.db.close();
+        removeDb(scratchPath);
+    }
+
+    removeDb(dbPath);
+
+    if (outPath.empty()) {
+        report.writeJson(std::cout);
+    } else {
+        std::ofstream out(outPath);
+        report.writeJson(out);
+        if (!out) {
+            std::cerr << "Cannot write " << outPath << "\n";
+            return 1;
+        }
+        std::cerr << "wrote " << outPath << "\n";
+    }
+    return 0;
+}
@@ -0,0 +1,121 @@
+#include "Bench.h"
+#include "DataGenerator.h"
+#include "DatabaseManager.h"
+#include "Sync.h"
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+
+namespace {
+
+void removeDb(const std::string& path) {
+    std::remove(path.c_str());
+    std::remove((path + "-wal").c_str());
+    std::remove((path + "-shm").c_str());
+}
+
+const int kFoods = 5000;
+const int kDays = 730;
+
+Date dateFor(int day) {
+    return Date::fromYmd(2024, 1, 1) + day;
+}
+
+long long fileBytes(const std::string& path) {
+    std::error_code ec;
+    auto size = std::filesystem::file_size(path, ec);
+    return ec ? 0 : static_cast<long long>(size);
+}
+
+void logRows(DatabaseManager& db, BenchRng& rng, long long count) {
+    db.beginTransaction();
+    for (long long i = 0; i < count; ++i) {
+        db.insertLogRow(dateFor(static_cast<int>(rng.below(kDays))), 1 + static_cast<long long>(rng.below(kFoods)),
+                        50.0 + rng.below(200));
+    }
+    db.commit();
+}
+
+bool syncDelta(DatabaseManager& device, DatabaseManager& hub, const std::string& changesetPath, const char* label) {
+    BenchTimer exportTimer;
+    SyncStats delta = exportChanges(device, changesetPath, "hub");
+    const double exportSeconds = exportTimer.seconds();
+    BenchTimer applyTimer;
+    SyncStats applied = applyChanges(hub, changesetPath, "device");
+    const double applySeconds = applyTimer.seconds();
+
+    std::cout << "  delta, " << label << " (" << delta.logRowsSent << " rows, " << delta.foodsSent
+              << " foods): export " << exportSeconds * 1e3 << " ms, apply " << applySeconds * 1e3
+              << " ms, changeset " << fileBytes(changesetPath) / 1024 << " KiB\n";
+    return delta.completed && applied.completed;
+}
+
+} // namespace
+
+// Grows a device database from 10k log rows up to `maxRows` (x10 each step).
+// At every size the hub first catches up, then the device logs `changes` rows
+// and edits changes / 10 foods, each delta exported and applied to the hub:
+// the cost of new rows should stay flat while the database grows.
+int runSyncBench(int argc, char** argv) {
+    const long long maxRows = argc > 0 ? std::atoll(argv[0]) : 1000000;
+    const long long changes = argc > 1 ? std::atoll(argv[1]) : 1000;
+    const std::string devicePath = "bench_sync_device.db";
+    const std::string hubPath = "bench_sync_hub.db";
+    const std::string changesetPath = "bench_sync.changeset";
+
+    removeDb(devicePath);
+    removeDb(hubPath);
+    OpenProfile profile = throughputProfile();
+    profile.verbose = false;
+    DatabaseManager device(devicePath, profile);
+    DatabaseManager hub(hubPath, profile);
+    if (!device.open() || !device.createTables() || !hub.open() || !hub.createTables()) return 1;
+
+    device.beginTransaction();
+    for (int i = 0; i < kFoods; ++i) {
+        device.addFood(Food{ std::to_string(8000000 + i), "Sync food " + std::to_string(i), 50.0 + i % 300, 4, 12, 3 });
+    }
+    device.commit();
+
+    BenchRng rng(21);
+    long long rows = 0;
+    for (long long target = 10000; target <= maxRows; target *= 10) {
+        logRows(device, rng, target - rows);
+        rows = target;
+
+        BenchTimer catchUp;
+        SyncStats full = exportChanges(device, changesetPath, "hub");
+        SyncStats fullApply = applyChanges(hub, changesetPath, "device");
+        if (!full.completed || !fullApply.completed) return 1;
+        std::cout << rows << " rows (" << (fileBytes(devicePath) + fileBytes(devicePath + "-wal")) / 1024
+                  << " KiB): catch-up of " << full.logRowsSent << " rows, " << full.foodsSent << " foods in "
+                  << catchUp.seconds() << " s\n";
+
+        logRows(device, rng, changes);
+        rows += changes;
+        if (!syncDelta(device, hub, changesetPath, "new log rows")) return 1;
+
+        // An edited food also moves the hub's daily totals on every day it was
+        // logged, so this part grows with the foods' history.
+        device.beginTransaction();
+        for (long long i = 0; i < changes / 10; ++i) {
+            auto food = device.getFoodByBarcode(std::to_string(8000000 + rng.below(kFoods)));
+            food->calories_per_100g += 1.0;
+            device.updateFood(*food);
+        }
+        device.commit();
+        if (!syncDelta(device, hub, changesetPath, "edited foods")) return 1;
+    }
+
+    const DailyTotals a = device.getDailyTotals(dateFor(kDays / 2));
+    const DailyTotals b = hub.getDailyTotals(dateFor(kDays / 2));
+    std::cout << "same day, device vs hub: " << a.calories << " vs " << b.calories << " kcal, " << a.entries
+              << " vs " << b.entries << " entries\n";
+
+    device.close();
+    hub.close();
+    removeDb(devicePath);
+    removeDb(hubPath);
+    std::remove(changesetPath.c_str());
+    return 0;
+}
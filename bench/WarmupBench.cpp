@@ -0,0 +1,135 @@
+#include "Bench.h"
+#include "CatalogWarmup.h"
+#include "DataGenerator.h"
+#include "DatabaseManager.h"
+#include "FoodImporter.h"
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <thread>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+void removeDb(const std::string& path) {
+    std::remove(path.c_str());
+    std::remove((path + "-wal").c_str());
+    std::remove((path + "-shm").c_str());
+}
+
+// Asks the OS to drop the file's cached pages so the next open reads from
+// disk, as on the first run after boot. Linux only; elsewhere runs stay warm.
+bool dropFromPageCache(const std::string& path) {
+#ifdef __linux__
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    ::fdatasync(fd);
+    bool ok = ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED) == 0;
+    ::close(fd);
+    return ok;
+#else
+    (void)path;
+    return false;
+#endif
+}
+
+std::string barcodeOf(long long i) { return std::to_string(4006381000000LL + i * 7); }
+
+struct StartupRun {
+    double promptSeconds = 0.0;
+    double firstLookupUs = 0.0;
+    std::vector<double> lookupUs;
+};
+
+// Opens the catalog as main() does, then looks up `barcodes`, the first of
+// them timed on its own. With `warm`, the warm-up is started before the
+// prompt and the lookups wait `waitForWarm` until it has finished.
+bool startup(const std::string& path, const std::vector<std::string>& barcodes, bool warm, bool waitForWarm,
+             StartupRun& run) {
+    OpenProfile profile = throughputProfile();
+    profile.verbose = false;
+    BenchTimer prompt;
+    DatabaseManager db(path, profile);
+    if (!db.open() || !db.createTables()) return false;
+    if (warm && !db.startCatalogWarmup()) return false;
+    run.promptSeconds = prompt.seconds();
+
+    if (waitForWarm) {
+        while (!db.catalogWarmup()->ready()) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        std::cout << "  warmed " << db.catalogWarmup()->foods() << " foods in " << db.catalogWarmup()->seconds()
+                  << " s\n";
+    }
+
+    bool found = true;
+    for (size_t i = 0; i < barcodes.size(); ++i) {
+        BenchTimer lookup;
+        found = db.getFoodByBarcode(barcodes[i]).has_value() && found;
+        const double us = lookup.seconds() * 1e6;
+        if (i == 0) run.firstLookupUs = us;
+        else run.lookupUs.push_back(us);
+    }
+    return found;
+}
+
+void report(const char* label, StartupRun& run) {
+    std::cout << label << ": prompt after " << run.promptSeconds * 1e3 << " ms, first lookup "
+              << run.firstLookupUs << " us, next " << run.lookupUs.size() << " lookups p50 "
+              << percentile(run.lookupUs, 50) << " us, p99 " << percentile(run.lookupUs, 99) << " us\n";
+}
+
+} // namespace
+
+// Imports a catalog of `foods` foods, then starts up against it three times
+// with the file dropped from the OS page cache before each: without warm-up,
+// with warm-up and an immediate first scan, and with warm-up waited for.
+// Each run looks up `lookups` random barcodes.
+int runWarmupBench(int argc, char** argv) {
+    const long long foodCount = argc > 0 ? std::atoll(argv[0]) : 1000000;
+    const int lookups = argc > 1 ? std::atoi(argv[1]) : 1000;
+    const std::string dbPath = "bench_warmup.db";
+    const std::string csvPath = "bench_warmup.csv";
+
+    removeDb(dbPath);
+    {
+        std::ofstream out(csvPath, std::ios::binary);
+        for (long long i = 0; i < foodCount; ++i) {
+            out << barcodeOf(i) << ",Warm-up food " << i << "," << (50 + i % 500) << "," << (i % 30) << ","
+                << (i % 70) << "," << (i % 40) << "\n";
+        }
+    }
+    {
+        OpenProfile profile = throughputProfile();
+        profile.verbose = false;
+        DatabaseManager db(dbPath, profile);
+        if (!db.open() || !db.createTables()) return 1;
+        FoodImporter importer(db);
+        if (!importer.importFile(csvPath, ImportOptions()).completed) return 1;
+    }
+    std::remove(csvPath.c_str());
+
+    BenchRng rng(23);
+    std::vector<std::string> barcodes;
+    for (int i = 0; i < lookups; ++i) barcodes.push_back(barcodeOf(static_cast<long long>(rng.below(foodCount))));
+
+    if (!dropFromPageCache(dbPath)) std::cout << "(cannot drop the OS page cache here; runs start warm)\n";
+    StartupRun cold;
+    if (!startup(dbPath, barcodes, false, false, cold)) return 1;
+    report("cold", cold);
+
+    dropFromPageCache(dbPath);
+    StartupRun scanEarly;
+    if (!startup(dbPath, barcodes, true, false, scanEarly)) return 1;
+    report("warm-up started, scanning at once", scanEarly);
+
+    dropFromPageCache(dbPath);
+    StartupRun warmed;
+    if (!startup(dbPath, barcodes, true, true, warmed)) return 1;
+    report("warm-up finished", warmed);
+
+    removeDb(dbPath);
+    return 0;
+}
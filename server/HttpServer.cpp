@@ -0,0 +1,631 @@
+#include "HttpServer.h"
+#include "DatabaseManager.h"
+#include "Gtin.h"
+#include "Json.h"
+#include "Metrics.h"
+#include <arpa/inet.h>
+#include <cctype>
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <sstream>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+
+const size_t maxHeaderBytes = 16 * 1024;
+const size_t maxBodyBytes = 1024 * 1024;
+
+const char* reasonPhrase(int status) {
+    switch (status) {
+        case 200: return "OK";
+        case 201: return "Created";
+        case 400: return "Bad Request";
+        case 404: return "Not Found";
+        case 405: return "Method Not Allowed";
+        case 409: return "Conflict";
+        case 413: return "Payload Too Large";
+        default: return "Internal Server Error";
+    }
+}
+
+std::string makeResponse(int status, const std::string& body, bool keepAlive,
+                         const char* contentType = "application/json") {
+    std::string r;
+    r.reserve(128 + body.size());
+    r += "HTTP/1.1 ";
+    r += std::to_string(status);
+    r += ' ';
+    r += reasonPhrase(status);
+    r += "\r\nContent-Type: ";
+    r += contentType;
+    r += "\r\nContent-Length: ";
+    r += std::to_string(body.size());
+    r += keepAlive ? "\r\nConnection: keep-alive\r\n\r\n" : "\r\nConnection: close\r\n\r\n";
+    r += body;
+    return r;
+}
+
+std::string errorBody(const char* message) {
+    std::string body = "{\"error\":";
+    appendJsonString(body, message);
+    body += '}';
+    return body;
+}
+
+void appendNumber(std::string& out, double value) {
+    char buf[32];
+    auto res = std::to_chars(buf, buf + sizeof(buf), value);
+    out.append(buf, res.ptr);
+}
+
+std::string queryParam(const std::string& query, std::string_view key) {
+    size_t pos = 0;
+    while (pos <= query.size()) {
+        size_t amp = query.find('&', pos);
+        if (amp == std::string::npos) amp = query.size();
+        std::string_view pair(query.data() + pos, amp - pos);
+        size_t eq = pair.find('=');
+        if (eq != std::string_view::npos && pair.substr(0, eq) == key) {
+            return std::string(pair.substr(eq + 1));
+        }
+        pos = amp + 1;
+    }
+    return {};
+}
+
+// Decodes %XX escapes in a request path; false on a malformed escape.
+bool percentDecode(std::string_view in, std::string& out) {
+    out.clear();
+    for (size_t i = 0; i < in.size(); ++i) {
+        if (in[i] != '%') {
+            out.push_back(in[i]);
+            continue;
+        }
+        unsigned value = 0;
+        if (i + 2 >= in.size() ||
+            std::from_chars(in.data() + i + 1, in.data() + i + 3, value, 16).ptr != in.data() + i + 3) {
+            return false;
+        }
+        out.push_back(static_cast<char>(value));
+        i += 2;
+    }
+    return true;
+}
+
+bool toDouble(const std::string* s, double& out) {
+    if (!s || s->empty()) return false;
+    auto res = std::from_chars(s->data(), s->data() + s->size(), out);
+    return res.ec == std::errc() && res.ptr == s->data() + s->size();
+}
+
+bool iequals(std::string_view a, std::string_view b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (std::tolower(static_cast<unsigned char>(a[i])) != std::tolower(static_cast<unsigned char>(b[i]))) return false;
+    }
+    return true;
+}
+
+// Parses one request from the front of `in`. Returns 1 when a request was
+// consumed, 0 when more bytes are needed and -1 on a malformed request.
+int parseRequest(std::string& in, HttpRequest& req) {
+    size_t headerEnd = in.find("\r\n\r\n");
+    if (headerEnd == std::string::npos) {
+        return in.size() > maxHeaderBytes ? -1 : 0;
+    }
+
+    std::string_view head(in.data(), headerEnd);
+    size_t lineEnd = head.find("\r\n");
+    std::string_view requestLine = head.substr(0, lineEnd);
+
+    size_t sp1 = requestLine.find(' ');
+    size_t sp2 = requestLine.rfind(' ');
+    if (sp1 == std::string_view::npos || sp2 == sp1) return -1;
+
+    std::string_view target = requestLine.substr(sp1 + 1, sp2 - sp1 - 1);
+    std::string_view version = requestLine.substr(sp2 + 1);
+
+    req.method = std::string(requestLine.substr(0, sp1));
+    size_t q = target.find('?');
+    req.path = std::string(target.substr(0, q));
+    req.query = q == std::string_view::npos ? std::string() : std::string(target.substr(q + 1));
+    req.keepAlive = version == "HTTP/1.1";
+
+    size_t contentLength = 0;
+    size_t pos = lineEnd == std::string_view::npos ? head.size() : lineEnd + 2;
+    while (pos < head.size()) {
+        size_t next = head.find("\r\n", pos);
+        if (next == std::string_view::npos) next = head.size();
+        std::string_view line = head.substr(pos, next - pos);
+        pos = next + 2;
+
+        size_t colon = line.find(':');
+        if (colon == std::string_view::npos) continue;
+        std::string_view name = line.substr(0, colon);
+        std::string_view value = line.substr(colon + 1);
+        while (!value.empty() && value.front() == ' ') value.remove_prefix(1);
+
+        if (iequals(name, "Content-Length")) {
+            auto res = std::from_chars(value.data(), value.data() + value.size(), contentLength);
+            if (res.ec != std::errc() || contentLength > maxBodyBytes) return -1;
+        } else if (iequals(name, "Connection")) {
+            if (iequals(value, "close")) req.keepAlive = false;
+            else if (iequals(value, "keep-alive")) req.keepAlive = true;
+        }
+    }
+
+    size_t total = headerEnd + 4 + contentLength;
+    if (in.size() < total) return 0;
+
+    req.body.assign(in, headerEnd + 4, contentLength);
+    in.erase(0, total);
+    return 1;
+}
+
+void appendFood(std::string& out, const Food& f) {
+    out += "{\"barcode\":";
+    appendJsonString(out, f.barcode);
+    out += ",\"name\":";
+    appendJsonString(out, f.name);
+    out += ",\"calories_per_100g\":";
+    appendNumber(out, f.calories_per_100g);
+    out += ",\"protein\":";
+    appendNumber(out, f.protein);
+    out += ",\"carbs\":";
+    appendNumber(out, f.carbs);
+    out += ",\"fat\":";
+    appendNumber(out, f.fat);
+    out += '}';
+}
+
+Date localToday() {
+    std::time_t t = std::time(nullptr);
+    std::tm local{};
+    localtime_r(&t, &local);
+    return Date::fromYmd(local.tm_year + 1900, local.tm_mon + 1, local.tm_mday);
+}
+
+} // namespace
+
+std::string handleRequest(DatabaseManager& db, const HttpRequest& req) {
+    const bool keep = req.keepAlive;
+    std::vector<std::pair<std::string, std::string>> fields;
+
+    if (req.path.compare(0, 7, "/foods/") == 0 && req.method == "GET") {
+        std::string barcode;
+        if (!percentDecode(std::string_view(req.path).substr(7), barcode)) {
+            return makeResponse(400, errorBody("malformed barcode in path"), keep);
+        }
+        auto food = db.getFoodByBarcode(barcode);
+        if (!food) return makeResponse(404, errorBody("food not found"), keep);
+        std::string body;
+        appendFood(body, *food);
+        return makeResponse(200, body, keep);
+    }
+
+    if (req.path == "/foods") {
+        if (req.method != "POST") return makeResponse(405, errorBody("use POST"), keep);
+        Food food{};
+        const std::string* barcode = nullptr;
+        const std::string* name = nullptr;
+        if (!parseFlatJsonObject(req.body, fields) ||
+            !(barcode = jsonField(fields, "barcode")) || !(name = jsonField(fields, "name")) ||
+            !toDouble(jsonField(fields, "calories_per_100g"), food.calories_per_100g)) {
+            return makeResponse(400, errorBody("expected {barcode, name, calories_per_100g, protein, carbs, fat}"), keep);
+        }
+        food.barcode = normalizeBarcode(*barcode);   // echo the stored form
+        food.name = *name;
+        toDouble(jsonField(fields, "protein"), food.protein);
+        toDouble(jsonField(fields, "carbs"), food.carbs);
+        toDouble(jsonField(fields, "fat"), food.fat);
+
+        if (!db.addFood(food)) {
+            if (db.lastWriteError() == WriteError::AlreadyExists) {
+                return makeResponse(409, errorBody("barcode already exists"), keep);
+            }
+            return makeResponse(500, errorBody("could not add food"), keep);
+        }
+        std::string body;
+        appendFood(body, food);
+        return makeResponse(201, body, keep);
+    }
+
+    if (req.path == "/log") {
+        if (req.method != "POST") return makeResponse(405, errorBody("use POST"), keep);
+        double grams = 0;
+        const std::string* date = nullptr;
+        const std::string* barcode = nullptr;
+        if (!parseFlatJsonObject(req.body, fields) ||
+            !(date = jsonField(fields, "date")) || !(barcode = jsonField(fields, "barcode")) ||
+            !toDouble(jsonField(fields, "grams"), grams)) {
+            return makeResponse(400, errorBody("expected {date, barcode, grams}"), keep);
+        }
+        auto day = Date::parse(*date);
+        if (!day) return makeResponse(400, errorBody("date must be YYYY-MM-DD"), keep);
+        if (!db.logFoodForDate(*day, *barcode, grams)) {
+            switch (db.lastWriteError()) {
+            case WriteError::DateOutOfRange:
+                return makeResponse(400, errorBody("date out of range"), keep);
+            case WriteError::NotFound:
+                return makeResponse(404, errorBody("unknown barcode"), keep);
+            default:
+                return makeResponse(500, errorBody("could not log food"), keep);
+            }
+        }
+        return makeResponse(201, "{\"logged\":true}", keep);
+    }
+
+    if (req.path == "/entries" || req.path == "/totals") {
+        if (req.method != "GET") return makeResponse(405, errorBody("use GET"), keep);
+        auto day = Date::parse(queryParam(req.query, "date"));
+        if (!day) return makeResponse(400, errorBody("date=YYYY-MM-DD is required"), keep);
+
+        std::string body = "{\"date\":";
+        appendJsonString(body, day->toString());
+
+        if (req.path == "/entries") {
+            body += ",\"entries\":[";
+            bool first = true;
+            for (const auto& e : db.getEntriesForDate(*day)) {
+                if (!first) body += ',';
+                first = false;
+                body += "{\"name\":";
+                appendJsonString(body, e.name);
+                body += ",\"barcode\":";
+                appendJsonString(body, e.barcode);
+                body += ",\"grams\":";
+                appendNumber(body, e.grams);
+                body += ",\"calories\":";
+                appendNumber(body, e.nutrients.calories());
+                body += ",\"protein\":";
+                appendNumber(body, e.nutrients.protein());
+                body += ",\"carbs\":";
+                appendNumber(body, e.nutrients.carbs());
+                body += ",\"fat\":";
+                appendNumber(body, e.nutrients.fat());
+                body += '}';
+            }
+            body += "]}";
+        } else {
+            DailyTotals t = db.getDailyTotals(*day);
+            body += ",\"calories\":";
+            appendNumber(body, t.calories);
+            body += ",\"protein\":";
+            appendNumber(body, t.protein);
+            body += ",\"carbs\":";
+            appendNumber(body, t.carbs);
+            body += ",\"fat\":";
+            appendNumber(body, t.fat);
+            body += ",\"entries\":";
+            body += std::to_string(t.entries);
+            body += '}';
+        }
+        return makeResponse(200, body, keep);
+    }
+
+    if (req.path == "/goal") {
+        if (req.method == "PUT" || req.method == "POST") {
+            double goal = 0;
+            if (!parseFlatJsonObject(req.body, fields) || !toDouble(jsonField(fields, "goal"), goal)) {
+                return makeResponse(400, errorBody("expected {goal}"), keep);
+            }
+            if (!db.setDailyGoal(goal)) return makeResponse(500, errorBody("could not save goal"), keep);
+        } else if (req.method != "GET") {
+            return makeResponse(405, errorBody("use GET or PUT"), keep);
+        }
+        std::string body = "{\"goal\":";
+        appendNumber(body, db.getDailyGoal());
+        body += '}';
+        return makeResponse(200, body, keep);
+    }
+
+    if (req.path == "/metrics" || req.path == "/stats") {
+        if (req.method != "GET") return makeResponse(405, errorBody("use GET"), keep);
+        std::ostringstream text;
+        if (req.path == "/metrics") writePrometheusText(text, collectMetrics());
+        else writeMetricsText(text, collectMetrics());
+        return makeResponse(200, text.str(), keep, "text/plain; version=0.0.4");
+    }
+
+    return makeResponse(404, errorBody("no such endpoint"), keep);
+}
+
+HttpServer::HttpServer(const ServerOptions& options)
+    : options(options) {}
+
+HttpServer::~HttpServer() {
+    stop();
+    for (auto& w : workers) {
+        if (w.joinable()) w.join();
+    }
+    for (auto& entry : connections) ::close(entry.first);
+    if (listenFd >= 0) ::close(listenFd);
+    if (epollFd >= 0) ::close(epollFd);
+    if (wakeFd >= 0) ::close(wakeFd);
+}
+
+bool HttpServer::start() {
+    {
+        // Run migrations and drop expired log months once, before workers race
+        // to open the file.
+        OpenProfile profile = throughputProfile();
+        profile.verbose = false;
+        DatabaseManager setup(options.dbPath, profile);
+        if (!setup.open() || !setup.createTables() || setup.applyLogRetention(localToday()) < 0) return false;
+    }
+
+    listenFd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listenFd < 0) {
+        std::cerr << "socket: " << std::strerror(errno) << "\n";
+        return false;
+    }
+
+    int one = 1;
+    ::setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(options.port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    if (::bind(listenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 || ::listen(listenFd, 512) < 0) {
+        std::cerr << "bind/listen on port " << options.port << ": " << std::strerror(errno) << "\n";
+        return false;
+    }
+
+    epollFd = ::epoll_create1(EPOLL_CLOEXEC);
+    wakeFd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epollFd < 0 || wakeFd < 0) return false;
+
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.fd = listenFd;
+    ::epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &ev);
+    ev.data.fd = wakeFd;
+    ::epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &ev);
+
+    for (int i = 0; i < options.workers; ++i) {
+        workers.emplace_back(&HttpServer::workerLoop, this);
+    }
+    return true;
+}
+
+void HttpServer::stop() {
+    stopping.store(true);
+    if (wakeFd >= 0) {
+        uint64_t one = 1;
+        ssize_t ignored = ::write(wakeFd, &one, sizeof(one));
+        (void)ignored;
+    }
+}
+
+void HttpServer::workerLoop() {
+    OpenProfile profile = throughputProfile();
+    profile.verbose = false;
+    DatabaseManager db(options.dbPath, profile);
+    bool opened = db.open();
+
+    while (true) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(jobMutex);
+            jobReady.wait(lock, [this] { return !jobs.empty() || stopping.load(); });
+            if (jobs.empty()) return;
+            job = std::move(jobs.front());
+            jobs.pop_front();
+        }
+
+        Completion done{ job.fd, job.generation, std::string(), job.request.keepAlive };
+        done.response = opened ? handleRequest(db, job.request)
+                               : makeResponse(500, errorBody("database unavailable"), done.keepAlive);
+
+        {
+            std::lock_guard<std::mutex> lock(completionMutex);
+            completions.push_back(std::move(done));
+        }
+        uint64_t one = 1;
+        ssize_t ignored = ::write(wakeFd, &one, sizeof(one));
+        (void)ignored;
+    }
+}
+
+void HttpServer::run() {
+    std::vector<epoll_event> events(256);
+
+    while (!stopping.load()) {
+        int n = ::epoll_wait(epollFd, events.data(), static_cast<int>(events.size()), 1000);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            std::cerr << "epoll_wait: " << std::strerror(errno) << "\n";
+            break;
+        }
+
+        for (int i = 0; i < n; ++i) {
+            int fd = events[i].data.fd;
+            uint32_t what = events[i].events;
+
+            if (fd == listenFd) {
+                acceptConnections();
+                continue;
+            }
+            if (fd == wakeFd) {
+                uint64_t count = 0;
+                ssize_t ignored = ::read(wakeFd, &count, sizeof(count));
+                (void)ignored;
+                drainCompletions();
+                continue;
+            }
+
+            auto it = connections.find(fd);
+            if (it == connections.end()) continue;
+
+            if (what & (EPOLLERR | EPOLLHUP)) {
+                closeConnection(fd);
+                continue;
+            }
+            if (what & EPOLLIN) {
+                onReadable(it->second);
+                it = connections.find(fd);
+                if (it == connections.end()) continue;
+            }
+            if (what & EPOLLOUT) {
+                flush(it->second);
+            }
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(jobMutex);
+        stopping.store(true);
+    }
+    jobReady.notify_all();
+    for (auto& w : workers) {
+        if (w.joinable()) w.join();
+    }
+}
+
+void HttpServer::acceptConnections() {
+    while (true) {
+        int fd = ::accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) return;   // EAGAIN, or a transient error; try again on the next event
+
+        int one = 1;
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+        Connection& conn = connections[fd];
+        conn = Connection{};
+        conn.fd = fd;
+        conn.generation = nextGeneration++;
+
+        epoll_event ev{};
+        ev.events = EPOLLIN | EPOLLRDHUP;
+        ev.data.fd = fd;
+        ::epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev);
+    }
+}
+
+void HttpServer::onReadable(Connection& conn) {
+    char buf[64 * 1024];
+    while (true) {
+        ssize_t got = ::read(conn.fd, buf, sizeof(buf));
+        if (got > 0) {
+            conn.in.append(buf, static_cast<size_t>(got));
+            if (static_cast<size_t>(got) < sizeof(buf)) break;
+            continue;
+        }
+        if (got == 0) {
+            // Half-close: the peer may still be waiting for responses to what it sent.
+            conn.peerClosed = true;
+            updateEvents(conn);
+            break;
+        }
+        if (errno == EINTR) continue;
+        if (errno != EAGAIN && errno != EWOULDBLOCK) {
+            // A response still in flight is dropped by its generation check.
+            closeConnection(conn.fd);
+            return;
+        }
+        break;
+    }
+
+    dispatchNext(conn);
+}
+
+void HttpServer::dispatchNext(Connection& conn) {
+    if (conn.busy || conn.closeAfterWrite) return;   // one request in flight keeps responses in order
+
+    HttpRequest req;
+    int parsed = parseRequest(conn.in, req);
+    if (parsed == 0) {
+        if (conn.peerClosed) {
+            conn.in.clear();   // an incomplete request can no longer complete
+            if (conn.out.empty()) closeConnection(conn.fd);
+        }
+        return;
+    }
+    if (parsed < 0) {
+        conn.out += makeResponse(400, errorBody("malformed request"), false);
+        conn.closeAfterWrite = true;
+        flush(conn);
+        return;
+    }
+
+    conn.busy = true;
+    {
+        std::lock_guard<std::mutex> lock(jobMutex);
+        jobs.push_back(Job{ conn.fd, conn.generation, std::move(req) });
+    }
+    jobReady.notify_one();
+}
+
+void HttpServer::drainCompletions() {
+    std::vector<Completion> ready;
+    {
+        std::lock_guard<std::mutex> lock(completionMutex);
+        ready.swap(completions);
+    }
+
+    for (Completion& c : ready) {
+        auto it = connections.find(c.fd);
+        if (it == connections.end() || it->second.generation != c.generation) continue;   // client went away
+
+        Connection& conn = it->second;
+        conn.busy = false;
+        conn.out += c.response;
+        if (!c.keepAlive) conn.closeAfterWrite = true;
+
+        int fd = conn.fd;
+        flush(conn);
+        auto again = connections.find(fd);
+        if (again != connections.end()) dispatchNext(again->second);
+    }
+}
+
+void HttpServer::flush(Connection& conn) {
+    while (conn.outSent < conn.out.size()) {
+        ssize_t sent = ::send(conn.fd, conn.out.data() + conn.outSent, conn.out.size() - conn.outSent, MSG_NOSIGNAL);
+        if (sent > 0) {
+            conn.outSent += static_cast<size_t>(sent);
+            continue;
+        }
+        if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            watchWrite(conn, true);
+            return;
+        }
+        closeConnection(conn.fd);
+        return;
+    }
+
+    conn.out.clear();
+    conn.outSent = 0;
+    watchWrite(conn, false);
+
+    if (!conn.busy && (conn.closeAfterWrite || (conn.peerClosed && conn.in.empty()))) closeConnection(conn.fd);
+}
+
+void HttpServer::watchWrite(Connection& conn, bool enable) {
+    if (conn.watchingWrite == enable) return;
+    conn.watchingWrite = enable;
+    updateEvents(conn);
+}
+
+void HttpServer::updateEvents(Connection& conn) {
+    epoll_event ev{};
+    ev.events = (conn.peerClosed ? 0u : EPOLLIN | EPOLLRDHUP) | (conn.watchingWrite ? EPOLLOUT : 0u);
+    ev.data.fd = conn.fd;
+    ::epoll_ctl(epollFd, EPOLL_CTL_MOD, conn.fd, &ev);
+}
+
+void HttpServer::closeConnection(int fd) {
+    ::epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+    ::close(fd);
+    connections.erase(fd);
+}
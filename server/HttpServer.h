@@ -0,0 +1,105 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+struct ServerOptions {
+    std::string dbPath = "../data/calories.db";
+    uint16_t port = 8080;
+    int workers = 4;
+};
+
+struct HttpRequest {
+    std::string method;
+    std::string path;
+    std::string query;
+    std::string body;
+    bool keepAlive = true;
+};
+
+class DatabaseManager;
+
+// HTTP/1.1 JSON front end for DatabaseManager, bound to 127.0.0.1.
+//
+// One thread runs an epoll loop that accepts connections and parses requests;
+// a fixed pool of workers, each with its own SQLite connection, executes them
+// and hands the responses back through an eventfd. Connections are keep-alive
+// and pipelined requests are answered in order, one in flight per connection.
+//
+//   GET  /foods/<barcode>       POST /foods   {barcode, name, calories_per_100g, protein, carbs, fat}
+//   POST /log   {date, barcode, grams}
+//   GET  /entries?date=YYYY-MM-DD
+//   GET  /totals?date=YYYY-MM-DD
+//   GET  /goal                  PUT  /goal    {goal}
+//   GET  /metrics (Prometheus text)   GET /stats (readable dump)
+class HttpServer {
+public:
+    explicit HttpServer(const ServerOptions& options);
+    ~HttpServer();
+
+    bool start();   // bind, migrate the schema and start the workers
+    void run();     // event loop; returns after stop()
+    void stop();    // safe to call from a signal handler
+
+private:
+    struct Job {
+        int fd;
+        uint64_t generation;
+        HttpRequest request;
+    };
+
+    struct Completion {
+        int fd;
+        uint64_t generation;
+        std::string response;
+        bool keepAlive;
+    };
+
+    struct Connection {
+        int fd = -1;
+        uint64_t generation = 0;
+        std::string in;
+        std::string out;
+        size_t outSent = 0;
+        bool busy = false;
+        bool closeAfterWrite = false;
+        bool peerClosed = false;   // EOF read; answer what was received, then close
+        bool watchingWrite = false;
+    };
+
+    void workerLoop();
+    void acceptConnections();
+    void onReadable(Connection& conn);
+    void dispatchNext(Connection& conn);
+    void flush(Connection& conn);
+    void drainCompletions();
+    void closeConnection(int fd);
+    void watchWrite(Connection& conn, bool enable);
+    void updateEvents(Connection& conn);
+
+    ServerOptions options;
+    int listenFd = -1;
+    int epollFd = -1;
+    int wakeFd = -1;
+    std::atomic<bool> stopping{ false };
+    uint64_t nextGeneration = 1;
+
+    std::unordered_map<int, Connection> connections;
+
+    std::vector<std::thread> workers;
+    std::mutex jobMutex;
+    std::condition_variable jobReady;
+    std::deque<Job> jobs;
+
+    std::mutex completionMutex;
+    std::vector<Completion> completions;
+};
+
+// Routes one request to the database; returns the full HTTP response.
+std::string handleRequest(DatabaseManager& db, const HttpRequest& request);
@@ -0,0 +1,93 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "JsonEscape.h"
+
+// Just enough JSON for the server's request bodies: one flat object whose values
+// are strings, numbers, booleans or null. Values are returned as their text,
+// strings with their escapes decoded (\uXXXX and surrogate pairs to UTF-8);
+// unknown escapes and lone surrogates make the body invalid.
+inline bool parseFlatJsonObject(std::string_view s, std::vector<std::pair<std::string, std::string>>& fields) {
+    size_t pos = 0;
+    auto skipWs = [&] { while (pos < s.size() && (s[pos] == ' ' || s[pos] == '\t' || s[pos] == '\r' || s[pos] == '\n')) ++pos; };
+    auto readString = [&](std::string& out) {
+        if (pos >= s.size() || s[pos] != '"') return false;
+        ++pos;
+        out.clear();
+        while (pos < s.size() && s[pos] != '"') {
+            char c = s[pos++];
+            if (c != '\\') {
+                out.push_back(c);
+                continue;
+            }
+            if (!decodeJsonEscape(s, pos, out)) return false;
+        }
+        if (pos >= s.size()) return false;
+        ++pos;
+        return true;
+    };
+
+    fields.clear();
+    skipWs();
+    if (pos >= s.size() || s[pos++] != '{') return false;
+
+    while (true) {
+        skipWs();
+        if (pos < s.size() && s[pos] == '}') return true;
+
+        std::string key, value;
+        if (!readString(key)) return false;
+        skipWs();
+        if (pos >= s.size() || s[pos++] != ':') return false;
+        skipWs();
+
+        if (pos < s.size() && s[pos] == '"') {
+            if (!readString(value)) return false;
+        } else {
+            size_t start = pos;
+            while (pos < s.size() && s[pos] != ',' && s[pos] != '}' && s[pos] != ' ' && s[pos] != '\n') {
+                if (s[pos] == '{' || s[pos] == '[') return false;
+                ++pos;
+            }
+            value.assign(s.data() + start, pos - start);
+        }
+        fields.emplace_back(std::move(key), std::move(value));
+
+        skipWs();
+        if (pos < s.size() && s[pos] == ',') { ++pos; continue; }
+        if (pos < s.size() && s[pos] == '}') return true;
+        return false;
+    }
+}
+
+inline const std::string* jsonField(const std::vector<std::pair<std::string, std::string>>& fields, std::string_view key) {
+    for (const auto& f : fields) {
+        if (f.first == key) return &f.second;
+    }
+    return nullptr;
+}
+
+inline void appendJsonString(std::string& out, std::string_view s) {
+    static const char hex[] = "0123456789abcdef";
+    out.push_back('"');
+    for (char c : s) {
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    out += "\\u00";
+                    out.push_back(hex[(c >> 4) & 0xF]);
+                    out.push_back(hex[c & 0xF]);
+                } else {
+                    out.push_back(c);
+                }
+        }
+    }
+    out.push_back('"');
+}
@@ -0,0 +1,158 @@
+#include "Bench.h"
+#include <arpa/inet.h>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+
+namespace {
+
+// One keep-alive client connection that sends a request and waits for the full response.
+class Client {
+public:
+    explicit Client(uint16_t port) {
+        fd = ::socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+            ::close(fd);
+            fd = -1;
+            return;
+        }
+        int one = 1;
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    }
+
+    ~Client() {
+        if (fd >= 0) ::close(fd);
+    }
+
+    bool ok() const { return fd >= 0; }
+
+    // Returns the HTTP status, or -1 on a transport error.
+    int request(const std::string& raw) {
+        if (::send(fd, raw.data(), raw.size(), MSG_NOSIGNAL) != static_cast<ssize_t>(raw.size())) return -1;
+
+        buffer.clear();
+        size_t headerEnd = std::string::npos;
+        size_t contentLength = 0;
+        char chunk[16 * 1024];
+
+        while (true) {
+            if (headerEnd == std::string::npos) {
+                headerEnd = buffer.find("\r\n\r\n");
+                if (headerEnd != std::string::npos) {
+                    size_t cl = buffer.find("Content-Length: ");
+                    if (cl == std::string::npos || cl > headerEnd) return -1;
+                    contentLength = std::strtoul(buffer.c_str() + cl + 16, nullptr, 10);
+                }
+            }
+            if (headerEnd != std::string::npos && buffer.size() >= headerEnd + 4 + contentLength) break;
+
+            ssize_t got = ::recv(fd, chunk, sizeof(chunk), 0);
+            if (got <= 0) return -1;
+            buffer.append(chunk, static_cast<size_t>(got));
+        }
+
+        return std::atoi(buffer.c_str() + 9);
+    }
+
+private:
+    int fd = -1;
+    std::string buffer;
+};
+
+std::string post(const std::string& path, const std::string& body) {
+    return "POST " + path + " HTTP/1.1\r\nHost: localhost\r\nContent-Type: application/json\r\nContent-Length: "
+        + std::to_string(body.size()) + "\r\n\r\n" + body;
+}
+
+std::string get(const std::string& path) {
+    return "GET " + path + " HTTP/1.1\r\nHost: localhost\r\n\r\n";
+}
+
+} // namespace
+
+// Drives a running calorie_server with 1, 4 and 16 keep-alive clients (or the
+// given counts) and reports requests/sec and latency percentiles for each.
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cout << "Usage: calorie_loadgen <port> [seconds per level] [clients...]\n";
+        return 1;
+    }
+
+    const uint16_t port = static_cast<uint16_t>(std::atoi(argv[1]));
+    const double seconds = argc > 2 ? std::atof(argv[2]) : 5.0;
+    std::vector<int> levels;
+    for (int i = 3; i < argc; ++i) levels.push_back(std::atoi(argv[i]));
+    if (levels.empty()) levels = { 1, 4, 16 };
+
+    const int foods = 500;
+    {
+        Client seed(port);
+        if (!seed.ok()) {
+            std::cerr << "Cannot connect to 127.0.0.1:" << port << "\n";
+            return 1;
+        }
+        for (int i = 0; i < foods; ++i) {
+            std::string body = "{\"barcode\":\"" + std::to_string(3000000 + i) + "\",\"name\":\"Load food " + std::to_string(i)
+                + "\",\"calories_per_100g\":" + std::to_string(50 + i % 300) + ",\"protein\":5,\"carbs\":10,\"fat\":2}";
+            seed.request(post("/foods", body));   // 409 on a re-run is fine
+        }
+    }
+
+    for (int clients : levels) {
+        std::atomic<bool> stop{ false };
+        std::atomic<long long> errors{ 0 };
+        std::vector<std::vector<double>> latencies(clients);
+        std::vector<std::thread> threads;
+
+        for (int c = 0; c < clients; ++c) {
+            threads.emplace_back([&, c] {
+                Client client(port);
+                if (!client.ok()) {
+                    ++errors;
+                    return;
+                }
+                long long i = c;
+                while (!stop.load(std::memory_order_relaxed)) {
+                    std::string date = "2026-03-" + std::string(i % 28 < 9 ? "0" : "") + std::to_string(1 + i % 28);
+                    std::string barcode = std::to_string(3000000 + (i * 13) % foods);
+                    std::string req;
+                    switch (i % 5) {
+                        case 0: req = post("/log", "{\"date\":\"" + date + "\",\"barcode\":\"" + barcode + "\",\"grams\":120}"); break;
+                        case 1: req = get("/foods/" + barcode); break;
+                        case 2: req = get("/entries?date=" + date); break;
+                        case 3: req = get("/totals?date=" + date); break;
+                        default: req = get("/goal"); break;
+                    }
+
+                    BenchTimer t;
+                    int status = client.request(req);
+                    latencies[c].push_back(t.seconds() * 1e6);
+                    if (status < 200 || status >= 300) ++errors;
+                    if (status < 0) return;
+                    i += clients;
+                }
+            });
+        }
+
+        std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+        stop = true;
+        for (auto& t : threads) t.join();
+
+        std::vector<double> all;
+        for (auto& l : latencies) all.insert(all.end(), l.begin(), l.end());
+        std::cout << clients << " client(s): ";
+        printRate("requests", static_cast<long long>(all.size()), seconds);
+        double p50 = percentile(all, 50), p90 = percentile(all, 90), p99 = percentile(all, 99);
+        std::cout << "  p50 " << p50 << " us, p90 " << p90 << " us, p99 " << p99 << " us, errors " << errors.load() << "\n";
+    }
+    return 0;
+}
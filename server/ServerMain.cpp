@@ -0,0 +1,40 @@
+#include "HttpServer.h"
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+static HttpServer* runningServer = nullptr;
+
+static void onSignal(int) {
+    if (runningServer) runningServer->stop();
+}
+
+int main(int argc, char** argv) {
+    ServerOptions options;
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i];
+        if (arg == "--db") options.dbPath = argv[i + 1];
+        else if (arg == "--port") options.port = static_cast<uint16_t>(std::atoi(argv[i + 1]));
+        else if (arg == "--workers") options.workers = std::atoi(argv[i + 1]);
+        else {
+            std::cerr << "Usage: calorie_server [--db <path>] [--port <port>] [--workers <n>]\n";
+            return 1;
+        }
+    }
+    if (options.workers < 1) options.workers = 1;
+
+    HttpServer server(options);
+    if (!server.start()) return 1;
+
+    runningServer = &server;
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+
+    std::cout << "Listening on http://127.0.0.1:" << options.port << " with "
+              << options.workers << " worker(s), database " << options.dbPath << std::endl;
+    server.run();
+    runningServer = nullptr;
+    return 0;
+}
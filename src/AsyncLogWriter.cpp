@@ -0,0 +1,211 @@
+#include "AsyncLogWriter.h"
+#include <algorithm>
+#include <chrono>
+#include <unordered_map>
+
+AsyncLogWriter::AsyncLogWriter(const std::string& dbPath, const AsyncLogOptions& options, const OpenProfile& profile)
+    : databasePath(dbPath), options(options), profile(profile) {
+    size_t capacity = 2;
+    while (capacity < options.queueCapacity) capacity <<= 1;
+
+    cells = std::make_unique<Cell[]>(capacity);
+    for (size_t i = 0; i < capacity; ++i) {
+        cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    mask = capacity - 1;
+}
+
+AsyncLogWriter::~AsyncLogWriter() {
+    stop();
+}
+
+bool AsyncLogWriter::start() {
+    if (writer.joinable()) return true;
+
+    // Opened on the caller's thread so failures are reported synchronously.
+    connection = std::make_unique<DatabaseManager>(databasePath, profile);
+    if (!connection->open() || !connection->createTables() ||
+        (!options.snapshotPath.empty() && !connection->attachSnapshot(options.snapshotPath))) {
+        connection.reset();
+        return false;
+    }
+
+    stopping.store(false);
+    writer = std::thread(&AsyncLogWriter::writerLoop, this);
+    running.store(true);
+    return true;
+}
+
+void AsyncLogWriter::stop() {
+    if (!writer.joinable()) return;
+    // New entries are refused from here on; the ones already being queued
+    // are waited for so the writer drains them.
+    running.store(false);
+    while (producers.load() != 0) std::this_thread::yield();
+    stopping.store(true);
+    {
+        std::lock_guard<std::mutex> lock(idleMutex);
+    }
+    wake.notify_one();
+    writer.join();
+    connection.reset();
+}
+
+std::future<bool> AsyncLogWriter::logFoodForDate(Date date, std::string barcode, double grams) {
+    Entry entry;
+    entry.date = date;
+    entry.barcode = std::move(barcode);
+    entry.grams = grams;
+    entry.promise.emplace();
+    std::future<bool> result = entry.promise->get_future();
+    enqueue(std::move(entry));
+    return result;
+}
+
+void AsyncLogWriter::logFoodForDate(Date date, std::string barcode, double grams, Callback done) {
+    Entry entry;
+    entry.date = date;
+    entry.barcode = std::move(barcode);
+    entry.grams = grams;
+    entry.callback = std::move(done);
+    enqueue(std::move(entry));
+}
+
+void AsyncLogWriter::enqueue(Entry&& entry) {
+    producers.fetch_add(1);
+    if (!running.load()) {
+        producers.fetch_sub(1);
+        if (entry.promise) entry.promise->set_value(false);
+        if (entry.callback) entry.callback(false);
+        return;
+    }
+
+    size_t pos = enqueuePos.load(std::memory_order_relaxed);
+    Cell* cell = nullptr;
+
+    while (true) {
+        cell = &cells[pos & mask];
+        size_t seq = cell->sequence.load(std::memory_order_acquire);
+        intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+
+        if (diff == 0) {
+            if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+        } else if (diff < 0) {
+            // Full: back off until the writer frees a slot.
+            std::this_thread::yield();
+            pos = enqueuePos.load(std::memory_order_relaxed);
+        } else {
+            pos = enqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+
+    cell->entry = std::move(entry);
+    cell->sequence.store(pos + 1, std::memory_order_release);
+
+    // Pairs with the fence in writerLoop: either the writer sees this entry
+    // before sleeping, or we see it idle and wake it.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (writerIdle.load(std::memory_order_relaxed)) {
+        std::lock_guard<std::mutex> lock(idleMutex);
+        wake.notify_one();
+    }
+    producers.fetch_sub(1);
+}
+
+bool AsyncLogWriter::tryDequeue(Entry& out) {
+    Cell& cell = cells[dequeuePos & mask];
+    size_t seq = cell.sequence.load(std::memory_order_acquire);
+    if (static_cast<intptr_t>(seq) - static_cast<intptr_t>(dequeuePos + 1) < 0) return false;
+
+    out = std::move(cell.entry);
+    cell.entry = Entry();
+    cell.sequence.store(dequeuePos + mask + 1, std::memory_order_release);
+    ++dequeuePos;
+    return true;
+}
+
+bool AsyncLogWriter::queueHasEntry() const {
+    const Cell& cell = cells[dequeuePos & mask];
+    return cell.sequence.load(std::memory_order_acquire) == dequeuePos + 1;
+}
+
+void AsyncLogWriter::writerLoop() {
+    using clock = std::chrono::steady_clock;
+
+    const size_t batchLimit = options.flushEveryEntries > 0 ? options.flushEveryEntries : 1;
+    const auto interval = std::chrono::milliseconds(options.flushIntervalMs);
+    std::vector<Entry> batch;
+    batch.reserve(batchLimit);
+    clock::time_point oldest;
+    Entry entry;
+
+    while (true) {
+        bool received = false;
+        while (batch.size() < batchLimit && tryDequeue(entry)) {
+            if (batch.empty()) oldest = clock::now();
+            batch.push_back(std::move(entry));
+            received = true;
+        }
+
+        const bool draining = stopping.load();
+        const bool full = batch.size() >= batchLimit;
+        const bool due = !batch.empty() && clock::now() - oldest >= interval;
+
+        if (full || due || (draining && !batch.empty())) {
+            commitBatch(batch);
+            batch.clear();
+            continue;
+        }
+        if (draining && !queueHasEntry()) break;
+        if (received) continue;
+
+        // Nothing new: sleep until a producer wakes us or the pending batch is due.
+        auto timeout = batch.empty() ? interval
+            : std::chrono::duration_cast<std::chrono::milliseconds>(interval - (clock::now() - oldest));
+        std::unique_lock<std::mutex> lock(idleMutex);
+        writerIdle.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!queueHasEntry() && !stopping.load()) {
+            wake.wait_for(lock, timeout);
+        }
+        writerIdle.store(false, std::memory_order_relaxed);
+    }
+}
+
+void AsyncLogWriter::commitBatch(std::vector<Entry>& batch) {
+    std::vector<char> ok(batch.size(), 0);
+    bool inTransaction = connection->beginTransaction();
+
+    if (inTransaction) {
+        // Each distinct barcode is resolved once per batch.
+        std::unordered_map<std::string, std::optional<long long>> foodIds;
+        for (size_t i = 0; i < batch.size(); ++i) {
+            auto found = foodIds.find(batch[i].barcode);
+            if (found == foodIds.end()) {
+                found = foodIds.emplace(batch[i].barcode, connection->findFoodId(batch[i].barcode)).first;
+            }
+            if (found->second) {
+                ok[i] = connection->insertLogRow(batch[i].date, *found->second, batch[i].grams);
+            } else if (connection->catalogSnapshot()) {
+                // Copies the food from the snapshot, which later entries then find.
+                ok[i] = connection->logFoodForDate(batch[i].date, batch[i].barcode, batch[i].grams);
+                if (ok[i]) found->second = connection->findFoodId(batch[i].barcode);
+            }
+        }
+
+        if (!connection->commit()) {
+            connection->rollback();
+            std::fill(ok.begin(), ok.end(), 0);
+        }
+    }
+
+    uint64_t written = 0;
+    for (size_t i = 0; i < batch.size(); ++i) {
+        if (ok[i]) ++written;
+        if (batch[i].promise) batch[i].promise->set_value(ok[i] != 0);
+        if (batch[i].callback) batch[i].callback(ok[i] != 0);
+    }
+
+    committed.fetch_add(written, std::memory_order_relaxed);
+    batches.fetch_add(1, std::memory_order_relaxed);
+}
@@ -0,0 +1,88 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+#include "DatabaseManager.h"
+
+struct AsyncLogOptions {
+    size_t queueCapacity = 65536;      // rounded up to a power of two
+    size_t flushEveryEntries = 512;    // commit once this many entries are pending...
+    int flushIntervalMs = 10;          // ...or once the oldest pending entry is this old
+    std::string snapshotPath;          // catalog snapshot for the writer's connection, if any
+};
+
+// Group-commit front end for logFoodForDate. Callers enqueue entries on a bounded
+// lock-free multi-producer queue and get a future (or callback) that resolves
+// once the entry's transaction commits. A single writer thread, on its own
+// connection, drains the queue, resolves each distinct barcode once per batch
+// and commits the whole batch in one transaction. Barcodes missing from foods
+// fall back to `snapshotPath` as DatabaseManager::logFoodForDate does.
+class AsyncLogWriter {
+public:
+    using Callback = std::function<void(bool ok)>;
+
+    AsyncLogWriter(const std::string& dbPath, const AsyncLogOptions& options = AsyncLogOptions(),
+                   const OpenProfile& profile = OpenProfile());
+    ~AsyncLogWriter();
+
+    bool start();
+    // Commits everything already queued, then stops the writer thread.
+    void stop();
+
+    // Entries logged while the writer is not running resolve to false at once.
+    std::future<bool> logFoodForDate(Date date, std::string barcode, double grams);
+    void logFoodForDate(Date date, std::string barcode, double grams, Callback done);
+
+    uint64_t committedEntries() const { return committed.load(std::memory_order_relaxed); }
+    uint64_t committedBatches() const { return batches.load(std::memory_order_relaxed); }
+
+private:
+    struct Entry {
+        Date date;
+        std::string barcode;
+        double grams = 0.0;
+        std::optional<std::promise<bool>> promise;
+        Callback callback;
+    };
+
+    // Dmitry Vyukov's bounded MPMC ring, used here with a single consumer.
+    struct Cell {
+        std::atomic<size_t> sequence;
+        Entry entry;
+    };
+
+    void enqueue(Entry&& entry);
+    bool tryDequeue(Entry& out);
+    bool queueHasEntry() const;
+    void writerLoop();
+    void commitBatch(std::vector<Entry>& batch);
+
+    std::string databasePath;
+    AsyncLogOptions options;
+    OpenProfile profile;
+    std::unique_ptr<DatabaseManager> connection;   // used only by the writer thread
+
+    std::unique_ptr<Cell[]> cells;
+    size_t mask = 0;
+    alignas(64) std::atomic<size_t> enqueuePos{ 0 };
+    alignas(64) size_t dequeuePos = 0;
+
+    std::thread writer;
+    std::atomic<bool> running{ false };
+    std::atomic<int> producers{ 0 };   // enqueue calls that saw `running` set
+    std::atomic<bool> stopping{ false };
+    std::atomic<bool> writerIdle{ false };
+    std::mutex idleMutex;
+    std::condition_variable wake;
+
+    std::atomic<uint64_t> committed{ 0 };
+    std::atomic<uint64_t> batches{ 0 };
+};
@@ -0,0 +1,89 @@
+#include "BarcodeCache.h"
+#include "BarcodeKey.h"
+
+static uint64_t mixKey(uint64_t k) {
+    k ^= k >> 33;
+    k *= 0xff51afd7ed558ccdULL;
+    k ^= k >> 33;
+    k *= 0xc4ceb9fe1a85ec53ULL;
+    k ^= k >> 33;
+    return k;
+}
+
+BarcodeCache::BarcodeCache()
+    : slots(1024, Slot{ 0, 0 }) {}
+
+size_t BarcodeCache::findSlot(uint64_t key) const {
+    const size_t mask = slots.size() - 1;
+    size_t i = mixKey(key) & mask;
+    while (slots[i].key != 0 && slots[i].key != key) {
+        i = (i + 1) & mask;
+    }
+    return i;
+}
+
+const Food* BarcodeCache::find(const std::string& barcode) {
+    uint64_t key = 0;
+    if (packBarcode(barcode, key)) {
+        const Slot& slot = slots[findSlot(key)];
+        if (slot.key == key) {
+            ++hitCount;
+            return &records[slot.index];
+        }
+    } else {
+        auto it = textKeys.find(barcode);
+        if (it != textKeys.end()) {
+            ++hitCount;
+            return &records[it->second];
+        }
+    }
+
+    ++missCount;
+    return nullptr;
+}
+
+void BarcodeCache::put(const Food& food) {
+    uint64_t key = 0;
+    if (!packBarcode(food.barcode, key)) {
+        auto it = textKeys.find(food.barcode);
+        if (it != textKeys.end()) {
+            records[it->second] = food;
+        } else {
+            textKeys.emplace(food.barcode, static_cast<uint32_t>(records.size()));
+            records.push_back(food);
+        }
+        return;
+    }
+
+    // Keep the load factor at or below one half.
+    if ((records.size() + 1) * 2 > slots.size()) grow();
+
+    Slot& slot = slots[findSlot(key)];
+    if (slot.key == key) {
+        records[slot.index] = food;
+        return;
+    }
+
+    slot.key = key;
+    slot.index = static_cast<uint32_t>(records.size());
+    records.push_back(food);
+}
+
+void BarcodeCache::clear() {
+    slots.assign(1024, Slot{ 0, 0 });
+    records.clear();
+    textKeys.clear();
+}
+
+void BarcodeCache::reserve(size_t foods) {
+    records.reserve(foods);
+    while (foods * 2 > slots.size()) grow();
+}
+
+void BarcodeCache::grow() {
+    std::vector<Slot> old(slots.size() * 2, Slot{ 0, 0 });
+    old.swap(slots);
+    for (const Slot& s : old) {
+        if (s.key != 0) slots[findSlot(s.key)] = s;
+    }
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "DatabaseManager.h"
+
+// Read-through cache of foods keyed by barcode. Numeric barcodes live in an
+// open-addressing table of packed 64-bit keys; anything else falls back to a
+// string map. Records are stored contiguously and addressed by index.
+class BarcodeCache {
+public:
+    BarcodeCache();
+
+    const Food* find(const std::string& barcode);
+    void put(const Food& food);
+    void clear();
+    // Sizes the tables for `foods` records up front, for bulk loads.
+    void reserve(size_t foods);
+
+    size_t size() const { return records.size(); }
+    uint64_t hits() const { return hitCount; }
+    uint64_t misses() const { return missCount; }
+
+private:
+    struct Slot {
+        uint64_t key;       // 0 marks an empty slot
+        uint32_t index;
+    };
+
+    size_t findSlot(uint64_t key) const;
+    void grow();
+
+    std::vector<Slot> slots;
+    std::vector<Food> records;
+    std::unordered_map<std::string, uint32_t> textKeys;
+    uint64_t hitCount = 0;
+    uint64_t missCount = 0;
+};
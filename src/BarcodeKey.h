@@ -0,0 +1,19 @@
+#pragma once
+#include <cstdint>
+#include <string_view>
+
+// Packs a purely numeric barcode (EAN-8/13, UPC-A, GTIN-14, ...) into 64 bits:
+// the digit count in the top 5 bits and the numeric value below, so "0123" and
+// "123" stay distinct. Returns false for empty, non-numeric or over-long codes.
+inline bool packBarcode(std::string_view barcode, uint64_t& key) {
+    if (barcode.empty() || barcode.size() > 17) return false;
+
+    uint64_t value = 0;
+    for (char c : barcode) {
+        if (c < '0' || c > '9') return false;
+        value = value * 10 + static_cast<uint64_t>(c - '0');
+    }
+
+    key = (static_cast<uint64_t>(barcode.size()) << 59) | value;
+    return true;
+}
@@ -0,0 +1,260 @@
+#include "BatchRunner.h"
+#include "Recipes.h"
+#include <chrono>
+#include <charconv>
+#include <string>
+
+namespace {
+
+// Pops the next whitespace-separated token off the front of `rest`.
+std::string_view nextToken(std::string_view& rest) {
+    size_t start = rest.find_first_not_of(" \t");
+    if (start == std::string_view::npos) {
+        rest = {};
+        return {};
+    }
+    size_t stop = rest.find_first_of(" \t", start);
+    if (stop == std::string_view::npos) stop = rest.size();
+    std::string_view token = rest.substr(start, stop - start);
+    rest.remove_prefix(stop);
+    return token;
+}
+
+bool toDouble(std::string_view s, double& out) {
+    if (s.empty()) return false;
+    auto res = std::from_chars(s.data(), s.data() + s.size(), out);
+    return res.ec == std::errc() && res.ptr == s.data() + s.size();
+}
+
+std::string_view trimmed(std::string_view s) {
+    size_t start = s.find_first_not_of(" \t\r");
+    if (start == std::string_view::npos) return {};
+    size_t stop = s.find_last_not_of(" \t\r");
+    return s.substr(start, stop - start + 1);
+}
+
+// Parses "<barcode>:<grams>[,<barcode>:<grams>...]".
+bool parseRecipeItems(std::string_view s, std::vector<RecipeItem>& items) {
+    while (!s.empty()) {
+        size_t comma = s.find(',');
+        std::string_view item = s.substr(0, comma);
+        s = comma == std::string_view::npos ? std::string_view() : s.substr(comma + 1);
+
+        size_t colon = item.find(':');
+        RecipeItem parsed;
+        if (colon == 0 || colon == std::string_view::npos || !toDouble(item.substr(colon + 1), parsed.grams)) {
+            return false;
+        }
+        parsed.barcode = std::string(item.substr(0, colon));
+        items.push_back(std::move(parsed));
+    }
+    return !items.empty();
+}
+
+} // namespace
+
+BatchRunner::BatchRunner(DatabaseManager& db, std::ostream& out, const BatchOptions& options)
+    : database(db), out(out), options(options) {}
+
+BatchStats BatchRunner::run(std::istream& in) {
+    auto started = std::chrono::steady_clock::now();
+    std::string line;
+    long long lineNumber = 0;
+
+    while (std::getline(in, line)) {
+        ++lineNumber;
+        std::string_view cmd = trimmed(line);
+        if (cmd.empty() || cmd.front() == '#') continue;
+
+        ++stats.commands;
+        if (!execute(cmd, lineNumber)) ++stats.failed;
+    }
+
+    finishTransaction();
+    out.flush();
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    return stats;
+}
+
+bool BatchRunner::ensureTransaction() {
+    if (inTransaction) return true;
+    if (!database.beginTransaction()) return false;
+    inTransaction = true;
+    writesInTransaction = 0;
+    return true;
+}
+
+void BatchRunner::wroteOne(long long lineNumber) {
+    if (writesInTransaction++ == 0) firstWriteLine = lineNumber;
+    lastWriteLine = lineNumber;
+    if (writesInTransaction >= options.writesPerTransaction) finishTransaction();
+}
+
+void BatchRunner::finishTransaction() {
+    if (!inTransaction) return;
+    if (!database.commit()) {
+        // The "ok" lines already printed for this group did not happen, and
+        // the cache may hold foods they added or updated.
+        database.rollback();
+        database.invalidateBarcodeCache();
+        out << "error\t" << firstWriteLine << '-' << lastWriteLine << "\tcommit failed, " << writesInTransaction
+            << " writes rolled back\n";
+        stats.failed += writesInTransaction;
+    } else {
+        ++stats.transactions;
+    }
+    inTransaction = false;
+    writesInTransaction = 0;
+}
+
+void BatchRunner::fail(long long lineNumber, const char* message) {
+    out << "error\t" << lineNumber << '\t' << message << '\n';
+}
+
+bool BatchRunner::execute(std::string_view line, long long lineNumber) {
+    std::string_view rest = line;
+    std::string_view command = nextToken(rest);
+
+    if (command == "add") {
+        Food food{};
+        food.barcode = std::string(nextToken(rest));
+        if (!toDouble(nextToken(rest), food.calories_per_100g) ||
+            !toDouble(nextToken(rest), food.protein) ||
+            !toDouble(nextToken(rest), food.carbs) ||
+            !toDouble(nextToken(rest), food.fat)) {
+            fail(lineNumber, "usage: add <barcode> <kcal> <protein> <carbs> <fat> <name>");
+            return false;
+        }
+        food.name = std::string(trimmed(rest));
+        if (food.barcode.empty() || food.name.empty()) {
+            fail(lineNumber, "usage: add <barcode> <kcal> <protein> <carbs> <fat> <name>");
+            return false;
+        }
+
+        if (!ensureTransaction() || !database.addFood(food)) {
+            fail(lineNumber, database.lastWriteError() == WriteError::AlreadyExists ? "add failed (barcode already exists)"
+                                                                                     : "add failed");
+            return false;
+        }
+        out << "ok\tadd\t" << food.barcode << '\n';
+        wroteOne(lineNumber);
+        return true;
+    }
+
+    if (command == "update") {
+        Food food{};
+        food.barcode = std::string(nextToken(rest));
+        if (!toDouble(nextToken(rest), food.calories_per_100g) ||
+            !toDouble(nextToken(rest), food.protein) ||
+            !toDouble(nextToken(rest), food.carbs) ||
+            !toDouble(nextToken(rest), food.fat)) {
+            fail(lineNumber, "usage: update <barcode> <kcal> <protein> <carbs> <fat> <name>");
+            return false;
+        }
+        food.name = std::string(trimmed(rest));
+        if (food.barcode.empty() || food.name.empty()) {
+            fail(lineNumber, "usage: update <barcode> <kcal> <protein> <carbs> <fat> <name>");
+            return false;
+        }
+
+        if (!ensureTransaction() || !database.updateFood(food)) {
+            fail(lineNumber, "update failed (unknown barcode or a recipe?)");
+            return false;
+        }
+        out << "ok\tupdate\t" << food.barcode << '\n';
+        wroteOne(lineNumber);
+        return true;
+    }
+
+    if (command == "recipe") {
+        Recipe recipe;
+        recipe.barcode = std::string(nextToken(rest));
+        if (recipe.barcode.empty() || !parseRecipeItems(nextToken(rest), recipe.items)) {
+            fail(lineNumber, "usage: recipe <barcode> <barcode>:<grams>[,...] <name>");
+            return false;
+        }
+        recipe.name = std::string(trimmed(rest));
+        if (recipe.name.empty()) {
+            fail(lineNumber, "usage: recipe <barcode> <barcode>:<grams>[,...] <name>");
+            return false;
+        }
+
+        if (!ensureTransaction() || !addRecipe(database, recipe)) {
+            fail(lineNumber, "recipe failed (unknown ingredient or barcode exists?)");
+            return false;
+        }
+        auto food = database.getFoodByBarcode(recipe.barcode);
+        out << "ok\trecipe\t" << recipe.barcode << '\t' << (food ? food->calories_per_100g : 0.0) << '\n';
+        wroteOne(lineNumber);
+        return true;
+    }
+
+    if (command == "lookup") {
+        std::string barcode(nextToken(rest));
+        auto food = database.getFoodByBarcode(barcode);
+        if (!food) {
+            fail(lineNumber, "not found");
+            return false;
+        }
+        out << "ok\tlookup\t" << food->barcode << '\t' << food->name << '\t' << food->calories_per_100g
+            << '\t' << food->protein << '\t' << food->carbs << '\t' << food->fat << '\n';
+        return true;
+    }
+
+    if (command == "log") {
+        auto date = Date::parse(nextToken(rest));
+        std::string barcode(nextToken(rest));
+        double grams = 0;
+        if (!date || barcode.empty() || !toDouble(nextToken(rest), grams)) {
+            fail(lineNumber, "usage: log <YYYY-MM-DD> <barcode> <grams>");
+            return false;
+        }
+
+        if (!ensureTransaction() || !database.logFoodForDate(*date, barcode, grams)) {
+            const WriteError error = database.lastWriteError();
+            fail(lineNumber, error == WriteError::DateOutOfRange ? "log failed (date out of range)"
+                             : error == WriteError::NotFound     ? "log failed (unknown barcode)"
+                                                                 : "log failed");
+            return false;
+        }
+        out << "ok\tlog\t" << date->toString() << '\t' << barcode << '\t' << grams << '\n';
+        wroteOne(lineNumber);
+        return true;
+    }
+
+    if (command == "total") {
+        auto date = Date::parse(nextToken(rest));
+        if (!date) {
+            fail(lineNumber, "usage: total <YYYY-MM-DD>");
+            return false;
+        }
+        DailyTotals t = database.getDailyTotals(*date);
+        out << "ok\ttotal\t" << date->toString() << '\t' << t.calories << '\t' << t.protein
+            << '\t' << t.carbs << '\t' << t.fat << '\t' << t.entries << '\n';
+        return true;
+    }
+
+    if (command == "goal") {
+        std::string_view value = nextToken(rest);
+        if (value.empty()) {
+            out << "ok\tgoal\t" << database.getDailyGoal() << '\n';
+            return true;
+        }
+
+        double goal = 0;
+        if (!toDouble(value, goal)) {
+            fail(lineNumber, "usage: goal [kcal]");
+            return false;
+        }
+        if (!ensureTransaction() || !database.setDailyGoal(goal)) {
+            fail(lineNumber, "goal update failed");
+            return false;
+        }
+        out << "ok\tgoal\t" << goal << '\n';
+        wroteOne(lineNumber);
+        return true;
+    }
+
+    fail(lineNumber, "unknown command");
+    return false;
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include <istream>
+#include <ostream>
+#include <string_view>
+#include "DatabaseManager.h"
+
+struct BatchOptions {
+    long long writesPerTransaction = 1000;
+};
+
+struct BatchStats {
+    long long commands = 0;
+    long long failed = 0;
+    long long transactions = 0;
+    double seconds = 0.0;
+};
+
+// Executes newline-separated commands against one open connection:
+//
+//   add <barcode> <kcal> <protein> <carbs> <fat> <name...>
+//   update <barcode> <kcal> <protein> <carbs> <fat> <name...>
+//   recipe <barcode> <barcode>:<grams>[,<barcode>:<grams>...] <name...>
+//   lookup <barcode>
+//   log <YYYY-MM-DD> <barcode> <grams>
+//   total <YYYY-MM-DD>
+//   goal [kcal]
+//
+// Blank lines and lines starting with '#' are ignored. Writes are grouped into
+// transactions of up to writesPerTransaction commands. Each command prints one
+// tab-separated result line: "ok\t<command>\t..." or "error\t<line>\t<message>".
+// For writes, "ok" means applied and pending the group's commit. If that commit
+// fails, the group is rolled back and one more line follows:
+// "error\t<first line>-<last line>\tcommit failed, <n> writes rolled back".
+class BatchRunner {
+public:
+    BatchRunner(DatabaseManager& db, std::ostream& out, const BatchOptions& options = BatchOptions());
+
+    BatchStats run(std::istream& in);
+
+private:
+    bool execute(std::string_view line, long long lineNumber);
+    bool ensureTransaction();
+    void wroteOne(long long lineNumber);
+    void finishTransaction();
+    void fail(long long lineNumber, const char* message);
+
+    DatabaseManager& database;
+    std::ostream& out;
+    BatchOptions options;
+    BatchStats stats;
+    bool inTransaction = false;
+    long long writesInTransaction = 0;
+    long long firstWriteLine = 0;
+    long long lastWriteLine = 0;
+};
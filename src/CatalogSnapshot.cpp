@@ -0,0 +1,347 @@
+#include "CatalogSnapshot.h"
+#include "Crc32.h"
+#include "DatabaseManager.h"
+#include "Gtin.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+struct CatalogSnapshot::Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t recordSize;      // guards against layout drift between builds
+    uint64_t count;
+    uint64_t keysOffset;
+    uint64_t recordsOffset;
+    uint64_t stringsOffset;
+    uint64_t stringsSize;
+    uint32_t payloadCrc;      // everything after the header
+    uint32_t headerCrc;       // the header up to this field
+};
+
+struct CatalogSnapshot::Record {
+    double calories_per_100g;
+    double protein;
+    double carbs;
+    double fat;
+    uint32_t barcodeOffset;
+    uint32_t barcodeLength;
+    uint32_t nameOffset;
+    uint32_t nameLength;
+};
+
+namespace {
+
+const char kMagic[8] = { 'C', 'A', 'L', 'S', 'N', 'A', 'P', '1' };
+constexpr uint32_t kFormatVersion = 1;
+
+bool hostIsLittleEndian() {
+    const uint16_t one = 1;
+    unsigned char first = 0;
+    std::memcpy(&first, &one, 1);
+    return first == 1;
+}
+
+inline unsigned countTrailingZeros(uint64_t v) {
+#ifdef _MSC_VER
+    unsigned long index = 0;
+    _BitScanForward64(&index, v);
+    return static_cast<unsigned>(index);
+#else
+    return static_cast<unsigned>(__builtin_ctzll(v));
+#endif
+}
+
+// Places sorted[next...] into the implicit tree rooted at `node` (1-based BFS
+// order) by in-order traversal; returns the next unused sorted index.
+template <typename T>
+size_t fillEytzinger(const std::vector<T>& sorted, std::vector<T>& out, size_t next, size_t node) {
+    if (node >= out.size()) return next;
+    next = fillEytzinger(sorted, out, next, 2 * node);
+    out[node] = sorted[next++];
+    return fillEytzinger(sorted, out, next, 2 * node + 1);
+}
+
+} // namespace
+
+Food FoodView::toFood() const {
+    return Food{ std::string(barcode), std::string(name), calories_per_100g, protein, carbs, fat };
+}
+
+CatalogSnapshot::~CatalogSnapshot() {
+    close();
+}
+
+bool CatalogSnapshot::open(const std::string& path) {
+    static_assert(sizeof(Header) == 64 && sizeof(Record) == 48, "snapshot layout");
+    close();
+
+    if (!hostIsLittleEndian()) {
+        std::cerr << "Catalog snapshots are only supported on little-endian hosts.\n";
+        return false;
+    }
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        std::cerr << "Cannot open snapshot " << path << "\n";
+        return false;
+    }
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart < static_cast<LONGLONG>(sizeof(Header))) {
+        std::cerr << "Snapshot " << path << " is truncated.\n";
+        CloseHandle(file);
+        return false;
+    }
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    const void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if (!view) {
+        std::cerr << "Cannot map snapshot " << path << "\n";
+        if (mapping) CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+    fileHandle = file;
+    mappingHandle = mapping;
+    mappedSize = static_cast<size_t>(fileSize.QuadPart);
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "Cannot open snapshot " << path << "\n";
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(Header))) {
+        std::cerr << "Snapshot " << path << " is truncated.\n";
+        ::close(fd);
+        return false;
+    }
+    void* view = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);   // the mapping keeps the file referenced
+    if (view == MAP_FAILED) {
+        std::cerr << "Cannot map snapshot " << path << "\n";
+        return false;
+    }
+    // Lookups jump around the tree; read-ahead would only waste I/O.
+    madvise(view, static_cast<size_t>(st.st_size), MADV_RANDOM);
+    mappedSize = static_cast<size_t>(st.st_size);
+#endif
+    base = static_cast<const unsigned char*>(view);
+    filePath = path;
+
+    Header h;
+    std::memcpy(&h, base, sizeof(h));
+
+    const uint64_t slots = h.count + 1;
+    bool valid = std::memcmp(h.magic, kMagic, sizeof(kMagic)) == 0 &&
+                 h.version == kFormatVersion &&
+                 h.recordSize == sizeof(Record) &&
+                 h.headerCrc == crc32(&h, offsetof(Header, headerCrc)) &&
+                 h.keysOffset == sizeof(Header) &&
+                 h.recordsOffset == h.keysOffset + slots * sizeof(uint64_t) &&
+                 h.stringsOffset == h.recordsOffset + slots * sizeof(Record) &&
+                 h.stringsOffset + h.stringsSize == mappedSize;
+    if (!valid) {
+        std::cerr << "Snapshot " << path << " is corrupt or from an incompatible version.\n";
+        close();
+        return false;
+    }
+
+    keys = reinterpret_cast<const uint64_t*>(base + h.keysOffset);
+    records = reinterpret_cast<const Record*>(base + h.recordsOffset);
+    strings = reinterpret_cast<const char*>(base + h.stringsOffset);
+    stringsSize = h.stringsSize;
+    count = static_cast<size_t>(h.count);
+    return true;
+}
+
+void CatalogSnapshot::close() {
+    if (!base) return;
+#ifdef _WIN32
+    UnmapViewOfFile(base);
+    CloseHandle(static_cast<HANDLE>(mappingHandle));
+    CloseHandle(static_cast<HANDLE>(fileHandle));
+    mappingHandle = fileHandle = nullptr;
+#else
+    munmap(const_cast<unsigned char*>(base), mappedSize);
+#endif
+    base = nullptr;
+    mappedSize = 0;
+    keys = nullptr;
+    records = nullptr;
+    strings = nullptr;
+    stringsSize = 0;
+    count = 0;
+}
+
+bool CatalogSnapshot::verify() const {
+    if (!base) return false;
+    Header h;
+    std::memcpy(&h, base, sizeof(h));
+    return crc32(base + sizeof(Header), mappedSize - sizeof(Header)) == h.payloadCrc;
+}
+
+std::optional<FoodView> CatalogSnapshot::find(std::string_view barcode) const {
+    uint64_t key = 0;
+    if (!base || !normalizedBarcodeKey(barcode, key)) return std::nullopt;
+
+    // Branch-free descent: go right while the node is smaller than the key.
+    size_t i = 1;
+    while (i <= count) {
+#if defined(__GNUC__) || defined(__clang__)
+        // Children four levels down share one or two cache lines.
+        __builtin_prefetch(keys + 16 * i);
+#endif
+        i = 2 * i + (keys[i] < key);
+    }
+    // Undo the trailing right turns plus the final left turn; 0 means not found.
+    i >>= countTrailingZeros(~static_cast<uint64_t>(i)) + 1;
+    if (i == 0 || keys[i] != key) return std::nullopt;
+
+    // The payload CRC is only checked by verify(), so a damaged record must
+    // not point outside the string pool.
+    const Record& r = records[i];
+    if (uint64_t{ r.barcodeOffset } + r.barcodeLength > stringsSize ||
+        uint64_t{ r.nameOffset } + r.nameLength > stringsSize) {
+        return std::nullopt;
+    }
+    FoodView view;
+    view.barcode = std::string_view(strings + r.barcodeOffset, r.barcodeLength);
+    view.name = std::string_view(strings + r.nameOffset, r.nameLength);
+    view.calories_per_100g = r.calories_per_100g;
+    view.protein = r.protein;
+    view.carbs = r.carbs;
+    view.fat = r.fat;
+    return view;
+}
+
+bool CatalogSnapshot::write(sqlite3* db, const std::string& path, SnapshotExportStats& stats) {
+    stats = SnapshotExportStats();
+    if (!hostIsLittleEndian()) {
+        std::cerr << "Catalog snapshots are only supported on little-endian hosts.\n";
+        return false;
+    }
+
+    struct Entry {
+        uint64_t key;
+        Record record;
+    };
+    std::vector<Entry> sorted;
+    std::string pool;
+
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db, "SELECT barcode, name, calories_per_100g, protein, carbs, fat FROM foods;",
+                           -1, &stmt, nullptr) != SQLITE_OK) {
+        std::cerr << "Snapshot export failed: " << sqlite3_errmsg(db) << "\n";
+        return false;
+    }
+
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        std::string_view barcode(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0)),
+                                 static_cast<size_t>(sqlite3_column_bytes(stmt, 0)));
+        std::string_view name(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1)),
+                              static_cast<size_t>(sqlite3_column_bytes(stmt, 1)));
+
+        Entry e{};
+        if (!normalizedBarcodeKey(barcode, e.key)) {
+            ++stats.skipped;
+            continue;
+        }
+        if (pool.size() + barcode.size() + name.size() > UINT32_MAX) {
+            std::cerr << "Snapshot export failed: string pool exceeds 4 GiB.\n";
+            sqlite3_finalize(stmt);
+            return false;
+        }
+
+        e.record.calories_per_100g = sqlite3_column_double(stmt, 2);
+        e.record.protein = sqlite3_column_double(stmt, 3);
+        e.record.carbs = sqlite3_column_double(stmt, 4);
+        e.record.fat = sqlite3_column_double(stmt, 5);
+        e.record.barcodeOffset = static_cast<uint32_t>(pool.size());
+        e.record.barcodeLength = static_cast<uint32_t>(barcode.size());
+        pool.append(barcode);
+        e.record.nameOffset = static_cast<uint32_t>(pool.size());
+        e.record.nameLength = static_cast<uint32_t>(name.size());
+        pool.append(name);
+        sorted.push_back(e);
+    }
+    sqlite3_finalize(stmt);
+    if (rc != SQLITE_DONE) {
+        std::cerr << "Snapshot export failed: " << sqlite3_errmsg(db) << "\n";
+        return false;
+    }
+
+    std::sort(sorted.begin(), sorted.end(), [](const Entry& a, const Entry& b) { return a.key < b.key; });
+    std::vector<Entry> tree(sorted.size() + 1, Entry{});
+    fillEytzinger(sorted, tree, 0, 1);
+
+    std::vector<uint64_t> keyColumn(tree.size());
+    std::vector<Record> recordColumn(tree.size());
+    for (size_t i = 0; i < tree.size(); ++i) {
+        keyColumn[i] = tree[i].key;
+        recordColumn[i] = tree[i].record;
+    }
+
+    Header h{};
+    std::memcpy(h.magic, kMagic, sizeof(kMagic));
+    h.version = kFormatVersion;
+    h.recordSize = sizeof(Record);
+    h.count = sorted.size();
+    h.keysOffset = sizeof(Header);
+    h.recordsOffset = h.keysOffset + keyColumn.size() * sizeof(uint64_t);
+    h.stringsOffset = h.recordsOffset + recordColumn.size() * sizeof(Record);
+    h.stringsSize = pool.size();
+
+    uint32_t crc = crc32(keyColumn.data(), keyColumn.size() * sizeof(uint64_t));
+    crc = crc32(recordColumn.data(), recordColumn.size() * sizeof(Record), crc);
+    h.payloadCrc = crc32(pool.data(), pool.size(), crc);
+    h.headerCrc = crc32(&h, offsetof(Header, headerCrc));
+
+    // Readers may have the old file mapped, so write aside and rename over it.
+    const std::string tmpPath = path + ".tmp";
+    {
+        std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(&h), sizeof(h));
+        out.write(reinterpret_cast<const char*>(keyColumn.data()), keyColumn.size() * sizeof(uint64_t));
+        out.write(reinterpret_cast<const char*>(recordColumn.data()), recordColumn.size() * sizeof(Record));
+        out.write(pool.data(), static_cast<std::streamsize>(pool.size()));
+        if (!out.flush()) {
+            std::cerr << "Cannot write snapshot " << tmpPath << "\n";
+            std::remove(tmpPath.c_str());
+            return false;
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tmpPath, path, ec);
+    if (ec) {
+        std::cerr << "Cannot replace snapshot " << path << ": " << ec.message() << "\n";
+        std::remove(tmpPath.c_str());
+        return false;
+    }
+
+    stats.foods = static_cast<long long>(sorted.size());
+    stats.bytes = static_cast<long long>(h.stringsOffset + h.stringsSize);
+    return true;
+}
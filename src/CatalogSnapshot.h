@@ -0,0 +1,80 @@
+#pragma once
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include "sqlite3.h"
+
+struct Food;
+
+// A food record served straight from the mapped snapshot. The views stay valid
+// while the CatalogSnapshot that produced them is open.
+struct FoodView {
+    std::string_view barcode;
+    std::string_view name;
+    double calories_per_100g = 0.0;
+    double protein = 0.0;
+    double carbs = 0.0;
+    double fat = 0.0;
+
+    Food toFood() const;
+};
+
+struct SnapshotExportStats {
+    long long foods = 0;
+    long long skipped = 0;   // barcodes that are not 1-17 digits
+    long long bytes = 0;
+};
+
+// Read-only, memory-mapped copy of the foods table.
+//
+// File layout (little-endian):
+//   header   magic "CALSNAP1", version, count, section offsets, CRC-32 of the
+//            payload and of the header itself
+//   keys     (count + 1) normalized barcode keys (see Gtin.h) in Eytzinger
+//            (BFS) order, slot 0 unused
+//   records  (count + 1) fixed-width nutrient records in the same order
+//   strings  barcode and name bytes referenced by the records
+//
+// open() maps the file and checks only the header, so it costs the same for
+// any catalog size; pages are faulted in by the lookups that touch them.
+// verify() checksums the whole payload.
+class CatalogSnapshot {
+public:
+    CatalogSnapshot() = default;
+    ~CatalogSnapshot();
+
+    CatalogSnapshot(const CatalogSnapshot&) = delete;
+    CatalogSnapshot& operator=(const CatalogSnapshot&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+    bool isOpen() const { return base != nullptr; }
+    bool verify() const;
+
+    std::optional<FoodView> find(std::string_view barcode) const;
+    size_t size() const { return count; }
+    const std::string& path() const { return filePath; }
+
+    // Writes every food with a numeric barcode to `path`, replacing any
+    // existing file only once the new one is complete.
+    static bool write(sqlite3* db, const std::string& path, SnapshotExportStats& stats);
+
+private:
+    struct Header;
+    struct Record;
+
+    std::string filePath;
+    const unsigned char* base = nullptr;
+    size_t mappedSize = 0;
+#ifdef _WIN32
+    void* fileHandle = nullptr;
+    void* mappingHandle = nullptr;
+#endif
+
+    const uint64_t* keys = nullptr;
+    const Record* records = nullptr;
+    const char* strings = nullptr;
+    uint64_t stringsSize = 0;
+    size_t count = 0;
+};
@@ -0,0 +1,87 @@
+#include "CatalogWarmup.h"
+#include <iostream>
+#include "BarcodeCache.h"
+#include "DatabaseManager.h"
+#include "Metrics.h"
+
+CatalogWarmup::~CatalogWarmup() {
+    cancel();
+}
+
+bool CatalogWarmup::start(const std::string& dbPath) {
+    if (worker.joinable()) return false;
+    startTime = std::chrono::steady_clock::now();
+    worker = std::thread(&CatalogWarmup::run, this, dbPath);
+    return true;
+}
+
+void CatalogWarmup::cancel() {
+    stopRequested.store(true, std::memory_order_relaxed);
+    if (worker.joinable()) worker.join();
+}
+
+std::unique_ptr<BarcodeCache> CatalogWarmup::take() {
+    if (!ready()) return nullptr;
+    std::lock_guard<std::mutex> lock(resultMutex);
+    return std::move(result);
+}
+
+void CatalogWarmup::run(std::string dbPath) {
+    auto cache = std::make_unique<BarcodeCache>();
+    long long count = 0;
+    bool ok = load(dbPath, *cache, count);
+
+    std::lock_guard<std::mutex> lock(resultMutex);
+    if (ok) result = std::move(cache);
+    loadedFoods = ok ? count : 0;
+    elapsedSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    finished.store(true, std::memory_order_release);
+}
+
+bool CatalogWarmup::load(const std::string& dbPath, BarcodeCache& cache, long long& count) {
+    OpTimer timer(MetricOp::CatalogWarmup);
+
+    OpenProfile profile;
+    profile.readOnly = true;
+    profile.verbose = false;
+    DatabaseManager db(dbPath, profile);
+    if (!db.open()) return timer.fail(false);
+
+    // The index walk also counts the foods, so the cache is sized once.
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db.handle(), "SELECT count(*) FROM foods WHERE barcode >= '';", -1, &stmt,
+                           nullptr) == SQLITE_OK &&
+        sqlite3_step(stmt) == SQLITE_ROW) {
+        cache.reserve(static_cast<size_t>(sqlite3_column_int64(stmt, 0)));
+    }
+    sqlite3_finalize(stmt);
+
+    if (sqlite3_prepare_v2(db.handle(), "SELECT barcode, name, calories_per_100g, protein, carbs, fat FROM foods;",
+                           -1, &stmt, nullptr) != SQLITE_OK) {
+        std::cerr << "Catalog warm-up failed: " << sqlite3_errmsg(db.handle()) << "\n";
+        return timer.fail(false);
+    }
+
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        Food food;
+        food.barcode.assign(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0)),
+                            static_cast<size_t>(sqlite3_column_bytes(stmt, 0)));
+        food.name.assign(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1)),
+                         static_cast<size_t>(sqlite3_column_bytes(stmt, 1)));
+        food.calories_per_100g = sqlite3_column_double(stmt, 2);
+        food.protein = sqlite3_column_double(stmt, 3);
+        food.carbs = sqlite3_column_double(stmt, 4);
+        food.fat = sqlite3_column_double(stmt, 5);
+        cache.put(food);
+        if (++count % 4096 == 0 && stopRequested.load(std::memory_order_relaxed)) break;
+    }
+    sqlite3_finalize(stmt);
+
+    if (rc == SQLITE_ROW) return timer.fail(false);   // cancelled
+    if (rc != SQLITE_DONE) {
+        std::cerr << "Catalog warm-up failed: " << sqlite3_errmsg(db.handle()) << "\n";
+        return timer.fail(false);
+    }
+    return true;
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+class BarcodeCache;
+
+// Loads a database's whole foods catalog into a BarcodeCache on a background
+// thread, through its own read-only connection, so startup does not wait for
+// it. The barcode index is walked first, which also brings its pages into the
+// OS page cache for lookups that reach SQLite before the load is done.
+//
+// The finished cache is handed over with take(), on the thread that owns it;
+// DatabaseManager::startCatalogWarmup() does this on its next lookup.
+class CatalogWarmup {
+public:
+    CatalogWarmup() = default;
+    // Stops a load still in progress.
+    ~CatalogWarmup();
+
+    CatalogWarmup(const CatalogWarmup&) = delete;
+    CatalogWarmup& operator=(const CatalogWarmup&) = delete;
+
+    bool start(const std::string& dbPath);
+    void cancel();
+
+    // True once the load has finished, successfully or not.
+    bool ready() const { return finished.load(std::memory_order_acquire); }
+    // The loaded cache once ready(); null on failure, before then, and after
+    // the first call.
+    std::unique_ptr<BarcodeCache> take();
+
+    // Valid once ready().
+    long long foods() const { return loadedFoods; }
+    double seconds() const { return elapsedSeconds; }
+
+private:
+    void run(std::string dbPath);
+    bool load(const std::string& dbPath, BarcodeCache& cache, long long& count);
+
+    std::thread worker;
+    std::atomic<bool> finished{ false };
+    std::atomic<bool> stopRequested{ false };
+    std::chrono::steady_clock::time_point startTime;
+    std::mutex resultMutex;
+    std::unique_ptr<BarcodeCache> result;
+    long long loadedFoods = 0;
+    double elapsedSeconds = 0.0;
+};
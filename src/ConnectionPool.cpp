@@ -0,0 +1,85 @@
+#include "ConnectionPool.h"
+#include <iostream>
+
+ConnectionPool::Lease::Lease(ConnectionPool* pool, DatabaseManager* conn, bool isWriter)
+    : pool(pool), conn(conn), isWriter(isWriter) {}
+
+ConnectionPool::Lease::Lease(Lease&& other) noexcept
+    : pool(other.pool), conn(other.conn), isWriter(other.isWriter) {
+    other.pool = nullptr;
+    other.conn = nullptr;
+}
+
+ConnectionPool::Lease::~Lease() {
+    if (pool) pool->release(conn, isWriter);
+}
+
+ConnectionPool::ConnectionPool(const std::string& dbPath, size_t readerCount, const OpenProfile& profile)
+    : databasePath(dbPath), profile(profile), requestedReaders(readerCount) {}
+
+ConnectionPool::~ConnectionPool() {
+    close();
+}
+
+bool ConnectionPool::open() {
+    OpenProfile writerProfile = profile;
+    writerProfile.readOnly = false;
+
+    writerConn = std::make_unique<DatabaseManager>(databasePath, writerProfile);
+    if (!writerConn->open() || !writerConn->createTables()) {
+        std::cerr << "Connection pool: writer failed to open\n";
+        return false;
+    }
+
+    OpenProfile readerProfile = profile;
+    readerProfile.readOnly = true;
+    readerProfile.verbose = false;
+
+    for (size_t i = 0; i < requestedReaders; ++i) {
+        auto conn = std::make_unique<DatabaseManager>(databasePath, readerProfile);
+        if (!conn->open()) {
+            std::cerr << "Connection pool: reader " << i << " failed to open\n";
+            return false;
+        }
+        idleReaders.push_back(conn.get());
+        readers.push_back(std::move(conn));
+    }
+
+    return true;
+}
+
+void ConnectionPool::close() {
+    std::lock_guard<std::mutex> lock(readerMutex);
+    idleReaders.clear();
+    readers.clear();
+    writerConn.reset();
+}
+
+ConnectionPool::Lease ConnectionPool::writer() {
+    writerMutex.lock();
+    return Lease(this, writerConn.get(), true);
+}
+
+ConnectionPool::Lease ConnectionPool::reader() {
+    if (readers.empty()) return writer();
+
+    std::unique_lock<std::mutex> lock(readerMutex);
+    readerAvailable.wait(lock, [this] { return !idleReaders.empty(); });
+
+    DatabaseManager* conn = idleReaders.back();
+    idleReaders.pop_back();
+    return Lease(this, conn, false);
+}
+
+void ConnectionPool::release(DatabaseManager* conn, bool isWriter) {
+    if (isWriter) {
+        writerMutex.unlock();
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(readerMutex);
+        idleReaders.push_back(conn);
+    }
+    readerAvailable.notify_one();
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "DatabaseManager.h"
+
+// One writer connection plus N read-only connections on the same database file.
+// With WAL journaling, threads holding reader leases run queries in parallel with
+// the writer. Each lease gives exclusive use of its connection until destroyed.
+class ConnectionPool {
+public:
+    class Lease {
+    public:
+        Lease(Lease&& other) noexcept;
+        Lease& operator=(Lease&&) = delete;
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+        ~Lease();
+
+        DatabaseManager* operator->() const { return conn; }
+        DatabaseManager& operator*() const { return *conn; }
+
+    private:
+        friend class ConnectionPool;
+        Lease(ConnectionPool* pool, DatabaseManager* conn, bool isWriter);
+
+        ConnectionPool* pool;
+        DatabaseManager* conn;
+        bool isWriter;
+    };
+
+    ConnectionPool(const std::string& dbPath, size_t readerCount, const OpenProfile& profile = OpenProfile());
+    ~ConnectionPool();
+
+    // Opens the writer (creating tables) before the readers.
+    bool open();
+    void close();
+
+    Lease writer();
+    Lease reader();   // blocks until a reader is free; the writer when there are none
+
+    size_t readerCount() const { return readers.size(); }
+
+private:
+    void release(DatabaseManager* conn, bool isWriter);
+
+    std::string databasePath;
+    OpenProfile profile;
+    size_t requestedReaders;
+
+    std::unique_ptr<DatabaseManager> writerConn;
+    std::vector<std::unique_ptr<DatabaseManager>> readers;
+
+    std::mutex writerMutex;
+    std::mutex readerMutex;
+    std::condition_variable readerAvailable;
+    std::vector<DatabaseManager*> idleReaders;
+};
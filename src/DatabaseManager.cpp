@@ -1,118 +1,172 @@
 #include "DatabaseManager.h"
+#include "BarcodeCache.h"
+#include "CatalogSnapshot.h"
+#include "CatalogWarmup.h"
+#include "Gtin.h"
+#include "LogPartitions.h"
+#include "Metrics.h"
+#include "Migrations.h"
+#include "Recipes.h"
+#include "SqlExec.h"
+#include <algorithm>
+#include <cctype>
+#include <ctime>
 #include <iostream>
+#include <unordered_map>
 
-DatabaseManager::DatabaseManager(const std::string& dbPath)
-    : databasePath(dbPath), db(nullptr) {}
+DatabaseManager::DatabaseManager(const std::string& dbPath, const OpenProfile& profile)
+    : databasePath(dbPath), openProfile(profile), db(nullptr) {}
 
 DatabaseManager::~DatabaseManager() {
     close();
 }
 
-static bool execSql(sqlite3* db, const std::string& sql) {
-    char* errMsg = nullptr;
-    int rc = sqlite3_exec(db, sql.c_str(), nullptr, nullptr, &errMsg);
-    if (rc != SQLITE_OK) {
-        std::cerr << "SQL error: " << (errMsg ? errMsg : "unknown") << "\n";
-        sqlite3_free(errMsg);
-        return false;
-    }
-    return true;
-}
-
 bool DatabaseManager::open() {
-    int rc = sqlite3_open(databasePath.c_str(), &db);
+    OpTimer timer(MetricOp::Open);
+    int flags = openProfile.readOnly ? SQLITE_OPEN_READONLY : (SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE);
+    int rc = sqlite3_open_v2(databasePath.c_str(), &db, flags, metricsVfsName());
 
     if (rc) {
         std::cerr << "Cannot open database: " << sqlite3_errmsg(db) << std::endl;
-        return false;
+        sqlite3_close(db);
+        db = nullptr;
+        return timer.fail(false);
     }
 
-    std::cout << "Database opened successfully!" << std::endl;
+    if (openProfile.verbose) {
+        std::cout << "Database opened successfully!" << std::endl;
+    }
     sqlite3_exec(db, "PRAGMA foreign_keys = ON;", nullptr, nullptr, nullptr);
+    sqlite3_busy_timeout(db, openProfile.busyTimeoutMs);
+
+    // The journal mode is a property of the file, so only the writer may change it.
+    if (!openProfile.readOnly && !openProfile.journalMode.empty()) {
+        execSql(db, "PRAGMA journal_mode = " + openProfile.journalMode + ";");
+    }
+    if (!openProfile.synchronous.empty()) {
+        execSql(db, "PRAGMA synchronous = " + openProfile.synchronous + ";");
+    }
+    if (!openProfile.tempStore.empty()) {
+        execSql(db, "PRAGMA temp_store = " + openProfile.tempStore + ";");
+    }
+    execSql(db, "PRAGMA cache_size = -" + std::to_string(openProfile.cacheSizeKiB) + ";");
+    execSql(db, "PRAGMA mmap_size = " + std::to_string(openProfile.mmapSize) + ";");
+    attachMetrics(db);
     return true;
 }
 
 void DatabaseManager::close() {
+    warmup.reset();
+    warmupPending = false;
+    warmupWrites.clear();
+
+    // Statements must be finalized before the connection can close.
+    addFoodStmt.finalize();
+    updateFoodStmt.finalize();
+    foodByBarcodeStmt.finalize();
+    foodByIdStmt.finalize();
+    nameSearchStmt.finalize();
+    logFoodStmt.finalize();
+    foodIdStmt.finalize();
+    insertLogRowStmt.finalize();
+    totalCaloriesStmt.finalize();
+    entriesForDateStmt.finalize();
+    dailyTotalsStmt.finalize();
+    dailyTotalsRangeStmt.finalize();
+    nutritionSeriesStmt.finalize();
+    topFoodsStmt.finalize();
+    setGoalStmt.finalize();
+    getGoalStmt.finalize();
+    setRetentionStmt.finalize();
+    getRetentionStmt.finalize();
+    partitionStmts.clear();
+
     if (db) {
+        detachMetrics(db);
         sqlite3_close(db);
         db = nullptr;
     }
 }
 
-bool DatabaseManager::createTables(){
-    const std::string sql = R"(
-    CREATE TABLE IF NOT EXISTS foods (
-        id INTEGER PRIMARY KEY AUTOINCREMENT,
-        barcode TEXT UNIQUE NOT NULL,
-        name TEXT NOT NULL,
-        calories_per_100g REAL NOT NULL,
-        protein REAL,
-        carbs REAL,
-        fat REAL
-        );
-    )";
-
-    const std::string logTableSql = R"(
-    CREATE TABLE IF NOT EXISTS daily_log (
-        id INTEGER PRIMARY KEY AUTOINCREMENT,
-        date TEXT NOT NULL,
-        food_id INTEGER NOT NULL,
-        grams REAL NOT NULL,
-        FOREIGN KEY(food_id) REFERENCES foods(id) ON DELETE CASCADE
-        );
-    )";
-
-    const std::string settingsTable = R"(
-    CREATE TABLE IF NOT EXISTS settings (
-        key TEXT PRIMARY KEY,
-        value TEXT NOT NULL
-        );
-    )";
-
-    char* errMsg = nullptr;
-    int rc = sqlite3_exec(db, sql.c_str(), nullptr, nullptr, &errMsg);
-
-    if (rc != SQLITE_OK) {
-        std::cerr << "SQL error: " << errMsg << std::endl;
-        sqlite3_free(errMsg);
-        return false;
-    }
-
-    errMsg = nullptr;
-    rc = sqlite3_exec(db, logTableSql.c_str(), nullptr, nullptr, &errMsg);
-
-    if (rc != SQLITE_OK) {
-        std::cerr << "SQL error: " << errMsg << std::endl;
-        sqlite3_free(errMsg);
-        return false;
-    }
-
-    errMsg = nullptr;
-    rc = sqlite3_exec(db, settingsTable.c_str(), nullptr, nullptr, &errMsg);
-
-    if (rc != SQLITE_OK) {
-        std::cerr << "SQL error: " << errMsg << std::endl;
-        sqlite3_free(errMsg);
-        return false;
-    }
+sqlite3_stmt* DatabaseManager::prepareCached(Statement& slot, const char* sql) {
+    if (slot) return slot.get();
 
-    return true;
+    OpTimer timer(MetricOp::Prepare);
+    if (!slot.prepare(db, sql)) {
+        timer.fail();
+        std::cerr << "Prepare failed: " << sqlite3_errmsg(db) << "\n";
+        return nullptr;
+    }
+    return slot.get();
 }
 
-bool DatabaseManager::addFood(const Food& food){
-    const char* sql =
-        "INSERT INTO foods (barcode, name, calories_per_100g, protein, carbs, fat) "
-        "VALUES (?, ?, ?, ?, ?, ?);";
+sqlite3_stmt* DatabaseManager::preparePartition(int month, Statement PartitionStatements::*slot,
+                                                const char* sqlTemplate, bool create, bool& missing) {
+    Statement& stmt = partitionStmts[month].*slot;
+    if (stmt) return stmt.get();
 
-    sqlite3_stmt* stmt = nullptr;
+    std::string sql = sqlTemplate;
+    const std::string table = logPartitionTable(month);
+    for (size_t pos = sql.find("%T"); pos != std::string::npos; pos = sql.find("%T", pos + table.size())) {
+        sql.replace(pos, 2, table);
+    }
 
-    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-        std::cerr << "Prepare failed: " << sqlite3_errmsg(db) << "\n";
-        return false;
+    OpTimer timer(MetricOp::Prepare);
+    missing = false;
+    if (stmt.prepare(db, sql.c_str())) return stmt.get();
+    std::string error = sqlite3_errmsg(db);
+
+    // Only a month that was never logged is an expected miss; busy or I/O
+    // errors must not read as an empty month.
+    const std::vector<int> months = listLogPartitions(db);
+    const bool exists = std::find(months.begin(), months.end(), month) != months.end();
+    if (!exists && !create) {
+        missing = true;
+        return nullptr;
+    }
+    if (!exists) {
+        // ensureLogPartition reports its own failures.
+        if (!ensureLogPartition(db, month)) return timer.fail(nullptr);
+        if (stmt.prepare(db, sql.c_str())) return stmt.get();
+        error = sqlite3_errmsg(db);
+    }
+    timer.fail();
+    std::cerr << "Prepare failed for " << table << ": " << error << "\n";
+    return nullptr;
+}
+
+int DatabaseManager::runOnPartition(int month, Statement PartitionStatements::*slot, const char* sqlTemplate,
+                                    bool create, const std::function<int(sqlite3_stmt*)>& run) {
+    int rc = SQLITE_ERROR;
+    for (int attempt = 0; attempt < 2 && rc == SQLITE_ERROR; ++attempt) {
+        if (attempt > 0) partitionStmts.erase(month);
+        bool missing = false;
+        sqlite3_stmt* stmt = preparePartition(month, slot, sqlTemplate, create, missing);
+        if (!stmt) return missing ? SQLITE_DONE : SQLITE_ERROR;
+        StatementReset reset(stmt);
+        rc = run(stmt);
     }
+    return rc;
+}
+
+bool DatabaseManager::createTables(){
+    OpTimer timer(MetricOp::Migrate);
+    return applyMigrations(db) || timer.fail(false);
+}
+
+bool DatabaseManager::addFood(const Food& input){
+    OpTimer timer(MetricOp::AddFood);
+    writeError = WriteError::Failed;
+    Food food = input;
+    food.barcode = normalizeBarcode(input.barcode);
+    sqlite3_stmt* stmt = prepareCached(addFoodStmt,
+        "INSERT INTO foods (barcode, name, calories_per_100g, protein, carbs, fat) "
+        "VALUES (?, ?, ?, ?, ?, ?);");
+    if (!stmt) return timer.fail(false);
+    StatementReset reset(stmt);
 
-    sqlite3_bind_text(stmt, 1, food.barcode.c_str(), -1, SQLITE_TRANSIENT);
-    sqlite3_bind_text(stmt, 2, food.name.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(stmt, 1, food.barcode.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 2, food.name.c_str(), -1, SQLITE_STATIC);
     sqlite3_bind_double(stmt, 3, food.calories_per_100g);
     sqlite3_bind_double(stmt, 4, food.protein);
     sqlite3_bind_double(stmt, 5, food.carbs);
@@ -122,198 +176,714 @@ bool DatabaseManager::addFood(const Food& food){
 
     if (rc != SQLITE_DONE){
         std::cerr << "Insert failed: " << sqlite3_errmsg(db) << "\n";
-        sqlite3_finalize(stmt);
-        return false;
+        if (sqlite3_extended_errcode(db) == SQLITE_CONSTRAINT_UNIQUE) writeError = WriteError::AlreadyExists;
+        return timer.fail(false);
     }
+    writeError = WriteError::None;
 
-    sqlite3_finalize(stmt);
+    if (foodCache) foodCache->put(food);
+    if (warmupPending) warmupWrites.push_back(food);
     return true;
 }
 
-std::optional<Food> DatabaseManager::getFoodByBarcode(const std::string& barcode) {
-    const char* sql =
-        "SELECT barcode, name, calories_per_100g, protein, carbs, fat "
-        "FROM foods WHERE barcode = ?;";
+bool DatabaseManager::updateFood(const Food& input) {
+    OpTimer timer(MetricOp::UpdateFood);
+    Food food = input;
+    food.barcode = normalizeBarcode(input.barcode);
+    sqlite3_stmt* stmt = prepareCached(updateFoodStmt,
+        "UPDATE foods SET name = ?, calories_per_100g = ?, protein = ?, carbs = ?, fat = ? "
+        "WHERE barcode = ? AND id NOT IN (SELECT food_id FROM recipes);");
+    if (!stmt) return timer.fail(false);
+
+    // The update and the recipe refresh it triggers commit or roll back
+    // together, also inside a caller's transaction (a savepoint then).
+    const bool ok = inTransaction(db, "update_food", [&] {
+        StatementReset reset(stmt);
+        sqlite3_bind_text(stmt, 1, food.name.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_double(stmt, 2, food.calories_per_100g);
+        sqlite3_bind_double(stmt, 3, food.protein);
+        sqlite3_bind_double(stmt, 4, food.carbs);
+        sqlite3_bind_double(stmt, 5, food.fat);
+        sqlite3_bind_text(stmt, 6, food.barcode.c_str(), -1, SQLITE_STATIC);
+        if (sqlite3_step(stmt) != SQLITE_DONE) {
+            std::cerr << "Update failed: " << sqlite3_errmsg(db) << "\n";
+            return false;
+        }
+        if (sqlite3_changes(db) == 0) {
+            std::cerr << "No food (other than a recipe) with barcode " << food.barcode << "\n";
+            return false;
+        }
+        return refreshRecipes(*this) >= 0;
+    });
+    if (!ok) return timer.fail(false);
+
+    if (foodCache) foodCache->put(food);
+    if (warmupPending) warmupWrites.push_back(food);
+    return true;
+}
 
-    sqlite3_stmt* stmt = nullptr;
+static Food readFoodRow(sqlite3_stmt* stmt) {
+    Food food;
+    food.barcode = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+    food.name = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
+    food.calories_per_100g = sqlite3_column_double(stmt, 2);
+    food.protein = sqlite3_column_double(stmt, 3);
+    food.carbs = sqlite3_column_double(stmt, 4);
+    food.fat = sqlite3_column_double(stmt, 5);
+    return food;
+}
 
-    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-        std::cerr << "Prepare failed: " << sqlite3_errmsg(db) << "\n";
-        return std::nullopt;
+std::optional<Food> DatabaseManager::getFoodByBarcode(const std::string& input) {
+    OpTimer timer(MetricOp::GetFoodByBarcode);
+    const std::string barcode = normalizeBarcode(input);
+    if (warmupPending) adoptWarmCatalog();
+    if (foodCache) {
+        if (const Food* cached = foodCache->find(barcode)) return *cached;
     }
 
-    sqlite3_bind_text(stmt, 1, barcode.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_stmt* stmt = prepareCached(foodByBarcodeStmt,
+        "SELECT barcode, name, calories_per_100g, protein, carbs, fat "
+        "FROM foods WHERE barcode = ?;");
+    if (!stmt) return timer.fail(std::nullopt);
+    StatementReset reset(stmt);
+
+    sqlite3_bind_text(stmt, 1, barcode.c_str(), -1, SQLITE_STATIC);
 
     int rc = sqlite3_step(stmt);
 
     if (rc == SQLITE_ROW) {
-        Food food;
-        food.barcode = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
-        food.name = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
-        food.calories_per_100g = sqlite3_column_double(stmt, 2);
-        food.protein = sqlite3_column_double(stmt, 3);
-        food.carbs = sqlite3_column_double(stmt, 4);
-        food.fat = sqlite3_column_double(stmt, 5);
-
-        sqlite3_finalize(stmt);
+        Food food = readFoodRow(stmt);
+
+        if (foodCache) foodCache->put(food);
         return food;
     }
 
-    sqlite3_finalize(stmt);
+    if (snapshot) {
+        if (auto view = snapshot->find(barcode)) return view->toFood();
+    }
     return std::nullopt;
 }
 
-bool DatabaseManager::logFoodForDate(const std::string& date, const std::string& barcode, double grams) {
+std::optional<Food> DatabaseManager::getFoodById(long long foodId) {
+    OpTimer timer(MetricOp::GetFoodById);
+    sqlite3_stmt* stmt = prepareCached(foodByIdStmt,
+        "SELECT barcode, name, calories_per_100g, protein, carbs, fat "
+        "FROM foods WHERE id = ?;");
+    if (!stmt) return timer.fail(std::nullopt);
+    StatementReset reset(stmt);
 
-    const char* sql =
-        "INSERT INTO daily_log (date, food_id, grams) "
-        "SELECT ?, id, ? FROM foods WHERE barcode = ?;";
+    sqlite3_bind_int64(stmt, 1, foodId);
 
-    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        return readFoodRow(stmt);
+    }
+    return std::nullopt;
+}
 
-    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-        std::cerr << "Prepare failed: " << sqlite3_errmsg(db) << "\n";
-        return false;
+// Turns free text into an FTS5 query: each word becomes a quoted prefix term,
+// so user input can never be parsed as FTS5 syntax.
+static std::string toFtsPrefixQuery(const std::string& text) {
+    std::string query;
+    std::string word;
+    auto flush = [&] {
+        if (word.empty()) return;
+        if (!query.empty()) query += ' ';
+        query += '"';
+        query += word;
+        query += "\"*";
+        word.clear();
+    };
+
+    for (char c : text) {
+        unsigned char u = static_cast<unsigned char>(c);
+        if (std::isalnum(u) || u >= 0x80) {
+            word += c;
+        } else {
+            flush();
+        }
     }
+    flush();
+    return query;
+}
+
+std::vector<Food> DatabaseManager::searchFoodsByName(const std::string& query, size_t limit) {
+    OpTimer timer(MetricOp::SearchFoodsByName);
+    std::vector<Food> foods;
+    const std::string match = toFtsPrefixQuery(query);
+    if (match.empty() || limit == 0) return foods;
+
+    sqlite3_stmt* stmt = prepareCached(nameSearchStmt,
+        "SELECT f.barcode, f.name, f.calories_per_100g, f.protein, f.carbs, f.fat "
+        "FROM (SELECT rowid, rank FROM foods_fts WHERE foods_fts MATCH ?1 LIMIT 2000) m "
+        "JOIN foods f ON f.id = m.rowid ORDER BY m.rank LIMIT ?2;");
+    if (!stmt) return timer.fail(foods);
+    StatementReset reset(stmt);
+
+    sqlite3_bind_text(stmt, 1, match.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_int64(stmt, 2, static_cast<sqlite3_int64>(limit));
+
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        foods.push_back(readFoodRow(stmt));
+    }
+    // SQLITE_INTERRUPT means a caller's progress handler cut the query short.
+    if (rc == SQLITE_INTERRUPT) {
+        foods.clear();
+    } else if (rc != SQLITE_DONE) {
+        timer.fail();
+        std::cerr << "Name search failed: " << sqlite3_errmsg(db) << "\n";
+    }
+    return foods;
+}
 
-    sqlite3_bind_text(stmt, 1, date.c_str(), -1, SQLITE_TRANSIENT);
-    sqlite3_bind_double(stmt, 2, grams);
-    sqlite3_bind_text(stmt, 3, barcode.c_str(), -1, SQLITE_TRANSIENT);
+std::optional<long long> DatabaseManager::findFoodId(const std::string& input) {
+    OpTimer timer(MetricOp::FindFoodId);
+    const std::string barcode = normalizeBarcode(input);
+    sqlite3_stmt* stmt = prepareCached(foodIdStmt, "SELECT id FROM foods WHERE barcode = ?;");
+    if (!stmt) return timer.fail(std::nullopt);
+    StatementReset reset(stmt);
 
-    int rc = sqlite3_step(stmt);
-    sqlite3_finalize(stmt);
+    sqlite3_bind_text(stmt, 1, barcode.c_str(), -1, SQLITE_STATIC);
+
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        return sqlite3_column_int64(stmt, 0);
+    }
+    return std::nullopt;
+}
+
+bool DatabaseManager::isLoggableDay(Date day) {
+    const Date today = Date::fromDays(static_cast<int32_t>(std::time(nullptr) / 86400));
+    int y = 0, m = 0, d = 0;
+    today.ymd(y, m, d);
+    return Date::fromYmd(y - 35, 1, 1) <= day && day <= Date::fromYmd(y + 5, 12, 31);
+}
+
+// Refuses days outside isLoggableDay() before they can create a partition.
+static bool checkLoggableDay(Date date, WriteError& error) {
+    if (DatabaseManager::isLoggableDay(date)) return true;
+    std::cerr << "Date out of range: " << date.toString() << "\n";
+    error = WriteError::DateOutOfRange;
+    return false;
+}
+
+bool DatabaseManager::insertLogRow(Date date, long long foodId, double grams) {
+    OpTimer timer(MetricOp::InsertLogRow);
+    writeError = WriteError::None;
+    if (!checkLoggableDay(date, writeError)) return timer.fail(false);
+    int rc = runOnPartition(logPartitionMonth(date), &PartitionStatements::insertLogRow,
+        "INSERT INTO %T (day, food_id, grams) VALUES (?, ?, ?);", true,
+        [&](sqlite3_stmt* stmt) {
+            sqlite3_bind_int(stmt, 1, date.days());
+            sqlite3_bind_int64(stmt, 2, foodId);
+            sqlite3_bind_double(stmt, 3, grams);
+            return sqlite3_step(stmt);
+        });
 
     if (rc != SQLITE_DONE) {
         std::cerr << "Log insert failed: " << sqlite3_errmsg(db) << "\n";
-        return false;
+        writeError = WriteError::Failed;
+        return timer.fail(false);
+    }
+    return true;
+}
+
+static std::optional<Date> parseDateArg(const std::string& date) {
+    auto parsed = Date::parse(date);
+    if (!parsed) {
+        std::cerr << "Invalid date: " << date << " (expected YYYY-MM-DD)\n";
+    }
+    return parsed;
+}
+
+bool DatabaseManager::logFoodForDate(const std::string& date, const std::string& barcode, double grams) {
+    auto day = parseDateArg(date);
+    return day && logFoodForDate(*day, barcode, grams);
+}
+
+bool DatabaseManager::logFoodForDate(Date date, const std::string& input, double grams) {
+    OpTimer timer(MetricOp::LogFoodForDate);
+    writeError = WriteError::None;
+    if (!checkLoggableDay(date, writeError)) return timer.fail(false);
+    const std::string barcode = normalizeBarcode(input);
+    int changes = 0;
+    int rc = runOnPartition(logPartitionMonth(date), &PartitionStatements::logFood,
+        "INSERT INTO %T (day, food_id, grams) "
+        "SELECT ?, id, ? FROM foods WHERE barcode = ?;", true,
+        [&](sqlite3_stmt* stmt) {
+            sqlite3_bind_int(stmt, 1, date.days());
+            sqlite3_bind_double(stmt, 2, grams);
+            sqlite3_bind_text(stmt, 3, barcode.c_str(), -1, SQLITE_STATIC);
+
+            int stepRc = sqlite3_step(stmt);
+
+            if (stepRc == SQLITE_DONE && sqlite3_changes(db) == 0 && copyFoodFromSnapshot(barcode)) {
+                sqlite3_reset(stmt);
+                stepRc = sqlite3_step(stmt);
+            }
+            changes = sqlite3_changes(db);
+            return stepRc;
+        });
+
+    if (rc != SQLITE_DONE) {
+        std::cerr << "Log insert failed: " << sqlite3_errmsg(db) << "\n";
+        writeError = WriteError::Failed;
+        return timer.fail(false);
     }
 
     // If barcode doesn't exist, INSERT...SELECT inserts 0 rows
-    if (sqlite3_changes(db) == 0) {
+    if (changes == 0) {
         std::cerr << "No food found for that barcode.\n";
-        return false;
+        writeError = WriteError::NotFound;
+        return timer.fail(false);
     }
 
     return true;
 }
 
 double DatabaseManager::getTotalCaloriesForDate(const std::string& date) {
-    const char* sql =
-        "SELECT COALESCE(SUM((f.calories_per_100g / 100.0) * l.grams), 0) "
-        "FROM daily_log l "
-        "JOIN foods f ON f.id = l.food_id "
-        "WHERE l.date = ?;";
-
-    sqlite3_stmt* stmt = nullptr;
+    auto day = parseDateArg(date);
+    return day ? getTotalCaloriesForDate(*day) : 0.0;
+}
 
-    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-        std::cerr << "Prepare failed: " << sqlite3_errmsg(db) << "\n";
-        return 0.0;
-    }
+double DatabaseManager::getTotalCaloriesForDate(Date date) {
+    OpTimer timer(MetricOp::GetTotalCaloriesForDate);
+    sqlite3_stmt* stmt = prepareCached(totalCaloriesStmt,
+        "SELECT calories FROM daily_totals WHERE day = ?;");
+    if (!stmt) return timer.fail(0.0);
+    StatementReset reset(stmt);
 
-    sqlite3_bind_text(stmt, 1, date.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_int(stmt, 1, date.days());
 
     double total = 0.0;
     if (sqlite3_step(stmt) == SQLITE_ROW) {
         total = sqlite3_column_double(stmt, 0);
     }
 
-    sqlite3_finalize(stmt);
     return total;
 }
 
-std::vector<LogEntry> DatabaseManager::getEntriesForDate(const std::string& date) {
-    const char* sql =
-        "SELECT f.name, f.barcode, l.grams, (f.calories_per_100g / 100.0) * l.grams AS calories "
-        "FROM daily_log l "
-        "JOIN foods f ON f.id = l.food_id "
-        "WHERE l.date = ? "
-        "ORDER BY l.id ASC;";
+static DailyTotals readDailyTotals(sqlite3_stmt* stmt) {
+    DailyTotals t;
+    t.day = Date::fromDays(sqlite3_column_int(stmt, 0));
+    t.calories = sqlite3_column_double(stmt, 1);
+    t.protein = sqlite3_column_double(stmt, 2);
+    t.carbs = sqlite3_column_double(stmt, 3);
+    t.fat = sqlite3_column_double(stmt, 4);
+    t.entries = sqlite3_column_int(stmt, 5);
+    return t;
+}
 
-    sqlite3_stmt* stmt = nullptr;
-    std::vector<LogEntry> entries;
+Nutrients DatabaseManager::getNutrientsForDate(const std::string& date) {
+    auto day = parseDateArg(date);
+    return day ? getNutrientsForDate(*day) : Nutrients{};
+}
 
-    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-        std::cerr << "Prepare failed: " << sqlite3_errmsg(db) << "\n";
-        return entries;
+Nutrients DatabaseManager::getNutrientsForDate(Date date) {
+    const DailyTotals t = getDailyTotals(date);
+    Nutrients n;
+    n.lane[Nutrients::Calories] = t.calories;
+    n.lane[Nutrients::Protein] = t.protein;
+    n.lane[Nutrients::Carbs] = t.carbs;
+    n.lane[Nutrients::Fat] = t.fat;
+    return n;
+}
+
+DailyTotals DatabaseManager::getDailyTotals(const std::string& date) {
+    auto day = parseDateArg(date);
+    return day ? getDailyTotals(*day) : DailyTotals{};
+}
+
+DailyTotals DatabaseManager::getDailyTotals(Date date) {
+    OpTimer timer(MetricOp::GetDailyTotals);
+    DailyTotals totals;
+    totals.day = date;
+
+    sqlite3_stmt* stmt = prepareCached(dailyTotalsStmt,
+        "SELECT day, calories, protein, carbs, fat, entries FROM daily_totals WHERE day = ?;");
+    if (!stmt) return timer.fail(totals);
+    StatementReset reset(stmt);
+
+    sqlite3_bind_int(stmt, 1, date.days());
+
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        totals = readDailyTotals(stmt);
     }
 
-    sqlite3_bind_text(stmt, 1, date.c_str(), -1, SQLITE_TRANSIENT);
+    return totals;
+}
+
+std::vector<DailyTotals> DatabaseManager::getDailyTotalsRange(const std::string& from, const std::string& to) {
+    auto first = parseDateArg(from);
+    auto last = parseDateArg(to);
+    if (!first || !last) return {};
+    return getDailyTotalsRange(*first, *last);
+}
+
+std::vector<DailyTotals> DatabaseManager::getDailyTotalsRange(Date from, Date to) {
+    OpTimer timer(MetricOp::GetDailyTotalsRange);
+    std::vector<DailyTotals> days;
+
+    sqlite3_stmt* stmt = prepareCached(dailyTotalsRangeStmt,
+        "SELECT day, calories, protein, carbs, fat, entries FROM daily_totals "
+        "WHERE day BETWEEN ? AND ? ORDER BY day ASC;");
+    if (!stmt) return timer.fail(days);
+    StatementReset reset(stmt);
+
+    sqlite3_bind_int(stmt, 1, from.days());
+    sqlite3_bind_int(stmt, 2, to.days());
 
     while (sqlite3_step(stmt) == SQLITE_ROW) {
-        LogEntry e;
-        e.name = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
-        e.barcode = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
-        e.grams = sqlite3_column_double(stmt, 2);
-        e.calories = sqlite3_column_double(stmt, 3);
-        entries.push_back(e);
+        days.push_back(readDailyTotals(stmt));
+    }
+
+    return days;
+}
+
+NutritionSeries DatabaseManager::getNutritionSeries(const std::string& from, const std::string& to) {
+    auto first = parseDateArg(from);
+    auto last = parseDateArg(to);
+    if (!first || !last) return {};
+    return getNutritionSeries(*first, *last);
+}
+
+NutritionSeries DatabaseManager::getNutritionSeries(Date from, Date to) {
+    OpTimer timer(MetricOp::GetNutritionSeries);
+    NutritionSeries series;
+    series.from = from;
+    series.to = to;
+
+    sqlite3_stmt* stmt = prepareCached(nutritionSeriesStmt,
+        "SELECT day - ?1, calories, protein, carbs, fat "
+        "FROM daily_totals WHERE day BETWEEN ?1 AND ?2 ORDER BY day ASC;");
+    if (!stmt) return timer.fail(series);
+    StatementReset reset(stmt);
+
+    sqlite3_bind_int(stmt, 1, from.days());
+    sqlite3_bind_int(stmt, 2, to.days());
+
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        series.dayOffset.push_back(sqlite3_column_int(stmt, 0));
+        series.calories.push_back(sqlite3_column_double(stmt, 1));
+        series.protein.push_back(sqlite3_column_double(stmt, 2));
+        series.carbs.push_back(sqlite3_column_double(stmt, 3));
+        series.fat.push_back(sqlite3_column_double(stmt, 4));
+    }
+
+    return series;
+}
+
+bool DatabaseManager::rebuildDailyTotals() {
+    OpTimer timer(MetricOp::RebuildDailyTotals);
+    if (!beginTransaction()) return timer.fail(false);
+    if (!execSql(db, rebuildDailyTotalsSql)) {
+        rollback();
+        return timer.fail(false);
     }
+    return commit() || timer.fail(false);
+}
+
+std::vector<LogEntry> DatabaseManager::getEntriesForDate(const std::string& date) {
+    auto day = parseDateArg(date);
+    return day ? getEntriesForDate(*day) : std::vector<LogEntry>{};
+}
 
-    sqlite3_finalize(stmt);
+std::vector<LogEntry> DatabaseManager::getEntriesForDate(Date date) {
+    std::vector<LogEntry> entries;
+    bool ok = visitEntriesForDate(date, [&](std::string_view name, std::string_view barcode, double grams,
+                                            const Nutrients& per100g) {
+        entries.push_back(LogEntry{ std::string(name), std::string(barcode), grams, per100g.scaledTo(grams) });
+    });
+    if (!ok) entries.clear();
     return entries;
 }
 
-bool DatabaseManager::clearAllLogs() {
-    // Delete rows
-    if (!execSql(db, "DELETE FROM daily_log;")) return false;
-    // Reset autoincrement for this table
-    execSql(db, "DELETE FROM sqlite_sequence WHERE name='daily_log';");
+bool DatabaseManager::visitEntriesForDate(Date date, const EntryVisitor& visit) {
+    OpTimer timer(MetricOp::GetEntriesForDate);
+
+    // A single day lives in one partition, so the query skips the view.
+    int rc = runOnPartition(logPartitionMonth(date), &PartitionStatements::entriesForDate,
+        "SELECT f.name, f.barcode, l.grams, f.calories_per_100g, f.protein, f.carbs, f.fat "
+        "FROM %T l "
+        "JOIN foods f ON f.id = l.food_id "
+        "WHERE l.day = ? "
+        "ORDER BY l.id ASC;", false,
+        [&](sqlite3_stmt* stmt) {
+            sqlite3_bind_int(stmt, 1, date.days());
+
+            int stepRc;
+            while ((stepRc = sqlite3_step(stmt)) == SQLITE_ROW) {
+                const auto* name = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+                const int nameBytes = sqlite3_column_bytes(stmt, 0);
+                const auto* barcode = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
+                const int barcodeBytes = sqlite3_column_bytes(stmt, 1);
+                // All nutrients come from the same row; scaling is left to the caller.
+                Nutrients per100g;
+                per100g.lane[Nutrients::Calories] = sqlite3_column_double(stmt, 3);
+                per100g.lane[Nutrients::Protein] = sqlite3_column_double(stmt, 4);
+                per100g.lane[Nutrients::Carbs] = sqlite3_column_double(stmt, 5);
+                per100g.lane[Nutrients::Fat] = sqlite3_column_double(stmt, 6);
+                visit(std::string_view(name, nameBytes), std::string_view(barcode, barcodeBytes),
+                      sqlite3_column_double(stmt, 2), per100g);
+            }
+            return stepRc;
+        });
+    if (rc != SQLITE_DONE) return timer.fail(false);
+
     return true;
 }
 
-bool DatabaseManager::clearAllFoods() {
-    // With ON DELETE CASCADE, deleting foods will also delete dependent logs
-    if (!execSql(db, "DELETE FROM foods;")) return false;
+std::vector<FoodUsage> DatabaseManager::getTopFoods(Date from, Date to, size_t limit) {
+    OpTimer timer(MetricOp::GetTopFoods);
+    std::vector<FoodUsage> foods;
+
+    // Summed here rather than with GROUP BY: SQLite's sorter for the grouping
+    // cost several times more than this scan of the partitions' day indexes.
+    sqlite3_stmt* stmt = prepareCached(topFoodsStmt,
+        "SELECT l.food_id, l.grams, f.calories_per_100g "
+        "FROM daily_log l JOIN foods f ON f.id = l.food_id "
+        "WHERE l.day BETWEEN ? AND ?;");
+    if (!stmt) return timer.fail(foods);
+
+    struct Usage {
+        long long foodId;
+        double grams;
+        int entries;
+        double caloriesPer100g;
+    };
+    std::unordered_map<long long, size_t> slotByFood;
+    std::vector<Usage> usage;
+    {
+        StatementReset reset(stmt);
+        sqlite3_bind_int(stmt, 1, from.days());
+        sqlite3_bind_int(stmt, 2, to.days());
+
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            const long long foodId = sqlite3_column_int64(stmt, 0);
+            auto inserted = slotByFood.emplace(foodId, usage.size());
+            if (inserted.second) {
+                usage.push_back(Usage{ foodId, 0.0, 0, sqlite3_column_double(stmt, 2) });
+            }
+            Usage& u = usage[inserted.first->second];
+            u.grams += sqlite3_column_double(stmt, 1);
+            ++u.entries;
+        }
+    }
 
-    // Reset autoincrement counters
-    execSql(db, "DELETE FROM sqlite_sequence WHERE name='foods';");
-    execSql(db, "DELETE FROM sqlite_sequence WHERE name='daily_log';");
-    return true;
+    const size_t count = std::min(limit, usage.size());
+    std::partial_sort(usage.begin(), usage.begin() + count, usage.end(), [](const Usage& a, const Usage& b) {
+        return a.caloriesPer100g * a.grams > b.caloriesPer100g * b.grams;
+    });
+
+    for (size_t i = 0; i < count; ++i) {
+        const Usage& u = usage[i];
+        auto food = getFoodById(u.foodId);
+        if (!food) continue;
+
+        FoodUsage f;
+        f.barcode = food->barcode;
+        f.name = food->name;
+        f.grams = u.grams;
+        f.calories = u.caloriesPer100g / 100.0 * u.grams;
+        f.protein = food->protein / 100.0 * u.grams;
+        f.carbs = food->carbs / 100.0 * u.grams;
+        f.fat = food->fat / 100.0 * u.grams;
+        f.entries = u.entries;
+        foods.push_back(f);
+    }
+
+    return foods;
 }
 
-bool DatabaseManager::factoryReset() {
-    // Wipe everything in a safe order (logs first to be safe even without cascade)
-    if (!execSql(db, "DELETE FROM daily_log;")) return false;
-    if (!execSql(db, "DELETE FROM foods;")) return false;
+bool DatabaseManager::clearAllLogs() {
+    OpTimer timer(MetricOp::ClearAllLogs);
+    // Dropping each month's table (and emptying the rollup) replaces a
+    // row-by-row DELETE; the partitions' sequences go with them.
+    partitionStmts.clear();
+    return dropAllLogPartitions(db) || timer.fail(false);
+}
 
-    // Reset all sequences
-    execSql(db, "DELETE FROM sqlite_sequence WHERE name='foods';");
-    execSql(db, "DELETE FROM sqlite_sequence WHERE name='daily_log';");
-    return true;
+// Logs and foods go in one transaction, so a failure leaves both in place.
+// Every log row references a food, so the partitions are dropped outright
+// instead of being emptied by ON DELETE CASCADE.
+bool DatabaseManager::clearLogsAndFoods(const char* extraSql) {
+    partitionStmts.clear();
+    const bool ok = inTransaction(db, "clear_foods", [&] {
+        return dropAllLogPartitions(db) &&
+               execSql(db, "DELETE FROM foods;"
+                           "DELETE FROM sqlite_sequence WHERE name = 'foods';") &&
+               (!extraSql || execSql(db, extraSql));
+    });
+    invalidateBarcodeCache();
+    return ok;
 }
 
-bool DatabaseManager::setDailyGoal(double goal) {
-    const char* sql =
-        "INSERT INTO settings (key, value) VALUES ('daily_goal', ?) "
-        "ON CONFLICT(key) DO UPDATE SET value = excluded.value;";
+bool DatabaseManager::clearAllFoods() {
+    OpTimer timer(MetricOp::ClearAllFoods);
+    return clearLogsAndFoods(nullptr) || timer.fail(false);
+}
 
-    sqlite3_stmt* stmt = nullptr;
+bool DatabaseManager::factoryReset() {
+    OpTimer timer(MetricOp::FactoryReset);
+    // Also forgets settings, sync state and journal progress. The database
+    // gets a new device id: peers have already seen the old one's log ids.
+    return clearLogsAndFoods(
+               "DELETE FROM food_changes;"
+               "DELETE FROM sqlite_sequence WHERE name = 'food_changes';"
+               "DELETE FROM sync_peers;"
+               "DELETE FROM sync_log_cursors;"
+               "DELETE FROM log_origins;"
+               "DELETE FROM journal_replay;"
+               "DELETE FROM settings WHERE key <> 'device_id';"
+               "UPDATE settings SET value = CAST(abs(random() >> 1) AS TEXT) WHERE key = 'device_id';") ||
+           timer.fail(false);
+}
 
-    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK)
-        return false;
+bool DatabaseManager::setDailyGoal(double goal) {
+    OpTimer timer(MetricOp::SetDailyGoal);
+    sqlite3_stmt* stmt = prepareCached(setGoalStmt,
+        "INSERT INTO settings (key, value) VALUES ('daily_goal', ?) "
+        "ON CONFLICT(key) DO UPDATE SET value = excluded.value;");
+    if (!stmt) return timer.fail(false);
+    StatementReset reset(stmt);
 
     sqlite3_bind_double(stmt, 1, goal);
 
-    int rc = sqlite3_step(stmt);
-    sqlite3_finalize(stmt);
-
-    return rc == SQLITE_DONE;
+    return sqlite3_step(stmt) == SQLITE_DONE || timer.fail(false);
 }
 
 double DatabaseManager::getDailyGoal() {
-    const char* sql =
-        "SELECT value FROM settings WHERE key = 'daily_goal';";
+    OpTimer timer(MetricOp::GetDailyGoal);
+    sqlite3_stmt* stmt = prepareCached(getGoalStmt,
+        "SELECT value FROM settings WHERE key = 'daily_goal';");
+    if (!stmt) return timer.fail(0.0);
+    StatementReset reset(stmt);
 
-    sqlite3_stmt* stmt = nullptr;
     double goal = 0.0;
-
-    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK)
-        return 0.0;
-
     if (sqlite3_step(stmt) == SQLITE_ROW) {
         goal = sqlite3_column_double(stmt, 0);
     }
 
-    sqlite3_finalize(stmt);
     return goal;
-}
\ No newline at end of file
+}
+
+bool DatabaseManager::setLogRetentionMonths(int months) {
+    OpTimer timer(MetricOp::SetLogRetention);
+    sqlite3_stmt* stmt = prepareCached(setRetentionStmt,
+        "INSERT INTO settings (key, value) VALUES ('log_retention_months', ?) "
+        "ON CONFLICT(key) DO UPDATE SET value = excluded.value;");
+    if (!stmt) return timer.fail(false);
+    StatementReset reset(stmt);
+
+    sqlite3_bind_int(stmt, 1, std::max(0, months));
+
+    return sqlite3_step(stmt) == SQLITE_DONE || timer.fail(false);
+}
+
+int DatabaseManager::getLogRetentionMonths() {
+    OpTimer timer(MetricOp::GetLogRetention);
+    sqlite3_stmt* stmt = prepareCached(getRetentionStmt,
+        "SELECT value FROM settings WHERE key = 'log_retention_months';");
+    if (!stmt) return timer.fail(0);
+    StatementReset reset(stmt);
+
+    int months = 0;
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        months = sqlite3_column_int(stmt, 0);
+    }
+
+    return months;
+}
+
+int DatabaseManager::applyLogRetention(Date today) {
+    OpTimer timer(MetricOp::ApplyLogRetention);
+    const int months = getLogRetentionMonths();
+    if (months <= 0) return 0;
+
+    // Oldest month still kept: the current month and the months - 1 before it.
+    const int current = logPartitionMonth(today);
+    const int keptIndex = (current / 100) * 12 + (current % 100 - 1) - (months - 1);
+    const int oldestKept = (keptIndex / 12) * 100 + keptIndex % 12 + 1;
+
+    // One transaction per month keeps each write lock short, so concurrent
+    // loggers wait for a single DROP TABLE at most.
+    int dropped = 0;
+    for (int month : listLogPartitions(db)) {
+        if (month >= oldestKept) break;
+        partitionStmts.erase(month);
+        if (!beginTransaction()) return timer.fail(-1);
+        if (!dropLogPartition(db, month)) {
+            rollback();
+            return timer.fail(-1);
+        }
+        if (!commit()) return timer.fail(-1);
+        ++dropped;
+    }
+    return dropped;
+}
+
+bool DatabaseManager::beginTransaction() {
+    OpTimer timer(MetricOp::BeginTransaction);
+    return execSql(db, "BEGIN IMMEDIATE;") || timer.fail(false);
+}
+
+bool DatabaseManager::commit() {
+    OpTimer timer(MetricOp::Commit);
+    return execSql(db, "COMMIT;") || timer.fail(false);
+}
+
+bool DatabaseManager::rollback() {
+    OpTimer timer(MetricOp::Rollback);
+    return execSql(db, "ROLLBACK;") || timer.fail(false);
+}
+
+void DatabaseManager::enableBarcodeCache(bool enabled) {
+    if (!enabled) foodCache.reset();
+    else if (!foodCache) foodCache = std::make_unique<BarcodeCache>();
+}
+
+void DatabaseManager::invalidateBarcodeCache() {
+    if (foodCache) foodCache->clear();
+    if (warmupPending) warmupStale = true;
+}
+
+bool DatabaseManager::startCatalogWarmup() {
+    if (!db || warmupPending) return false;
+    auto loader = std::make_unique<CatalogWarmup>();
+    if (!loader->start(databasePath)) return false;
+    warmup = std::move(loader);
+    warmupPending = true;
+    warmupStale = false;
+    return true;
+}
+
+void DatabaseManager::adoptWarmCatalog() {
+    if (!warmup->ready()) return;
+    warmupPending = false;
+
+    std::unique_ptr<BarcodeCache> loaded = warmup->take();
+    if (loaded && !warmupStale) {
+        // The load may have read some of these before they were written here.
+        for (const Food& food : warmupWrites) loaded->put(food);
+        foodCache = std::move(loaded);
+    }
+    warmupWrites.clear();
+    warmupWrites.shrink_to_fit();
+    warmupStale = false;
+}
+
+bool DatabaseManager::attachSnapshot(const std::string& path) {
+    auto mapped = std::make_unique<CatalogSnapshot>();
+    if (!mapped->open(path)) return false;
+    snapshot = std::move(mapped);
+    return true;
+}
+
+void DatabaseManager::detachSnapshot() {
+    snapshot.reset();
+}
+
+bool DatabaseManager::copyFoodFromSnapshot(const std::string& barcode) {
+    if (!snapshot) return false;
+    auto view = snapshot->find(barcode);
+    return view && addFood(view->toFood());
+}
@@ -1,8 +1,16 @@
 #pragma once
 #include <string>
+#include <string_view>
 #include "sqlite3.h"
+#include "Statement.h"
 #include <optional>
 #include <vector>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include "Date.h"
+#include "NutritionSeries.h"
+#include "Nutrients.h"
 
 struct Food {
     std::string barcode;
@@ -17,29 +25,220 @@ struct LogEntry{
     std::string name;
     std::string barcode;
     double grams;
-    double calories;
+    Nutrients nutrients;   // for `grams` of the food
 };
 
+// One food's share of a date range, for "top foods" reports.
+struct FoodUsage {
+    std::string barcode;
+    std::string name;
+    double grams = 0.0;
+    double calories = 0.0;
+    double protein = 0.0;
+    double carbs = 0.0;
+    double fat = 0.0;
+    int entries = 0;
+};
+
+struct DailyTotals {
+    Date day;
+    double calories = 0.0;
+    double protein = 0.0;
+    double carbs = 0.0;
+    double fat = 0.0;
+    int entries = 0;
+};
+
+// Connection settings applied by DatabaseManager::open().
+struct OpenProfile {
+    std::string journalMode = "WAL";        // readers no longer block behind the writer
+    std::string synchronous = "FULL";       // a committed transaction survives power loss
+    int cacheSizeKiB = 16384;               // PRAGMA cache_size = -N
+    long long mmapSize = 256LL * 1024 * 1024;
+    std::string tempStore = "MEMORY";
+    int busyTimeoutMs = 5000;
+    bool readOnly = false;
+    bool verbose = true;                    // print the "opened" banner
+};
+
+// WAL with synchronous=NORMAL fsyncs only at checkpoints: commits are much
+// cheaper, but a power loss can drop the last committed transactions (the file
+// stays consistent). Used by the HTTP service and the benchmarks.
+inline OpenProfile throughputProfile() {
+    OpenProfile profile;
+    profile.synchronous = "NORMAL";
+    return profile;
+}
+
+// Why the last addFood, logFoodForDate or insertLogRow call returned false.
+enum class WriteError {
+    None,
+    AlreadyExists,    // addFood: the barcode is taken
+    NotFound,         // logFoodForDate: no food with that barcode
+    DateOutOfRange,   // outside isLoggableDay()
+    Failed            // SQLite error; details went to stderr
+};
+
+class BarcodeCache;
+class CatalogSnapshot;
+class CatalogWarmup;
+
 class DatabaseManager {
 public:
-    DatabaseManager(const std::string& dbPath);
+    DatabaseManager(const std::string& dbPath, const OpenProfile& profile = OpenProfile());
     ~DatabaseManager();
 
     bool open();
     void close();
-    bool createTables();
+    bool createTables();   // applies pending schema migrations
+    // Date-taking APIs accept ISO "YYYY-MM-DD" strings; invalid dates are
+    // reported and treated as a failed call. The Date overloads skip parsing.
+    // Barcodes are normalized on the way in (Gtin.h): UPC-A, EAN-13, EAN-8 and
+    // GTIN-14 forms of a code find the same food, stored as its GTIN-14.
     bool logFoodForDate(const std::string& date, const std::string& barcode, double grams);
+    bool logFoodForDate(Date date, const std::string& barcode, double grams);
     double getTotalCaloriesForDate(const std::string& date);
+    double getTotalCaloriesForDate(Date date);
     bool addFood(const Food& food);
+    // Replaces a food's name and nutrition by barcode, then recomputes the
+    // recipes that use it (Recipes.h). Recipes themselves cannot be updated.
+    bool updateFood(const Food& food);
+    std::optional<long long> findFoodId(const std::string& barcode);
+    // Inserts a log row for an already resolved food id (used by batch writers).
+    bool insertLogRow(Date date, long long foodId, double grams);
+    // Days that can be logged: 35 years back to 5 years ahead of today (UTC).
+    // Every month logged gets a table in the daily_log view, which SQLite caps
+    // at 500 (LogPartitions.h); the window keeps stray dates from filling it.
+    static bool isLoggableDay(Date day);
+    WriteError lastWriteError() const { return writeError; }
     std::optional<Food> getFoodByBarcode(const std::string& barcode);
+    std::optional<Food> getFoodById(long long foodId);
+    // Full-text name search over foods_fts: every word of `query` must match a
+    // word prefix. Ranks (bm25) at most the first 2000 matches so very common
+    // prefixes stay cheap; an interrupted query returns no rows.
+    std::vector<Food> searchFoodsByName(const std::string& query, size_t limit);
     std::vector<LogEntry> getEntriesForDate(const std::string& date);
+    std::vector<LogEntry> getEntriesForDate(Date date);
+    // Same rows as getEntriesForDate without building LogEntry values: `visit`
+    // gets views of the food's name and barcode, valid only during the call,
+    // and its nutrition per 100 g.
+    using EntryVisitor = std::function<void(std::string_view name, std::string_view barcode, double grams,
+                                            const Nutrients& per100g)>;
+    bool visitEntriesForDate(Date date, const EntryVisitor& visit);
+    // The day's calories and macros as one vector, from the daily_totals rollup.
+    Nutrients getNutrientsForDate(const std::string& date);
+    Nutrients getNutrientsForDate(Date date);
+    DailyTotals getDailyTotals(const std::string& date);
+    DailyTotals getDailyTotals(Date date);
+    // One indexed range read over the daily_totals rollup, oldest first. Days
+    // without entries are omitted.
+    std::vector<DailyTotals> getDailyTotalsRange(const std::string& from, const std::string& to);
+    std::vector<DailyTotals> getDailyTotalsRange(Date from, Date to);
+    // Same range as getDailyTotalsRange, returned as columns for analytics.
+    NutritionSeries getNutritionSeries(const std::string& from, const std::string& to);
+    NutritionSeries getNutritionSeries(Date from, Date to);
+    // The `limit` foods contributing the most calories between `from` and `to`
+    // (inclusive), largest first.
+    std::vector<FoodUsage> getTopFoods(Date from, Date to, size_t limit);
+    bool rebuildDailyTotals();
     bool clearAllLogs();
     bool clearAllFoods();
+    // clearAllFoods, plus settings (the goal, retention), sync state and
+    // journal replay progress.
     bool factoryReset();
     bool setDailyGoal(double goal);
     double getDailyGoal();
+    // Log retention in whole months, counting the current one; 0 keeps everything.
+    bool setLogRetentionMonths(int months);
+    int getLogRetentionMonths();
+    // Drops the log partitions (and their daily_totals rows) of months that fell
+    // out of the retention window as of `today`, one short transaction per
+    // month. Returns the number of months dropped, or -1 on error.
+    int applyLogRetention(Date today);
+
+    bool beginTransaction();
+    bool commit();
+    bool rollback();
+    sqlite3* handle() const { return db; }
+
+    // Optional read-through cache in front of getFoodByBarcode.
+    void enableBarcodeCache(bool enabled);
+    const BarcodeCache* barcodeCache() const { return foodCache.get(); }
+    // Call after writing to foods through handle() directly.
+    void invalidateBarcodeCache();
+
+    // Loads every food into the barcode cache on a background thread with its
+    // own read-only connection (CatalogWarmup.h). Lookups read SQLite until the
+    // load is done and the cache from then on. Foods added or updated through
+    // this connection meanwhile are carried over; invalidateBarcodeCache()
+    // discards the load instead. Call after createTables().
+    bool startCatalogWarmup();
+    const CatalogWarmup* catalogWarmup() const { return warmup.get(); }
+
+    // Read-only catalog snapshot (see CatalogSnapshot.h) consulted when a
+    // barcode is not in foods. Logging such a barcode copies the food into foods.
+    bool attachSnapshot(const std::string& path);
+    void detachSnapshot();
+    const CatalogSnapshot* catalogSnapshot() const { return snapshot.get(); }
 
 private:
+    // Statements against one month's daily_log partition (LogPartitions.h).
+    struct PartitionStatements {
+        Statement insertLogRow;
+        Statement logFood;
+        Statement entriesForDate;
+    };
+
+    sqlite3_stmt* prepareCached(Statement& slot, const char* sql);
+    // Prepares `sqlTemplate` ("%T" = partition table) for `month`, creating the
+    // partition when `create` is set. Returns null on failure, with `missing`
+    // set when that is only because the partition does not exist (and `create`
+    // is unset).
+    sqlite3_stmt* preparePartition(int month, Statement PartitionStatements::*slot, const char* sqlTemplate,
+                                   bool create, bool& missing);
+    // Prepares the partition statement and returns `run(stmt)`, the final step
+    // result; the statement is reset afterwards. SQLITE_ERROR usually means
+    // another connection dropped the partition, so it is re-prepared and `run`
+    // retried once. A missing partition with `create` unset is SQLITE_DONE;
+    // any other prepare failure is SQLITE_ERROR.
+    int runOnPartition(int month, Statement PartitionStatements::*slot, const char* sqlTemplate, bool create,
+                       const std::function<int(sqlite3_stmt*)>& run);
+    bool copyFoodFromSnapshot(const std::string& barcode);
+    // Drops every log partition and food, then runs `extraSql`, all in one
+    // transaction.
+    bool clearLogsAndFoods(const char* extraSql);
+    // Switches to the warmed cache once it is ready; runs on this connection's thread.
+    void adoptWarmCatalog();
+
     std::string databasePath;
+    OpenProfile openProfile;
     sqlite3* db;
+    std::unique_ptr<BarcodeCache> foodCache;
+    std::unique_ptr<CatalogSnapshot> snapshot;
+    std::unique_ptr<CatalogWarmup> warmup;
+    bool warmupPending = false;         // started, not yet adopted
+    bool warmupStale = false;           // foods changed behind the cache meanwhile
+    std::vector<Food> warmupWrites;     // to apply on top of the loaded cache
+    WriteError writeError = WriteError::None;
+
+    // Prepared once per connection, reset after each call, finalized in close().
+    Statement addFoodStmt;
+    Statement updateFoodStmt;
+    Statement foodByBarcodeStmt;
+    Statement foodByIdStmt;
+    Statement nameSearchStmt;
+    Statement logFoodStmt;
+    Statement foodIdStmt;
+    Statement insertLogRowStmt;
+    Statement totalCaloriesStmt;
+    Statement entriesForDateStmt;
+    Statement dailyTotalsStmt;
+    Statement dailyTotalsRangeStmt;
+    Statement nutritionSeriesStmt;
+    Statement topFoodsStmt;
+    Statement setGoalStmt;
+    Statement getGoalStmt;
+    Statement setRetentionStmt;
+    Statement getRetentionStmt;
+    std::unordered_map<int, PartitionStatements> partitionStmts;   // by yyyymm
 };
\ No newline at end of file
@@ -0,0 +1,111 @@
+#pragma once
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+constexpr bool isLeapYear(int y) {
+    return (y % 4 == 0 && y % 100 != 0) || (y % 400 == 0);
+}
+
+constexpr int daysInMonth(int y, int m) {
+    constexpr int days[] = { 31,28,31,30,31,30,31,31,30,31,30,31 };
+    return m == 2 && isLeapYear(y) ? 29 : days[m - 1];
+}
+
+// A calendar day stored as days since 1970-01-01. This is the on-disk format of
+// daily_log.day and daily_totals.day; ISO "YYYY-MM-DD" strings are only used at
+// the API and UI edges.
+class Date {
+public:
+    constexpr Date() = default;
+
+    static constexpr Date fromDays(int32_t days) { return Date(days); }
+
+    // Caller guarantees a valid calendar date.
+    static constexpr Date fromYmd(int y, int m, int d) {
+        // Howard Hinnant's days_from_civil.
+        y -= m <= 2;
+        const int era = (y >= 0 ? y : y - 399) / 400;
+        const int yoe = y - era * 400;
+        const int doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+        const int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+        return Date(era * 146097 + doe - 719468);
+    }
+
+    // Parses and validates "YYYY-MM-DD" (years 0001-9999) without allocating.
+    static constexpr std::optional<Date> parse(std::string_view s) {
+        if (s.size() != 10 || s[4] != '-' || s[7] != '-') return std::nullopt;
+        for (int i = 0; i < 10; ++i) {
+            if (i == 4 || i == 7) continue;
+            if (s[i] < '0' || s[i] > '9') return std::nullopt;
+        }
+
+        const int y = (s[0] - '0') * 1000 + (s[1] - '0') * 100 + (s[2] - '0') * 10 + (s[3] - '0');
+        const int m = (s[5] - '0') * 10 + (s[6] - '0');
+        const int d = (s[8] - '0') * 10 + (s[9] - '0');
+
+        if (y < 1 || m < 1 || m > 12) return std::nullopt;
+        if (d < 1 || d > daysInMonth(y, m)) return std::nullopt;
+        return fromYmd(y, m, d);
+    }
+
+    constexpr int32_t days() const { return dayNumber; }
+
+    constexpr void ymd(int& y, int& m, int& d) const {
+        // Howard Hinnant's civil_from_days.
+        const int z = dayNumber + 719468;
+        const int era = (z >= 0 ? z : z - 146096) / 146097;
+        const int doe = z - era * 146097;
+        const int yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+        const int doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+        const int mp = (5 * doy + 2) / 153;
+        d = doy - (153 * mp + 2) / 5 + 1;
+        m = mp < 10 ? mp + 3 : mp - 9;
+        y = yoe + era * 400 + (m <= 2);
+    }
+
+    constexpr int year() const {
+        int y = 0, m = 0, d = 0;
+        ymd(y, m, d);
+        return y;
+    }
+
+    // Writes exactly 10 characters ("YYYY-MM-DD"), no terminator.
+    constexpr void format(char* out) const {
+        int y = 0, m = 0, d = 0;
+        ymd(y, m, d);
+        out[0] = static_cast<char>('0' + y / 1000 % 10);
+        out[1] = static_cast<char>('0' + y / 100 % 10);
+        out[2] = static_cast<char>('0' + y / 10 % 10);
+        out[3] = static_cast<char>('0' + y % 10);
+        out[4] = '-';
+        out[5] = static_cast<char>('0' + m / 10);
+        out[6] = static_cast<char>('0' + m % 10);
+        out[7] = '-';
+        out[8] = static_cast<char>('0' + d / 10);
+        out[9] = static_cast<char>('0' + d % 10);
+    }
+
+    std::string toString() const {
+        std::string s(10, '0');
+        format(&s[0]);
+        return s;
+    }
+
+    constexpr Date operator+(int32_t n) const { return Date(dayNumber + n); }
+    constexpr int32_t operator-(Date other) const { return dayNumber - other.dayNumber; }
+    constexpr bool operator==(Date other) const { return dayNumber == other.dayNumber; }
+    constexpr bool operator!=(Date other) const { return dayNumber != other.dayNumber; }
+    constexpr bool operator<(Date other) const { return dayNumber < other.dayNumber; }
+    constexpr bool operator<=(Date other) const { return dayNumber <= other.dayNumber; }
+
+private:
+    constexpr explicit Date(int32_t days) : dayNumber(days) {}
+
+    int32_t dayNumber = 0;
+};
+
+static_assert(Date::fromYmd(1970, 1, 1).days() == 0, "epoch");
+static_assert(Date::parse("2000-03-01")->days() == 11017, "parse");
+static_assert(!Date::parse("2023-02-29"), "leap validation");
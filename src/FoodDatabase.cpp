@@ -0,0 +1,96 @@
+#include "FoodDatabase.h"
+#include "Gtin.h"
+#include <iostream>
+
+std::optional<FoodItem> SqliteFoodDatabase::find(std::string_view barcode) {
+    key.assign(barcode);
+    current = db.getFoodByBarcode(key);
+    if (!current) return std::nullopt;
+    return FoodItem::from(*current);
+}
+
+bool SqliteFoodDatabase::add(const Food& food) {
+    return db.addFood(food);
+}
+
+bool SqliteFoodDatabase::update(const Food& food) {
+    return db.updateFood(food);
+}
+
+size_t SqliteFoodDatabase::size() {
+    sqlite3_stmt* stmt = nullptr;
+    long long count = 0;
+    if (sqlite3_prepare_v2(db.handle(), "SELECT count(*) FROM foods;", -1, &stmt, nullptr) == SQLITE_OK &&
+        sqlite3_step(stmt) == SQLITE_ROW) {
+        count = sqlite3_column_int64(stmt, 0);
+    }
+    sqlite3_finalize(stmt);
+    return static_cast<size_t>(count);
+}
+
+bool MemoryFoodDatabase::load(sqlite3* db) {
+    clear();
+
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db, "SELECT barcode, name, calories_per_100g, protein, carbs, fat FROM foods;",
+                           -1, &stmt, nullptr) != SQLITE_OK) {
+        std::cerr << "Food catalog load failed: " << sqlite3_errmsg(db) << "\n";
+        return false;
+    }
+
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        Food food;
+        food.barcode.assign(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0)),
+                            static_cast<size_t>(sqlite3_column_bytes(stmt, 0)));
+        food.name.assign(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1)),
+                         static_cast<size_t>(sqlite3_column_bytes(stmt, 1)));
+        food.calories_per_100g = sqlite3_column_double(stmt, 2);
+        food.protein = sqlite3_column_double(stmt, 3);
+        food.carbs = sqlite3_column_double(stmt, 4);
+        food.fat = sqlite3_column_double(stmt, 5);
+        add(food);
+    }
+    sqlite3_finalize(stmt);
+
+    if (rc != SQLITE_DONE) {
+        std::cerr << "Food catalog load failed: " << sqlite3_errmsg(db) << "\n";
+        clear();
+        return false;
+    }
+    return true;
+}
+
+void MemoryFoodDatabase::clear() {
+    index.clear();
+    records.clear();
+}
+
+std::optional<FoodItem> MemoryFoodDatabase::find(std::string_view barcode) {
+    auto it = index.find(normalizeBarcode(barcode));
+    if (it == index.end()) return std::nullopt;
+    return FoodItem::from(records[it->second]);
+}
+
+bool MemoryFoodDatabase::add(const Food& food) {
+    std::string barcode = normalizeBarcode(food.barcode);
+    if (index.count(barcode)) return false;
+    records.push_back(food);
+    records.back().barcode = std::move(barcode);
+    index.emplace(records.back().barcode, records.size() - 1);
+    return true;
+}
+
+bool MemoryFoodDatabase::update(const Food& food) {
+    auto it = index.find(normalizeBarcode(food.barcode));
+    if (it == index.end()) return false;
+
+    // The barcode, and so the index key viewing it, stays as it is.
+    Food& record = records[it->second];
+    record.name = food.name;
+    record.calories_per_100g = food.calories_per_100g;
+    record.protein = food.protein;
+    record.carbs = food.carbs;
+    record.fat = food.fat;
+    return true;
+}
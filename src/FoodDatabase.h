@@ -0,0 +1,60 @@
+#pragma once
+#include <deque>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include "DatabaseManager.h"
+#include "FoodItem.h"
+
+// Catalog facade for the domain layer: the same lookups whether the foods live
+// in a tracker database or only in memory (tests, tools, a catalog loaded once
+// and served without SQLite).
+class FoodDatabase {
+public:
+    virtual ~FoodDatabase() = default;
+
+    // The item's views stay valid until the next call on this catalog.
+    virtual std::optional<FoodItem> find(std::string_view barcode) = 0;
+    // Fails when the barcode is already present.
+    virtual bool add(const Food& food) = 0;
+    // Replaces name and nutrition by barcode; fails for unknown barcodes.
+    virtual bool update(const Food& food) = 0;
+    virtual size_t size() = 0;
+};
+
+// Backed by a tracker database through its DatabaseManager, so the barcode
+// cache, catalog snapshot and recipe refresh all apply.
+class SqliteFoodDatabase : public FoodDatabase {
+public:
+    explicit SqliteFoodDatabase(DatabaseManager& db) : db(db) {}
+
+    std::optional<FoodItem> find(std::string_view barcode) override;
+    bool add(const Food& food) override;
+    bool update(const Food& food) override;
+    size_t size() override;
+
+private:
+    DatabaseManager& db;
+    std::string key;                // reused so lookups do not reallocate it
+    std::optional<Food> current;    // what the last find() returned views of
+};
+
+// Foods held in memory. Records never move, so items found stay valid until
+// that food is updated or the catalog is cleared. Barcodes are normalized like
+// DatabaseManager's, so both catalogs find a food by the same codes.
+class MemoryFoodDatabase : public FoodDatabase {
+public:
+    // Replaces the contents with every row of `db`'s foods table.
+    bool load(sqlite3* db);
+    void clear();
+
+    std::optional<FoodItem> find(std::string_view barcode) override;
+    bool add(const Food& food) override;
+    bool update(const Food& food) override;
+    size_t size() override { return records.size(); }
+
+private:
+    std::deque<Food> records;
+    std::unordered_map<std::string_view, size_t> index;   // views of records[i].barcode
+};
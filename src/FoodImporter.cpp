@@ -0,0 +1,454 @@
+#include "FoodImporter.h"
+#include "Gtin.h"
+#include "JsonEscape.h"
+#include "Migrations.h"
+#include "Recipes.h"
+#include "SqlExec.h"
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+namespace {
+
+// Hands out complete lines from a large read buffer without copying them.
+class LineReader {
+public:
+    explicit LineReader(const std::string& path)
+        : in(path, std::ios::binary), buffer(1 << 20) {}
+
+    bool good() const { return static_cast<bool>(in) || eof; }
+
+    bool next(std::string_view& line) {
+        while (true) {
+            const char* start = buffer.data() + begin;
+            const void* nl = std::memchr(start, '\n', end - begin);
+            if (nl) {
+                size_t len = static_cast<const char*>(nl) - start;
+                line = trimCr(std::string_view(start, len));
+                begin += len + 1;
+                return true;
+            }
+
+            if (eof) {
+                if (begin == end) return false;
+                line = trimCr(std::string_view(start, end - begin));
+                begin = end;
+                return true;
+            }
+
+            refill();
+        }
+    }
+
+private:
+    static std::string_view trimCr(std::string_view s) {
+        if (!s.empty() && s.back() == '\r') s.remove_suffix(1);
+        return s;
+    }
+
+    void refill() {
+        size_t pending = end - begin;
+        if (begin > 0) {
+            std::memmove(buffer.data(), buffer.data() + begin, pending);
+            begin = 0;
+            end = pending;
+        }
+        if (end == buffer.size()) {
+            buffer.resize(buffer.size() * 2);   // a single line longer than the buffer
+        }
+
+        in.read(buffer.data() + end, static_cast<std::streamsize>(buffer.size() - end));
+        end += static_cast<size_t>(in.gcount());
+        if (!in) eof = true;
+    }
+
+    std::ifstream in;
+    std::vector<char> buffer;
+    size_t begin = 0;
+    size_t end = 0;
+    bool eof = false;
+};
+
+std::string_view trim(std::string_view s) {
+    while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) s.remove_prefix(1);
+    while (!s.empty() && (s.back() == ' ' || s.back() == '\t')) s.remove_suffix(1);
+    return s;
+}
+
+// Returns false for malformed numbers; an empty field leaves `present` false.
+bool parseNumber(std::string_view s, double& out, bool& present) {
+    s = trim(s);
+    present = !s.empty();
+    if (!present) return true;
+    if (s.front() == '+') s.remove_prefix(1);
+    auto res = std::from_chars(s.data(), s.data() + s.size(), out);
+    return res.ec == std::errc() && res.ptr == s.data() + s.size();
+}
+
+class CsvParser {
+public:
+    // Splits one line into fields. Quoted fields are returned as views unless they
+    // contain doubled quotes, in which case they are unescaped into scratch storage.
+    bool parse(std::string_view line, FoodRecordView& out) {
+        std::string_view fields[6];
+        size_t count = 0;
+        size_t pos = 0;
+
+        while (count < 6) {
+            std::string_view field;
+            if (pos < line.size() && line[pos] == '"') {
+                if (!parseQuoted(line, pos, scratch[count < 2 ? count : 2], field)) return false;
+            } else {
+                size_t comma = line.find(',', pos);
+                size_t stop = comma == std::string_view::npos ? line.size() : comma;
+                field = trim(line.substr(pos, stop - pos));
+                pos = stop;
+            }
+            fields[count++] = field;
+
+            if (pos >= line.size()) break;
+            if (line[pos] != ',') return false;
+            ++pos;
+        }
+
+        if (count < 3) return false;
+
+        out = FoodRecordView{};
+        out.barcode = fields[0];
+        out.name = fields[1];
+
+        bool present = false;
+        if (!parseNumber(fields[2], out.calories_per_100g, present) || !present) return false;
+        if (count > 3 && !parseNumber(fields[3], out.protein, out.hasProtein)) return false;
+        if (count > 4 && !parseNumber(fields[4], out.carbs, out.hasCarbs)) return false;
+        if (count > 5 && !parseNumber(fields[5], out.fat, out.hasFat)) return false;
+        return true;
+    }
+
+    static bool isHeader(std::string_view line) {
+        return line.substr(0, 7) == "barcode" || line.substr(0, 9) == "\"barcode\"";
+    }
+
+private:
+    static bool parseQuoted(std::string_view line, size_t& pos, std::string& scratch, std::string_view& field) {
+        size_t start = ++pos;
+        bool escaped = false;
+        while (true) {
+            size_t q = line.find('"', pos);
+            if (q == std::string_view::npos) return false;   // embedded newlines are not supported
+            if (q + 1 < line.size() && line[q + 1] == '"') {
+                escaped = true;
+                pos = q + 2;
+                continue;
+            }
+            field = line.substr(start, q - start);
+            pos = q + 1;
+            break;
+        }
+
+        if (escaped) {
+            scratch.clear();
+            for (size_t i = 0; i < field.size(); ++i) {
+                scratch.push_back(field[i]);
+                if (field[i] == '"') ++i;
+            }
+            field = scratch;
+        }
+
+        while (pos < line.size() && (line[pos] == ' ' || line[pos] == '\t')) ++pos;
+        return true;
+    }
+
+    std::string scratch[3];
+};
+
+class JsonlParser {
+public:
+    bool parse(std::string_view line, FoodRecordView& out) {
+        out = FoodRecordView{};
+        bool hasBarcode = false, hasName = false, hasCalories = false;
+
+        size_t pos = 0;
+        skipWs(line, pos);
+        if (pos >= line.size() || line[pos] != '{') return false;
+        ++pos;
+
+        while (true) {
+            skipWs(line, pos);
+            if (pos >= line.size()) return false;
+            if (line[pos] == '}') break;
+
+            std::string_view key;
+            if (!parseString(line, pos, keyScratch, key)) return false;
+            skipWs(line, pos);
+            if (pos >= line.size() || line[pos] != ':') return false;
+            ++pos;
+            skipWs(line, pos);
+            if (pos >= line.size()) return false;
+
+            std::string_view value;
+            bool isString = line[pos] == '"';
+            if (isString) {
+                std::string& scratch = key == "barcode" ? barcodeScratch
+                                     : key == "name" ? nameScratch : otherScratch;
+                if (!parseString(line, pos, scratch, value)) return false;
+            } else {
+                size_t start = pos;
+                while (pos < line.size() && line[pos] != ',' && line[pos] != '}' &&
+                       line[pos] != ' ' && line[pos] != '\t') {
+                    if (line[pos] == '{' || line[pos] == '[') return false;   // nested values are not catalog fields
+                    ++pos;
+                }
+                value = line.substr(start, pos - start);
+            }
+
+            if (key == "barcode") {
+                out.barcode = value;
+                hasBarcode = true;
+            } else if (key == "name") {
+                out.name = value;
+                hasName = isString;
+            } else if (key == "calories_per_100g") {
+                if (isString || !parseNumber(value, out.calories_per_100g, hasCalories)) return false;
+            } else if (key == "protein") {
+                if (!parseOptional(value, isString, out.protein, out.hasProtein)) return false;
+            } else if (key == "carbs") {
+                if (!parseOptional(value, isString, out.carbs, out.hasCarbs)) return false;
+            } else if (key == "fat") {
+                if (!parseOptional(value, isString, out.fat, out.hasFat)) return false;
+            }
+
+            skipWs(line, pos);
+            if (pos < line.size() && line[pos] == ',') {
+                ++pos;
+                continue;
+            }
+            if (pos < line.size() && line[pos] == '}') break;
+            return false;
+        }
+
+        return hasBarcode && hasName && hasCalories;
+    }
+
+private:
+    static void skipWs(std::string_view s, size_t& pos) {
+        while (pos < s.size() && (s[pos] == ' ' || s[pos] == '\t')) ++pos;
+    }
+
+    static bool parseOptional(std::string_view value, bool isString, double& out, bool& present) {
+        if (isString) return false;
+        if (value == "null") {
+            present = false;
+            return true;
+        }
+        return parseNumber(value, out, present);
+    }
+
+    // Returns a view into the line when the string has no escapes, otherwise
+    // decodes it into `scratch`.
+    static bool parseString(std::string_view s, size_t& pos, std::string& scratch, std::string_view& out) {
+        if (pos >= s.size() || s[pos] != '"') return false;
+        size_t start = ++pos;
+        while (pos < s.size() && s[pos] != '"' && s[pos] != '\\') ++pos;
+        if (pos >= s.size()) return false;
+        if (s[pos] == '"') {
+            out = s.substr(start, pos - start);
+            ++pos;
+            return true;
+        }
+
+        scratch.assign(s.data() + start, pos - start);
+        while (pos < s.size() && s[pos] != '"') {
+            char c = s[pos++];
+            if (c != '\\') {
+                scratch.push_back(c);
+                continue;
+            }
+            if (!decodeJsonEscape(s, pos, scratch)) return false;
+        }
+        if (pos >= s.size()) return false;
+        ++pos;
+        out = scratch;
+        return true;
+    }
+
+    std::string keyScratch, barcodeScratch, nameScratch, otherScratch;
+};
+
+const char* insertSqlFor(ConflictPolicy policy) {
+    switch (policy) {
+        case ConflictPolicy::Skip:
+            return "INSERT INTO foods (barcode, name, calories_per_100g, protein, carbs, fat) "
+                   "VALUES (?, ?, ?, ?, ?, ?) ON CONFLICT(barcode) DO NOTHING;";
+        case ConflictPolicy::Replace:
+            // An upsert keeps the row id, so existing daily_log rows stay attached.
+            // Recipes keep their computed values and count as skipped.
+            return "INSERT INTO foods (barcode, name, calories_per_100g, protein, carbs, fat) "
+                   "VALUES (?, ?, ?, ?, ?, ?) ON CONFLICT(barcode) DO UPDATE SET "
+                   "name = excluded.name, calories_per_100g = excluded.calories_per_100g, "
+                   "protein = excluded.protein, carbs = excluded.carbs, fat = excluded.fat "
+                   "WHERE foods.id NOT IN (SELECT food_id FROM recipes);";
+        case ConflictPolicy::Fail:
+        default:
+            return "INSERT INTO foods (barcode, name, calories_per_100g, protein, carbs, fat) "
+                   "VALUES (?, ?, ?, ?, ?, ?);";
+    }
+}
+
+void bindOptional(sqlite3_stmt* stmt, int index, double value, bool present) {
+    if (present) sqlite3_bind_double(stmt, index, value);
+    else sqlite3_bind_null(stmt, index);
+}
+
+bool endsWith(const std::string& s, const char* suffix) {
+    size_t n = std::strlen(suffix);
+    return s.size() >= n && s.compare(s.size() - n, n, suffix) == 0;
+}
+
+} // namespace
+
+bool parseConflictPolicy(const std::string& text, ConflictPolicy& out) {
+    if (text == "skip") out = ConflictPolicy::Skip;
+    else if (text == "replace") out = ConflictPolicy::Replace;
+    else if (text == "fail") out = ConflictPolicy::Fail;
+    else return false;
+    return true;
+}
+
+FoodImporter::FoodImporter(DatabaseManager& db)
+    : database(db) {}
+
+ImportStats FoodImporter::importFile(const std::string& path, const ImportOptions& options) {
+    ImportStats stats;
+    auto started = std::chrono::steady_clock::now();
+    auto finish = [&]() -> ImportStats& {
+        stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+        return stats;
+    };
+
+    LineReader reader(path);
+    if (!reader.good()) {
+        stats.error = "cannot open " + path;
+        return finish();
+    }
+
+    ImportFormat format = options.format;
+    if (format == ImportFormat::Auto) {
+        format = endsWith(path, ".jsonl") || endsWith(path, ".json") ? ImportFormat::Jsonl : ImportFormat::Csv;
+    }
+
+    sqlite3* db = database.handle();
+    // Replaced rows would otherwise be served stale from the lookup cache.
+    database.invalidateBarcodeCache();
+
+    Statement insert;
+    if (!insert.prepare(db, insertSqlFor(options.onConflict))) {
+        stats.error = std::string("prepare failed: ") + sqlite3_errmsg(db);
+        return finish();
+    }
+    sqlite3_stmt* stmt = insert.get();
+
+    // New rows are added to foods_fts in one statement per batch, and recipes
+    // using replaced foods are recomputed once per batch.
+    auto commitBatch = [&] {
+        if (!execSql(db, flushFoodSearchSyncSql) || refreshRecipes(database) < 0) {
+            database.rollback();
+            return false;
+        }
+        return database.commit();
+    };
+
+    CsvParser csv;
+    JsonlParser jsonl;
+    const long long batchSize = options.batchSize > 0 ? options.batchSize : 1;
+    long long inBatch = 0;
+    long long lineNumber = 0;
+    bool inTransaction = false;
+    FoodRecordView row;
+    std::string_view line;
+    std::string barcode;
+
+    while (reader.next(line)) {
+        ++lineNumber;
+        if (trim(line).empty()) continue;
+        if (format == ImportFormat::Csv && lineNumber == 1 && CsvParser::isHeader(line)) continue;
+
+        ++stats.rowsRead;
+        bool parsed = format == ImportFormat::Csv ? csv.parse(line, row) : jsonl.parse(line, row);
+        if (!parsed || row.barcode.empty() || row.name.empty()) {
+            if (stats.rowsRejected++ < 10) {
+                std::cerr << "Rejected line " << lineNumber << ": malformed row\n";
+            }
+            continue;
+        }
+
+        if (!inTransaction) {
+            if (!database.beginTransaction()) {
+                stats.error = "could not begin transaction";
+                return finish();
+            }
+            if (!execSql(db, deferFoodSearchSyncSql)) {
+                database.rollback();
+                stats.error = "could not defer name index updates";
+                return finish();
+            }
+            inTransaction = true;
+        }
+
+        // Same normalization as DatabaseManager, so variants of a GTIN conflict.
+        barcode = normalizeBarcode(row.barcode);
+        sqlite3_bind_text(stmt, 1, barcode.data(), static_cast<int>(barcode.size()), SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 2, row.name.data(), static_cast<int>(row.name.size()), SQLITE_STATIC);
+        sqlite3_bind_double(stmt, 3, row.calories_per_100g);
+        bindOptional(stmt, 4, row.protein, row.hasProtein);
+        bindOptional(stmt, 5, row.carbs, row.hasCarbs);
+        bindOptional(stmt, 6, row.fat, row.hasFat);
+
+        int rc = sqlite3_step(stmt);
+        int extended = sqlite3_extended_errcode(db);
+        sqlite3_reset(stmt);
+
+        if (rc == SQLITE_DONE) {
+            if (sqlite3_changes(db) > 0) ++stats.rowsWritten;
+            else ++stats.rowsSkipped;
+        } else if (rc == SQLITE_CONSTRAINT) {
+            if (options.onConflict == ConflictPolicy::Fail && extended == SQLITE_CONSTRAINT_UNIQUE) {
+                database.rollback();
+                stats.error = "duplicate barcode " + std::string(row.barcode) + " on line " + std::to_string(lineNumber)
+                    + "; current batch rolled back";
+                return finish();
+            }
+            if (stats.rowsRejected++ < 10) {
+                std::cerr << "Rejected line " << lineNumber << ": " << sqlite3_errmsg(db) << "\n";
+            }
+        } else {
+            database.rollback();
+            stats.error = std::string("insert failed: ") + sqlite3_errmsg(db);
+            return finish();
+        }
+
+        if (++inBatch >= batchSize) {
+            if (!commitBatch()) {
+                stats.error = "commit failed";
+                return finish();
+            }
+            inTransaction = false;
+            inBatch = 0;
+            ++stats.batches;
+        }
+    }
+
+    if (inTransaction) {
+        if (!commitBatch()) {
+            stats.error = "commit failed";
+            return finish();
+        }
+        ++stats.batches;
+    }
+
+    stats.completed = true;
+    return finish();
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include "DatabaseManager.h"
+
+enum class ImportFormat { Auto, Csv, Jsonl };
+
+// What to do when a row's barcode already exists in foods.
+enum class ConflictPolicy { Skip, Replace, Fail };
+
+struct ImportOptions {
+    ImportFormat format = ImportFormat::Auto;
+    ConflictPolicy onConflict = ConflictPolicy::Skip;
+    long long batchSize = 50000;
+};
+
+struct ImportStats {
+    long long rowsRead = 0;
+    long long rowsWritten = 0;   // inserted, or inserted/updated with Replace
+    long long rowsSkipped = 0;   // barcode already present with Skip
+    long long rowsRejected = 0;  // malformed rows or rows failing constraints
+    long long batches = 0;
+    double seconds = 0.0;
+    bool completed = false;
+    std::string error;
+
+    double rowsPerSecond() const { return seconds > 0 ? rowsRead / seconds : 0.0; }
+};
+
+// A parsed catalog row. The string views point into the importer's read buffer
+// and are only valid until the next row is parsed.
+struct FoodRecordView {
+    std::string_view barcode;
+    std::string_view name;
+    double calories_per_100g = 0.0;
+    double protein = 0.0;
+    double carbs = 0.0;
+    double fat = 0.0;
+    bool hasProtein = false;
+    bool hasCarbs = false;
+    bool hasFat = false;
+};
+
+// Streams a CSV or JSONL catalog into the foods table using one bound statement
+// and one explicit transaction per batch.
+//
+// CSV columns: barcode,name,calories_per_100g,protein,carbs,fat (header optional).
+// JSONL: one object per line with the same keys.
+class FoodImporter {
+public:
+    explicit FoodImporter(DatabaseManager& db);
+
+    ImportStats importFile(const std::string& path, const ImportOptions& options);
+
+private:
+    DatabaseManager& database;
+};
+
+bool parseConflictPolicy(const std::string& text, ConflictPolicy& out);
@@ -0,0 +1,18 @@
+#include "FoodItem.h"
+#include "DatabaseManager.h"
+
+FoodItem FoodItem::from(const Food& food) {
+    FoodItem item;
+    item.barcode = food.barcode;
+    item.name = food.name;
+    item.per100g.lane[Nutrients::Calories] = food.calories_per_100g;
+    item.per100g.lane[Nutrients::Protein] = food.protein;
+    item.per100g.lane[Nutrients::Carbs] = food.carbs;
+    item.per100g.lane[Nutrients::Fat] = food.fat;
+    return item;
+}
+
+Food FoodItem::toFood() const {
+    return Food{ std::string(barcode), std::string(name), per100g.calories(), per100g.protein(), per100g.carbs(),
+                 per100g.fat() };
+}
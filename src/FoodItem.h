@@ -0,0 +1,20 @@
+#pragma once
+#include <string_view>
+#include "Nutrients.h"
+
+struct Food;
+
+// A food as the in-memory domain layer sees it: barcode and name are views of
+// storage owned elsewhere (a FoodDatabase, a UserDayLog arena), nutrition is
+// one per-100 g vector. Copying an item never allocates.
+struct FoodItem {
+    std::string_view barcode;
+    std::string_view name;
+    Nutrients per100g;
+
+    // Views `food`'s strings; valid while `food` is alive and unchanged.
+    static FoodItem from(const Food& food);
+    Food toFood() const;
+
+    Nutrients nutrientsFor(double grams) const { return per100g.scaledTo(grams); }
+};
@@ -0,0 +1,83 @@
+#include "FoodSearch.h"
+#include <unordered_set>
+
+using SteadyClock = std::chrono::steady_clock;
+
+namespace {
+
+// Aborts the running statement once the deadline passes.
+int deadlineHandler(void* arg) {
+    return SteadyClock::now() >= *static_cast<SteadyClock::time_point*>(arg) ? 1 : 0;
+}
+
+} // namespace
+
+FoodSearch::FoodSearch(DatabaseManager& db) : database(db) {}
+
+bool FoodSearch::buildIndex() {
+    if (!database.handle()) return false;
+    return index.build(database.handle());
+}
+
+SearchResult FoodSearch::search(const std::string& query, size_t limit, std::chrono::microseconds budget) {
+    const SteadyClock::time_point start = SteadyClock::now();
+    const SteadyClock::time_point deadline = start + budget;
+
+    // Full-text gets half the budget so a slow ranking pass still leaves time
+    // for the fuzzy stage.
+    SearchResult result = fullText(query, limit, start + budget / 2);
+    if (result.hits.size() < limit && hasIndex()) {
+        addFuzzy(result, query, limit, deadline);
+    }
+    return result;
+}
+
+SearchResult FoodSearch::searchFullText(const std::string& query, size_t limit, std::chrono::microseconds budget) {
+    return fullText(query, limit, SteadyClock::now() + budget);
+}
+
+SearchResult FoodSearch::searchFuzzy(const std::string& query, size_t limit, std::chrono::microseconds budget) {
+    SearchResult result;
+    addFuzzy(result, query, limit, SteadyClock::now() + budget);
+    return result;
+}
+
+SearchResult FoodSearch::fullText(const std::string& query, size_t limit, SteadyClock::time_point deadline) {
+    SearchResult result;
+    sqlite3* db = database.handle();
+    if (!db) return result;
+
+    // Checked every 1000 VM instructions; bm25 over a very common prefix is
+    // the slow case this guards against.
+    sqlite3_progress_handler(db, 1000, deadlineHandler, &deadline);
+    std::vector<Food> foods = database.searchFoodsByName(query, limit);
+    sqlite3_progress_handler(db, 0, nullptr, nullptr);
+
+    if (foods.empty() && SteadyClock::now() >= deadline) result.truncated = true;
+
+    result.hits.reserve(foods.size());
+    for (Food& f : foods) {
+        result.hits.push_back({ std::move(f), false, 1.0 });
+    }
+    return result;
+}
+
+void FoodSearch::addFuzzy(SearchResult& result, const std::string& query, size_t limit,
+                          SteadyClock::time_point deadline) {
+    std::unordered_set<std::string> seen;
+    for (const SearchHit& hit : result.hits) seen.insert(hit.food.barcode);
+
+    // Ask for extra matches so duplicates of full-text hits can be skipped.
+    TrigramIndex::Result matches = index.search(query, limit + result.hits.size(), deadline);
+    if (matches.truncated) result.truncated = true;
+
+    for (const TrigramIndex::Match& m : matches.matches) {
+        if (result.hits.size() >= limit) break;
+
+        auto food = database.getFoodById(m.foodId);
+        if (!food || !seen.insert(food->barcode).second) continue;
+
+        double similarity = static_cast<double>(m.shared) / m.queryTrigrams;
+        result.hits.push_back({ std::move(*food), true, similarity });
+    }
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <chrono>
+#include <string>
+#include <vector>
+#include "DatabaseManager.h"
+#include "TrigramIndex.h"
+
+struct SearchHit {
+    Food food;
+    bool fuzzy = false;       // from the trigram index rather than FTS5
+    double similarity = 1.0;  // shared query trigrams for fuzzy hits, 1.0 otherwise
+};
+
+struct SearchResult {
+    std::vector<SearchHit> hits;
+    bool truncated = false;   // the latency budget cut a stage short
+};
+
+// Name search over the foods catalog. Full-text (FTS5) hits rank first; when
+// they do not fill `limit`, the in-process trigram index adds typo-tolerant
+// prefix matches. Both stages share one latency budget.
+class FoodSearch {
+public:
+    explicit FoodSearch(DatabaseManager& db);
+
+    // Snapshots foods.name into the trigram index. Without it, search() only
+    // returns full-text hits.
+    bool buildIndex();
+    bool hasIndex() const { return index.size() > 0; }
+    const TrigramIndex& trigramIndex() const { return index; }
+
+    SearchResult search(const std::string& query, size_t limit,
+                        std::chrono::microseconds budget = std::chrono::milliseconds(50));
+    SearchResult searchFullText(const std::string& query, size_t limit, std::chrono::microseconds budget);
+    SearchResult searchFuzzy(const std::string& query, size_t limit, std::chrono::microseconds budget);
+
+private:
+    SearchResult fullText(const std::string& query, size_t limit, std::chrono::steady_clock::time_point deadline);
+    void addFuzzy(SearchResult& result, const std::string& query, size_t limit,
+                  std::chrono::steady_clock::time_point deadline);
+
+    DatabaseManager& database;
+    TrigramIndex index;
+};
@@ -0,0 +1,186 @@
+#include "Gtin.h"
+#include "BarcodeKey.h"
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CALORIE_GTIN_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+const uint64_t kGtin14Tag = 14ULL << 59;   // packBarcode's length bits for 14 digits
+
+bool isGtinLength(size_t n) {
+    return n == 8 || n == 12 || n == 13 || n == 14;
+}
+
+// Value of a GTIN with a valid check digit; false for anything else.
+bool gtinValue(const char* digits, size_t n, uint64_t& value) {
+    if (!isGtinLength(n)) return false;
+
+    uint64_t v = 0;
+    unsigned sum = 0;
+    for (size_t i = 0; i < n; ++i) {
+        const unsigned d = static_cast<unsigned char>(digits[i]) - '0';
+        if (d > 9) return false;
+        v = v * 10 + d;
+        sum += (n - i) % 2 == 0 ? 3 * d : d;   // the check digit itself has weight 1
+    }
+    if (sum % 10 != 0) return false;
+    value = v;
+    return true;
+}
+
+bool isNoise(char c) {
+    return static_cast<unsigned char>(c) <= ' ' || c == 0x7f;
+}
+
+std::string_view trimNoise(std::string_view raw) {
+    while (!raw.empty() && isNoise(raw.front())) raw.remove_prefix(1);
+    while (!raw.empty() && isNoise(raw.back())) raw.remove_suffix(1);
+    // AIM symbology identifier sent by scanners in front of the data: "]E0", "]C1", ...
+    if (raw.size() > 3 && raw[0] == ']') raw.remove_prefix(3);
+    return raw;
+}
+
+// Collects the digits of `text` if it is only digits with single spaces or
+// dashes between them, at most 14 of them.
+bool collectDigits(std::string_view text, char (&digits)[14], size_t& n) {
+    n = 0;
+    bool separated = false;
+    for (char c : text) {
+        if (c >= '0' && c <= '9') {
+            if (n == 14) return false;
+            digits[n++] = c;
+            separated = false;
+        } else if ((c == ' ' || c == '-') && n > 0 && !separated) {
+            separated = true;
+        } else {
+            return false;
+        }
+    }
+    return !separated;
+}
+
+void writeGtin14(uint64_t value, char* out) {
+    for (int i = 13; i >= 0; --i) {
+        out[i] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    }
+}
+
+#ifdef CALORIE_GTIN_SSE2
+
+// One code, right-aligned into 16 lanes behind leading '0's so every length
+// shares the same digit weights. 0 when invalid.
+uint64_t gtinKeySse2(std::string_view code) {
+    if (!isGtinLength(code.size())) return 0;
+
+    alignas(16) char lanes[16];
+    std::memset(lanes, '0', sizeof(lanes));
+    std::memcpy(lanes + 16 - code.size(), code.data(), code.size());
+
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i d = _mm_sub_epi8(_mm_load_si128(reinterpret_cast<const __m128i*>(lanes)), _mm_set1_epi8('0'));
+    const __m128i bad = _mm_or_si128(_mm_cmplt_epi8(d, zero), _mm_cmpgt_epi8(d, _mm_set1_epi8(9)));
+    if (_mm_movemask_epi8(bad) != 0) return 0;
+
+    const __m128i hiDigits = _mm_unpacklo_epi8(d, zero);   // lanes 0-7, most significant
+    const __m128i loDigits = _mm_unpackhi_epi8(d, zero);   // lanes 8-15
+
+    // Check digit: weights 3, 1, ... from the right, 1 for the check digit itself.
+    __m128i sum = _mm_add_epi32(_mm_madd_epi16(hiDigits, _mm_setr_epi16(3, 1, 3, 1, 3, 1, 3, 1)),
+                                _mm_madd_epi16(loDigits, _mm_setr_epi16(3, 1, 3, 1, 3, 1, 3, 1)));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+    if (_mm_cvtsi128_si32(sum) % 10 != 0) return 0;
+
+    // Value: pairs of digits, then groups of 4 and 8, each step one multiply-add.
+    const __m128i tens = _mm_setr_epi16(10, 1, 10, 1, 10, 1, 10, 1);
+    const __m128i pairs = _mm_packs_epi32(_mm_madd_epi16(hiDigits, tens), _mm_madd_epi16(loDigits, tens));
+    const __m128i quads = _mm_madd_epi16(pairs, _mm_setr_epi16(100, 1, 100, 1, 100, 1, 100, 1));
+    const __m128i octets = _mm_madd_epi16(_mm_packs_epi32(quads, quads),
+                                          _mm_setr_epi16(10000, 1, 10000, 1, 10000, 1, 10000, 1));
+    const uint64_t high = static_cast<uint32_t>(_mm_cvtsi128_si32(octets));
+    const uint64_t low = static_cast<uint32_t>(_mm_cvtsi128_si32(_mm_srli_si128(octets, 4)));
+    return kGtin14Tag | (high * 100000000ULL + low);
+}
+
+#endif
+
+} // namespace
+
+bool isValidGtin(std::string_view digits) {
+    uint64_t value = 0;
+    return gtinValue(digits.data(), digits.size(), value);
+}
+
+std::string normalizeBarcode(std::string_view raw) {
+    const std::string_view text = trimNoise(raw);
+    char digits[14];
+    size_t n = 0;
+    uint64_t value = 0;
+    if (collectDigits(text, digits, n) && gtinValue(digits, n, value)) {
+        std::string gtin(14, '0');
+        writeGtin14(value, &gtin[0]);
+        return gtin;
+    }
+    return std::string(text);
+}
+
+bool normalizedBarcodeKey(std::string_view raw, uint64_t& key) {
+    const std::string_view text = trimNoise(raw);
+    char digits[14];
+    size_t n = 0;
+    uint64_t value = 0;
+    if (collectDigits(text, digits, n) && gtinValue(digits, n, value)) {
+        key = kGtin14Tag | value;
+        return true;
+    }
+    return packBarcode(text, key);
+}
+
+size_t gtinKeysScalar(const std::string_view* codes, size_t count, uint64_t* keys) {
+    size_t valid = 0;
+    for (size_t i = 0; i < count; ++i) {
+        uint64_t value = 0;
+        keys[i] = gtinValue(codes[i].data(), codes[i].size(), value) ? kGtin14Tag | value : 0;
+        valid += keys[i] != 0;
+    }
+    return valid;
+}
+
+size_t gtinKeys(const std::string_view* codes, size_t count, uint64_t* keys) {
+#ifdef CALORIE_GTIN_SSE2
+    size_t valid = 0;
+    for (size_t i = 0; i < count; ++i) {
+        keys[i] = gtinKeySse2(codes[i]);
+        valid += keys[i] != 0;
+    }
+    return valid;
+#else
+    return gtinKeysScalar(codes, count, keys);
+#endif
+}
+
+std::string gtin14FromKey(uint64_t key) {
+    std::string gtin(14, '0');
+    writeGtin14(key & ~kGtin14Tag, &gtin[0]);
+    return gtin;
+}
+
+bool registerGtinFunctions(sqlite3* db) {
+    auto normalize = [](sqlite3_context* ctx, int, sqlite3_value** args) {
+        if (sqlite3_value_type(args[0]) == SQLITE_NULL) {
+            sqlite3_result_null(ctx);
+            return;
+        }
+        const auto* text = reinterpret_cast<const char*>(sqlite3_value_text(args[0]));
+        const std::string normalized =
+            normalizeBarcode(std::string_view(text, static_cast<size_t>(sqlite3_value_bytes(args[0]))));
+        sqlite3_result_text(ctx, normalized.data(), static_cast<int>(normalized.size()), SQLITE_TRANSIENT);
+    };
+    return sqlite3_create_function_v2(db, "gtin_normalize", 1, SQLITE_UTF8 | SQLITE_DETERMINISTIC, nullptr,
+                                      normalize, nullptr, nullptr, nullptr) == SQLITE_OK;
+}
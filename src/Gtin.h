@@ -0,0 +1,42 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include "sqlite3.h"
+
+// Barcode normalization for every code entering the tracker. UPC-A (12
+// digits), EAN-13, EAN-8 and GTIN-14 codes of one product differ only in
+// leading zeros, so once the check digit is verified they are stored and
+// looked up as one 14-digit GTIN. Anything that is not a GTIN (in-store codes,
+// recipes, a misread check digit) is kept as given, minus scanner noise.
+//
+// Keys are packBarcode() (BarcodeKey.h) of the normalized text, so they match
+// the barcode cache and catalog snapshots.
+
+// GS1 check for 8, 12, 13 or 14 digits: the last digit against the others
+// weighted 3, 1, 3, ... from the right.
+bool isValidGtin(std::string_view digits);
+
+// Drops scanner noise (surrounding whitespace and control characters, an AIM
+// symbology prefix such as "]E0", spaces and dashes between digits) and
+// returns the GTIN-14 of a valid GTIN, or the trimmed text otherwise.
+std::string normalizeBarcode(std::string_view raw);
+
+// packBarcode(normalizeBarcode(raw)) without allocating; false when the
+// normalized code is not numeric.
+bool normalizedBarcodeKey(std::string_view raw, uint64_t& key);
+
+// Batch path for clean codes, as read from a catalog file: keys[i] is the
+// packed GTIN-14 of codes[i], or 0 when it is not a valid GTIN-8/12/13/14
+// (noise is not removed here). Returns the number of valid codes. Parses and
+// checks each code with SSE2 where the target has it; the scalar version is
+// the fallback and the reference.
+size_t gtinKeys(const std::string_view* codes, size_t count, uint64_t* keys);
+size_t gtinKeysScalar(const std::string_view* codes, size_t count, uint64_t* keys);
+
+// The 14 digits of a key from gtinKeys().
+std::string gtin14FromKey(uint64_t key);
+
+// Adds gtin_normalize(text) to the connection, for migrations and ad hoc SQL.
+bool registerGtinFunctions(sqlite3* db);
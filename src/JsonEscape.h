@@ -0,0 +1,70 @@
+#pragma once
+#include <string>
+#include <string_view>
+
+// JSON string escapes, shared by the catalog importer and the HTTP service.
+
+// Appends code point `cp` to `out` as UTF-8.
+inline void appendUtf8(std::string& out, unsigned cp) {
+    if (cp < 0x80) {
+        out.push_back(static_cast<char>(cp));
+    } else if (cp < 0x800) {
+        out.push_back(static_cast<char>(0xC0 | (cp >> 6)));
+        out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    } else if (cp < 0x10000) {
+        out.push_back(static_cast<char>(0xE0 | (cp >> 12)));
+        out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    } else {
+        out.push_back(static_cast<char>(0xF0 | (cp >> 18)));
+        out.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    }
+}
+
+// Reads the 4 hex digits of a \u escape at s[pos].
+inline bool readHex4(std::string_view s, size_t& pos, unsigned& value) {
+    if (pos + 4 > s.size()) return false;
+    value = 0;
+    for (size_t end = pos + 4; pos < end; ++pos) {
+        const char c = s[pos];
+        const int digit = c >= '0' && c <= '9' ? c - '0'
+                        : c >= 'a' && c <= 'f' ? c - 'a' + 10
+                        : c >= 'A' && c <= 'F' ? c - 'A' + 10 : -1;
+        if (digit < 0) return false;
+        value = value * 16 + static_cast<unsigned>(digit);
+    }
+    return true;
+}
+
+// Decodes the escape whose backslash is just before s[pos] and appends it to
+// `out`: \uXXXX and surrogate pairs become UTF-8. Unknown escapes and lone
+// surrogates are rejected.
+inline bool decodeJsonEscape(std::string_view s, size_t& pos, std::string& out) {
+    if (pos >= s.size()) return false;
+    switch (s[pos++]) {
+        case '"': out.push_back('"'); return true;
+        case '\\': out.push_back('\\'); return true;
+        case '/': out.push_back('/'); return true;
+        case 'b': out.push_back('\b'); return true;
+        case 'f': out.push_back('\f'); return true;
+        case 'n': out.push_back('\n'); return true;
+        case 'r': out.push_back('\r'); return true;
+        case 't': out.push_back('\t'); return true;
+        case 'u': {
+            unsigned cp = 0;
+            if (!readHex4(s, pos, cp) || (cp >= 0xDC00 && cp <= 0xDFFF)) return false;
+            if (cp >= 0xD800 && cp <= 0xDBFF) {
+                unsigned low = 0;
+                if (s.substr(pos, 2) != "\\u") return false;
+                pos += 2;
+                if (!readHex4(s, pos, low) || low < 0xDC00 || low > 0xDFFF) return false;
+                cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+            }
+            appendUtf8(out, cp);
+            return true;
+        }
+        default: return false;
+    }
+}
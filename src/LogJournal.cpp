@@ -0,0 +1,453 @@
+#include "LogJournal.h"
+#include "CatalogSnapshot.h"
+#include "Crc32.h"
+#include "DatabaseManager.h"
+#include "Statement.h"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <unordered_map>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#include <sys/stat.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+const char kMagic[8] = { 'C', 'A', 'L', 'J', 'R', 'N', 'L', '1' };
+constexpr uint32_t kFormatVersion = 1;
+constexpr size_t kHeaderSize = 32;
+constexpr size_t kPrefixSize = 8;      // length + crc
+constexpr size_t kFixedPayload = 20;   // timestamp + grams + day
+constexpr size_t kMaxBarcode = 64;
+
+void putU32(unsigned char* p, uint32_t v) {
+    for (int i = 0; i < 4; ++i) p[i] = static_cast<unsigned char>(v >> (8 * i));
+}
+
+void putU64(unsigned char* p, uint64_t v) {
+    for (int i = 0; i < 8; ++i) p[i] = static_cast<unsigned char>(v >> (8 * i));
+}
+
+uint32_t getU32(const unsigned char* p) {
+    uint32_t v = 0;
+    for (int i = 0; i < 4; ++i) v |= static_cast<uint32_t>(p[i]) << (8 * i);
+    return v;
+}
+
+uint64_t getU64(const unsigned char* p) {
+    uint64_t v = 0;
+    for (int i = 0; i < 8; ++i) v |= static_cast<uint64_t>(p[i]) << (8 * i);
+    return v;
+}
+
+// magic | u32 version | u32 flags | u64 journal id | u32 reserved | u32 crc of the first 28 bytes
+void encodeHeader(unsigned char* h, uint64_t id) {
+    std::memset(h, 0, kHeaderSize);
+    std::memcpy(h, kMagic, sizeof(kMagic));
+    putU32(h + 8, kFormatVersion);
+    putU64(h + 16, id);
+    putU32(h + 28, crc32(h, 28));
+}
+
+bool decodeHeader(const unsigned char* h, uint64_t& id) {
+    if (std::memcmp(h, kMagic, sizeof(kMagic)) != 0) return false;
+    if (getU32(h + 8) != kFormatVersion || getU32(h + 28) != crc32(h, 28)) return false;
+    id = getU64(h + 16);
+    return true;
+}
+
+uint64_t newJournalId() {
+    std::random_device rd;
+    const uint64_t clock = static_cast<uint64_t>(std::chrono::system_clock::now().time_since_epoch().count());
+    const uint64_t id = ((static_cast<uint64_t>(rd()) << 32) | rd()) ^ clock;
+    return id ? id : 1;
+}
+
+#ifdef _WIN32
+int openForAppend(const std::string& path) {
+    return _open(path.c_str(), _O_WRONLY | _O_APPEND | _O_BINARY);
+}
+
+int openForCreate(const std::string& path) {
+    return _open(path.c_str(), _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _S_IREAD | _S_IWRITE);
+}
+
+bool writeAll(int fd, const unsigned char* data, size_t size) {
+    return _write(fd, data, static_cast<unsigned>(size)) == static_cast<int>(size);
+}
+
+bool syncFile(int fd) { return _commit(fd) == 0; }
+void closeFile(int fd) { _close(fd); }
+#else
+int openForAppend(const std::string& path) {
+    return ::open(path.c_str(), O_WRONLY | O_APPEND | O_CLOEXEC);
+}
+
+int openForCreate(const std::string& path) {
+    return ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+}
+
+bool writeAll(int fd, const unsigned char* data, size_t size) {
+    while (size > 0) {
+        const ssize_t n = ::write(fd, data, size);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool syncFile(int fd) { return ::fsync(fd) == 0; }
+void closeFile(int fd) { ::close(fd); }
+#endif
+
+// Writes a fresh header-only journal.
+bool createJournal(const std::string& path, uint64_t id) {
+    unsigned char header[kHeaderSize];
+    encodeHeader(header, id);
+    const int fd = openForCreate(path);
+    if (fd < 0) return false;
+    const bool ok = writeAll(fd, header, sizeof(header)) && syncFile(fd);
+    closeFile(fd);
+    return ok;
+}
+
+struct JournalRecord {
+    int64_t timestampMs = 0;
+    double grams = 0.0;
+    Date day;
+    std::string barcode;
+};
+
+// Sequential reader over the records that existed when it was opened.
+class JournalReader {
+public:
+    bool open(const std::string& path, std::string& error) {
+        std::error_code ec;
+        size = static_cast<long long>(std::filesystem::file_size(path, ec));
+        in.open(path, std::ios::binary);
+        if (ec || !in) {
+            error = "cannot open journal " + path;
+            return false;
+        }
+        unsigned char header[kHeaderSize];
+        if (size < static_cast<long long>(kHeaderSize) || !in.read(reinterpret_cast<char*>(header), kHeaderSize) ||
+            !decodeHeader(header, id)) {
+            error = path + " is not a log journal";
+            return false;
+        }
+        pos = kHeaderSize;
+        return true;
+    }
+
+    bool seek(long long offset) {
+        if (offset < static_cast<long long>(kHeaderSize) || offset > size) return false;
+        in.seekg(offset);
+        pos = offset;
+        return static_cast<bool>(in);
+    }
+
+    // False at the end of the valid records: a clean end or a torn record.
+    bool next(JournalRecord& out) {
+        unsigned char prefix[kPrefixSize];
+        if (pos + static_cast<long long>(kPrefixSize) > size) return false;
+        if (!in.read(reinterpret_cast<char*>(prefix), kPrefixSize)) return false;
+
+        const uint32_t length = getU32(prefix);
+        if (length <= kFixedPayload || length > kFixedPayload + kMaxBarcode) return false;
+        if (pos + static_cast<long long>(kPrefixSize + length) > size) return false;
+
+        unsigned char payload[kFixedPayload + kMaxBarcode];
+        if (!in.read(reinterpret_cast<char*>(payload), length)) return false;
+        if (crc32(payload, length, crc32(prefix, 4)) != getU32(prefix + 4)) return false;
+
+        out.timestampMs = static_cast<int64_t>(getU64(payload));
+        const uint64_t gramsBits = getU64(payload + 8);
+        std::memcpy(&out.grams, &gramsBits, sizeof(out.grams));
+        out.day = Date::fromDays(static_cast<int32_t>(getU32(payload + 16)));
+        out.barcode.assign(reinterpret_cast<const char*>(payload + kFixedPayload), length - kFixedPayload);
+
+        pos += static_cast<long long>(kPrefixSize + length);
+        return true;
+    }
+
+    uint64_t journalId() const { return id; }
+    long long fileSize() const { return size; }
+    long long offset() const { return pos; }   // end of the last valid record
+
+private:
+    std::ifstream in;
+    uint64_t id = 0;
+    long long size = 0;
+    long long pos = 0;
+};
+
+long long readWatermark(sqlite3* db, uint64_t journalId) {
+    Statement stmt;
+    long long offset = kHeaderSize;
+    if (stmt.prepare(db, "SELECT offset FROM journal_replay WHERE journal_id = ?;")) {
+        sqlite3_bind_int64(stmt.get(), 1, static_cast<sqlite3_int64>(journalId));
+        if (sqlite3_step(stmt.get()) == SQLITE_ROW) offset = sqlite3_column_int64(stmt.get(), 0);
+    }
+    return offset;
+}
+
+} // namespace
+
+LogJournalWriter::~LogJournalWriter() {
+    close();
+}
+
+bool LogJournalWriter::open(const std::string& path, const JournalOptions& options) {
+    close();
+    opts = options;
+    droppedBytes = 0;
+
+    std::error_code ec;
+    const long long size = std::filesystem::exists(path, ec)
+        ? static_cast<long long>(std::filesystem::file_size(path, ec)) : 0;
+
+    if (size < static_cast<long long>(kHeaderSize)) {
+        // A new journal, or a crash while the header was being written.
+        id = newJournalId();
+        if (!createJournal(path, id)) {
+            std::cerr << "Cannot create journal " << path << "\n";
+            return false;
+        }
+    } else {
+        JournalReader reader;
+        std::string error;
+        if (!reader.open(path, error)) {
+            std::cerr << error << "\n";
+            return false;
+        }
+        JournalRecord record;
+        while (reader.next(record)) {}
+        id = reader.journalId();
+
+        if (reader.offset() < size) {
+            droppedBytes = size - reader.offset();
+            std::filesystem::resize_file(path, static_cast<uintmax_t>(reader.offset()), ec);
+            if (ec) {
+                std::cerr << "Cannot truncate torn journal tail: " << ec.message() << "\n";
+                return false;
+            }
+        }
+    }
+
+    fd = openForAppend(path);
+    if (fd < 0) {
+        std::cerr << "Cannot open journal " << path << " for appending\n";
+        return false;
+    }
+    unsynced = 0;
+    lastSync = std::chrono::steady_clock::now();
+    return true;
+}
+
+bool LogJournalWriter::append(Date day, const std::string& barcode, double grams) {
+    const auto now = std::chrono::system_clock::now().time_since_epoch();
+    return append(day, barcode, grams, std::chrono::duration_cast<std::chrono::milliseconds>(now).count());
+}
+
+bool LogJournalWriter::append(Date day, const std::string& barcode, double grams, int64_t timestampMs) {
+    if (fd < 0) return false;
+    if (barcode.empty() || barcode.size() > kMaxBarcode) {
+        std::cerr << "Journal barcodes must be 1 to " << kMaxBarcode << " bytes.\n";
+        return false;
+    }
+
+    unsigned char record[kPrefixSize + kFixedPayload + kMaxBarcode];
+    const uint32_t length = static_cast<uint32_t>(kFixedPayload + barcode.size());
+    unsigned char* payload = record + kPrefixSize;
+
+    uint64_t gramsBits = 0;
+    std::memcpy(&gramsBits, &grams, sizeof(grams));
+    putU32(record, length);
+    putU64(payload, static_cast<uint64_t>(timestampMs));
+    putU64(payload + 8, gramsBits);
+    putU32(payload + 16, static_cast<uint32_t>(day.days()));
+    std::memcpy(payload + kFixedPayload, barcode.data(), barcode.size());
+    putU32(record + 4, crc32(payload, length, crc32(record, 4)));
+
+    if (!writeAll(fd, record, kPrefixSize + length)) {
+        std::cerr << "Journal write failed.\n";
+        return false;
+    }
+
+    ++unsynced;
+    const bool countDue = opts.syncEveryRecords > 0 && unsynced >= opts.syncEveryRecords;
+    const bool timeDue = opts.syncIntervalMs > 0 &&
+        std::chrono::steady_clock::now() - lastSync >= std::chrono::milliseconds(opts.syncIntervalMs);
+    return countDue || timeDue ? sync() : true;
+}
+
+bool LogJournalWriter::sync() {
+    if (fd < 0) return false;
+    if (unsynced == 0) return true;
+    if (!syncFile(fd)) {
+        std::cerr << "Journal fsync failed.\n";
+        return false;
+    }
+    unsynced = 0;
+    lastSync = std::chrono::steady_clock::now();
+    return true;
+}
+
+void LogJournalWriter::close() {
+    if (fd < 0) return;
+    sync();
+    closeFile(fd);
+    fd = -1;
+}
+
+JournalReplayStats replayJournal(DatabaseManager& db, const std::string& path, long long batchSize) {
+    const auto started = std::chrono::steady_clock::now();
+    JournalReplayStats stats;
+    if (batchSize <= 0) batchSize = 1;
+
+    JournalReader reader;
+    if (!reader.open(path, stats.error)) return stats;
+
+    sqlite3* handle = db.handle();
+    const long long watermark = readWatermark(handle, reader.journalId());
+    if (!reader.seek(watermark)) {
+        stats.error = "journal is shorter than its replay watermark";
+        return stats;
+    }
+
+    Statement setWatermark;
+    if (!setWatermark.prepare(handle,
+            "INSERT INTO journal_replay (journal_id, offset, updated_at) VALUES (?, ?, strftime('%s', 'now')) "
+            "ON CONFLICT(journal_id) DO UPDATE SET offset = excluded.offset, updated_at = excluded.updated_at;")) {
+        stats.error = sqlite3_errmsg(handle);
+        return stats;
+    }
+
+    // Rows and the watermark that covers them commit together.
+    auto commitBatch = [&]() {
+        sqlite3_stmt* stmt = setWatermark.get();
+        sqlite3_bind_int64(stmt, 1, static_cast<sqlite3_int64>(reader.journalId()));
+        sqlite3_bind_int64(stmt, 2, reader.offset());
+        const bool ok = sqlite3_step(stmt) == SQLITE_DONE;
+        sqlite3_reset(stmt);
+        if (!ok || !db.commit()) {
+            stats.error = sqlite3_errmsg(handle);
+            db.rollback();
+            return false;
+        }
+        ++stats.batches;
+        return true;
+    };
+
+    std::unordered_map<std::string, long long> foodIds;   // -1: not in foods
+    JournalRecord record;
+    long long inBatch = 0;
+    if (!db.beginTransaction()) {
+        stats.error = sqlite3_errmsg(handle);
+        return stats;
+    }
+
+    while (reader.next(record)) {
+        ++stats.records;
+
+        auto it = foodIds.find(record.barcode);
+        if (it == foodIds.end()) {
+            auto id = db.findFoodId(record.barcode);
+            it = foodIds.emplace(record.barcode, id ? *id : -1).first;
+        }
+
+        bool inserted = false;
+        if (!DatabaseManager::isLoggableDay(record.day)) {
+            ++stats.outOfRange;
+            continue;
+        }
+        if (it->second >= 0) {
+            inserted = db.insertLogRow(record.day, it->second, record.grams);
+            if (!inserted) {
+                stats.error = sqlite3_errmsg(handle);
+                db.rollback();
+                return stats;
+            }
+        } else if (db.catalogSnapshot() && db.catalogSnapshot()->find(record.barcode)) {
+            // Copies the food out of the snapshot, then logs it.
+            inserted = db.logFoodForDate(record.day, record.barcode, record.grams);
+            if (inserted) {
+                auto id = db.findFoodId(record.barcode);
+                it->second = id ? *id : -1;
+            }
+        }
+        if (inserted) ++stats.inserted;
+        else ++stats.unknownBarcodes;
+
+        if (++inBatch >= batchSize) {
+            if (!commitBatch() || !db.beginTransaction()) return stats;
+            inBatch = 0;
+        }
+    }
+
+    if (inBatch > 0) {
+        if (!commitBatch()) return stats;
+    } else {
+        db.rollback();
+    }
+
+    stats.tornBytes = reader.fileSize() - reader.offset();
+    stats.completed = true;
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    return stats;
+}
+
+bool compactJournal(DatabaseManager& db, const std::string& path) {
+    sqlite3* handle = db.handle();
+    uint64_t oldId = 0;
+    {
+        JournalReader reader;
+        std::string error;
+        if (!reader.open(path, error)) {
+            std::cerr << error << "\n";
+            return false;
+        }
+        oldId = reader.journalId();
+        if (!reader.seek(readWatermark(handle, oldId))) {
+            std::cerr << "Journal is shorter than its replay watermark.\n";
+            return false;
+        }
+        JournalRecord record;
+        if (reader.next(record)) {
+            std::cerr << "Journal has records that were not replayed yet.\n";
+            return false;
+        }
+    }
+
+    // The replacement gets a new id, so the old watermark can never apply to it.
+    const std::string tmpPath = path + ".tmp";
+    std::error_code ec;
+    if (!createJournal(tmpPath, newJournalId())) {
+        std::cerr << "Cannot write " << tmpPath << "\n";
+        return false;
+    }
+    std::filesystem::rename(tmpPath, path, ec);
+    if (ec) {
+        std::cerr << "Cannot replace journal: " << ec.message() << "\n";
+        std::filesystem::remove(tmpPath, ec);
+        return false;
+    }
+
+    Statement forget;
+    if (!forget.prepare(handle, "DELETE FROM journal_replay WHERE journal_id = ?;")) return false;
+    sqlite3_bind_int64(forget.get(), 1, static_cast<sqlite3_int64>(oldId));
+    return sqlite3_step(forget.get()) == SQLITE_DONE;
+}
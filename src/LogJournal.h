@@ -0,0 +1,77 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include "Date.h"
+
+class DatabaseManager;
+
+// Append-only binary journal of log events for scanners that cannot reach the
+// database. The file is a 32-byte header (magic, version, random journal id)
+// followed by records:
+//
+//   u32 length | u32 crc32(length, payload) | payload
+//   payload = i64 timestamp ms | f64 grams | i32 day | barcode bytes
+//
+// All integers are little-endian. A crash can only leave a torn last record;
+// readers stop at the first record whose length or CRC does not check out.
+
+struct JournalOptions {
+    // fsync after this many appends, or on the first append this long after the
+    // last fsync; 0 disables either trigger. sync() and close() always fsync.
+    int syncEveryRecords = 64;
+    int syncIntervalMs = 1000;
+};
+
+class LogJournalWriter {
+public:
+    LogJournalWriter() = default;
+    ~LogJournalWriter();
+
+    LogJournalWriter(const LogJournalWriter&) = delete;
+    LogJournalWriter& operator=(const LogJournalWriter&) = delete;
+
+    // Creates the journal, or reopens it and cuts off a torn tail left by a
+    // crash so new records are not appended after garbage. Only one writer may
+    // have a journal open.
+    bool open(const std::string& path, const JournalOptions& options = JournalOptions());
+    // One write() per record on an O_APPEND descriptor.
+    bool append(Date day, const std::string& barcode, double grams, int64_t timestampMs);
+    bool append(Date day, const std::string& barcode, double grams);
+    bool sync();
+    void close();   // syncs
+
+    uint64_t journalId() const { return id; }
+    long long tornBytesDropped() const { return droppedBytes; }
+
+private:
+    int fd = -1;
+    JournalOptions opts;
+    uint64_t id = 0;
+    long long droppedBytes = 0;
+    int unsynced = 0;
+    std::chrono::steady_clock::time_point lastSync;
+};
+
+struct JournalReplayStats {
+    long long records = 0;          // valid records read past the watermark
+    long long inserted = 0;
+    long long unknownBarcodes = 0;  // records whose barcode is not in foods (skipped)
+    long long outOfRange = 0;       // records dated outside isLoggableDay() (skipped)
+    long long tornBytes = 0;        // invalid tail that was ignored
+    long long batches = 0;
+    double seconds = 0.0;
+    bool completed = false;
+    std::string error;
+};
+
+// Ingests the records after this journal's watermark into daily_log, `batchSize`
+// records per transaction. The watermark (journal_replay) advances in the same
+// transaction as the rows, so replaying again, or after a crash mid-replay,
+// never inserts a record twice.
+JournalReplayStats replayJournal(DatabaseManager& db, const std::string& path, long long batchSize = 10000);
+
+// After a complete replay, replaces the journal with an empty one under a new
+// id and forgets the old watermark. Refuses when records remain unreplayed.
+// No writer may have the journal open.
+bool compactJournal(DatabaseManager& db, const std::string& path);
@@ -0,0 +1,234 @@
+#include "LogPartitions.h"
+#include "SqlExec.h"
+#include <algorithm>
+#include <iostream>
+#include <set>
+
+namespace {
+
+// Per-partition DDL; every "%T" becomes the partition's table name. Same
+// columns, indexes and rollup insert trigger as the single daily_log table of
+// migration 4, plus the CHECK that keeps a row in its month. Every trigger is
+// parsed on each connection open, once per partition, so the delete and update
+// triggers are not repeated here (see partitionDailyLog).
+const char* const partitionTableSql = R"(
+    CREATE TABLE IF NOT EXISTS %T (
+        id INTEGER PRIMARY KEY AUTOINCREMENT,
+        day INTEGER NOT NULL CHECK (day BETWEEN %FIRST AND %LAST),
+        food_id INTEGER NOT NULL,
+        grams REAL NOT NULL,
+        FOREIGN KEY(food_id) REFERENCES foods(id) ON DELETE CASCADE
+        );
+    CREATE INDEX IF NOT EXISTS idx_%T_day_food ON %T(day, food_id, grams);
+    CREATE INDEX IF NOT EXISTS idx_%T_food ON %T(food_id);
+    )";
+
+const char* const partitionTriggerSql = R"(
+    CREATE TRIGGER IF NOT EXISTS trg_%T_insert AFTER INSERT ON %T
+    BEGIN
+        INSERT INTO daily_totals (day, calories, protein, carbs, fat, entries)
+        SELECT NEW.day,
+               f.calories_per_100g / 100.0 * NEW.grams,
+               COALESCE(f.protein, 0) / 100.0 * NEW.grams,
+               COALESCE(f.carbs, 0) / 100.0 * NEW.grams,
+               COALESCE(f.fat, 0) / 100.0 * NEW.grams,
+               1
+        FROM foods f WHERE f.id = NEW.food_id
+        ON CONFLICT(day) DO UPDATE SET
+            calories = calories + excluded.calories,
+            protein = protein + excluded.protein,
+            carbs = carbs + excluded.carbs,
+            fat = fat + excluded.fat,
+            entries = entries + 1;
+    END;
+    )";
+
+// Ids of a partition start above YYYYMM * 10^9.
+const long long idsPerPartition = 1000000000LL;
+
+std::string replaceAll(std::string text, const std::string& from, const std::string& to) {
+    for (size_t pos = text.find(from); pos != std::string::npos; pos = text.find(from, pos + to.size())) {
+        text.replace(pos, from.size(), to);
+    }
+    return text;
+}
+
+std::string expand(const char* tmpl, int month) {
+    std::string sql = replaceAll(tmpl, "%T", logPartitionTable(month));
+    sql = replaceAll(sql, "%FIRST", std::to_string(logPartitionFirstDay(month).days()));
+    return replaceAll(sql, "%LAST", std::to_string(logPartitionLastDay(month).days()));
+}
+
+// Registry row plus the id floor. sqlite_sequence has no unique key, so the
+// row is updated if the copy in partitionDailyLog already created it.
+std::string registerSql(int month) {
+    const std::string table = logPartitionTable(month);
+    const std::string floor = std::to_string(month * idsPerPartition);
+    return "INSERT OR IGNORE INTO log_partitions (month, name) VALUES (" + std::to_string(month) + ", '" + table + "');"
+           "UPDATE sqlite_sequence SET seq = MAX(seq, " + floor + ") WHERE name = '" + table + "';"
+           "INSERT INTO sqlite_sequence (name, seq) SELECT '" + table + "', " + floor +
+           " WHERE NOT EXISTS (SELECT 1 FROM sqlite_sequence WHERE name = '" + table + "');";
+}
+
+// The view is one compound SELECT, which SQLite caps at
+// SQLITE_LIMIT_COMPOUND_SELECT terms (500 by default, about 40 years). Past
+// that every statement on daily_log would fail, so no more partitions are made.
+bool withinPartitionLimit(sqlite3* db, size_t months) {
+    const int limit = sqlite3_limit(db, SQLITE_LIMIT_COMPOUND_SELECT, -1);
+    if (limit <= 0 || months <= static_cast<size_t>(limit)) return true;
+    std::cerr << "Log partition limit reached: the daily_log view can join at most " << limit
+              << " months. Drop old months (retention) or fix out-of-range dates.\n";
+    return false;
+}
+
+// With no partitions the view is an empty, correctly typed SELECT, so readers
+// never need to special-case a fresh database.
+bool rebuildView(sqlite3* db) {
+    std::string sql = "DROP VIEW IF EXISTS daily_log; CREATE VIEW daily_log AS ";
+    const std::vector<int> months = listLogPartitions(db);
+    if (months.empty()) {
+        sql += "SELECT CAST(NULL AS INTEGER) AS id, CAST(NULL AS INTEGER) AS day, "
+               "CAST(NULL AS INTEGER) AS food_id, CAST(NULL AS REAL) AS grams WHERE 0;";
+    } else {
+        for (size_t i = 0; i < months.size(); ++i) {
+            if (i > 0) sql += " UNION ALL ";
+            sql += "SELECT id, day, food_id, grams FROM " + logPartitionTable(months[i]);
+        }
+        sql += ";";
+    }
+    return execSql(db, sql);
+}
+
+// Ids restart at the month's floor if the partition is created again, so the
+// sync cursors and origins of its rows (Sync.h) go with it.
+std::string dropSql(int month) {
+    const std::string table = logPartitionTable(month);
+    const std::string floor = std::to_string(month * idsPerPartition);
+    return "DROP TABLE IF EXISTS " + table + ";"
+           "DELETE FROM log_partitions WHERE month = " + std::to_string(month) + ";"
+           "DELETE FROM sqlite_sequence WHERE name = '" + table + "';"
+           "DELETE FROM sync_log_cursors WHERE month = " + std::to_string(month) + ";"
+           "DELETE FROM log_origins WHERE id >= " + floor + " AND id < " + floor + " + " +
+           std::to_string(idsPerPartition) + ";";
+}
+
+} // namespace
+
+int logPartitionMonth(Date day) {
+    int y = 0, m = 0, d = 0;
+    day.ymd(y, m, d);
+    return y * 100 + m;
+}
+
+std::string logPartitionTable(int month) {
+    return "daily_log_" + std::to_string(month);
+}
+
+Date logPartitionFirstDay(int month) {
+    return Date::fromYmd(month / 100, month % 100, 1);
+}
+
+Date logPartitionLastDay(int month) {
+    return Date::fromYmd(month / 100, month % 100, daysInMonth(month / 100, month % 100));
+}
+
+std::vector<int> listLogPartitions(sqlite3* db) {
+    std::vector<int> months;
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db, "SELECT month FROM log_partitions ORDER BY month;", -1, &stmt, nullptr) == SQLITE_OK) {
+        while (sqlite3_step(stmt) == SQLITE_ROW) months.push_back(sqlite3_column_int(stmt, 0));
+    }
+    sqlite3_finalize(stmt);
+    return months;
+}
+
+bool ensureLogPartition(sqlite3* db, int month) {
+    return inTransaction(db, "log_partitions", [&] {
+        const std::vector<int> months = listLogPartitions(db);
+        if (std::find(months.begin(), months.end(), month) == months.end() &&
+            !withinPartitionLimit(db, months.size() + 1)) {
+            return false;
+        }
+        return execSql(db, expand(partitionTableSql, month)) && execSql(db, expand(partitionTriggerSql, month)) &&
+               execSql(db, registerSql(month)) && rebuildView(db);
+    });
+}
+
+bool dropLogPartition(sqlite3* db, int month) {
+    return inTransaction(db, "log_partitions", [&] {
+        return execSql(db, dropSql(month)) &&
+               execSql(db, "DELETE FROM daily_totals WHERE day BETWEEN " +
+                            std::to_string(logPartitionFirstDay(month).days()) + " AND " +
+                            std::to_string(logPartitionLastDay(month).days()) + ";") &&
+               rebuildView(db);
+    });
+}
+
+bool dropAllLogPartitions(sqlite3* db) {
+    return inTransaction(db, "log_partitions", [&] {
+        for (int month : listLogPartitions(db)) {
+            if (!execSql(db, dropSql(month))) return false;
+        }
+        return execSql(db, "DELETE FROM daily_totals;") && rebuildView(db);
+    });
+}
+
+// The application only deletes log rows through ON DELETE CASCADE from foods,
+// so one trigger on foods replaces the per-partition delete and update
+// triggers: before the cascade, it recomputes the food's days without its
+// rows. Hand edits of partition rows need rebuildDailyTotalsSql.
+bool partitionDailyLog(sqlite3* db) {
+    const char* const setupSql = R"(
+    CREATE TABLE log_partitions (
+        month INTEGER PRIMARY KEY,
+        name TEXT NOT NULL UNIQUE
+        );
+    DROP TRIGGER trg_daily_log_insert;
+    DROP TRIGGER trg_daily_log_delete;
+    DROP TRIGGER trg_daily_log_update;
+    ALTER TABLE daily_log RENAME TO daily_log_unpartitioned;
+
+    CREATE TRIGGER trg_foods_delete_totals BEFORE DELETE ON foods
+    WHEN EXISTS (SELECT 1 FROM daily_log WHERE food_id = OLD.id)
+    BEGIN
+        DELETE FROM daily_totals WHERE day IN (SELECT day FROM daily_log WHERE food_id = OLD.id);
+        INSERT INTO daily_totals (day, calories, protein, carbs, fat, entries)
+        SELECT l.day,
+               SUM(f.calories_per_100g / 100.0 * l.grams),
+               SUM(COALESCE(f.protein, 0) / 100.0 * l.grams),
+               SUM(COALESCE(f.carbs, 0) / 100.0 * l.grams),
+               SUM(COALESCE(f.fat, 0) / 100.0 * l.grams),
+               COUNT(*)
+        FROM daily_log l JOIN foods f ON f.id = l.food_id
+        WHERE l.day IN (SELECT day FROM daily_log WHERE food_id = OLD.id) AND l.food_id <> OLD.id
+        GROUP BY l.day;
+    END;
+    )";
+    if (!execSql(db, setupSql)) return false;
+
+    std::set<int> months;
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db, "SELECT DISTINCT day FROM daily_log_unpartitioned;", -1, &stmt, nullptr) != SQLITE_OK) {
+        return false;
+    }
+    while (sqlite3_step(stmt) == SQLITE_ROW) months.insert(logPartitionMonth(Date::fromDays(sqlite3_column_int(stmt, 0))));
+    sqlite3_finalize(stmt);
+    if (!withinPartitionLimit(db, months.size())) return false;
+
+    // Rows are copied before the triggers exist: daily_totals already covers them.
+    for (int month : months) {
+        const std::string copy = "INSERT INTO " + logPartitionTable(month) +
+                                 " (id, day, food_id, grams) SELECT id, day, food_id, grams"
+                                 " FROM daily_log_unpartitioned WHERE day BETWEEN " +
+                                 std::to_string(logPartitionFirstDay(month).days()) + " AND " +
+                                 std::to_string(logPartitionLastDay(month).days()) + " ORDER BY id;";
+        if (!execSql(db, expand(partitionTableSql, month)) || !execSql(db, copy) ||
+            !execSql(db, expand(partitionTriggerSql, month)) || !execSql(db, registerSql(month))) {
+            return false;
+        }
+    }
+
+    return execSql(db, "DROP TABLE daily_log_unpartitioned;"
+                    "DELETE FROM sqlite_sequence WHERE name IN ('daily_log', 'daily_log_unpartitioned');") &&
+           rebuildView(db);
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "sqlite3.h"
+#include "Date.h"
+
+// daily_log is stored as one table per calendar month (daily_log_YYYYMM),
+// listed in log_partitions, and read through a UNION ALL view named daily_log.
+// Dropping a month is a DROP TABLE instead of a row-by-row DELETE.
+//
+// Each partition carries the daily_totals insert trigger and a CHECK that its
+// rows belong to its month; deleting a food fixes the rollup for its cascaded
+// rows. Row ids start at YYYYMM * 10^9 so ids stay unique across the view.
+// All helpers work inside or outside an open transaction.
+
+// Partition key: year * 100 + month.
+int logPartitionMonth(Date day);
+std::string logPartitionTable(int month);
+Date logPartitionFirstDay(int month);
+Date logPartitionLastDay(int month);
+
+// Months with a partition, oldest first.
+std::vector<int> listLogPartitions(sqlite3* db);
+
+// Creates the month's table, indexes and triggers if missing, and the view.
+// Fails without changes when a new month would take the view past SQLite's
+// compound SELECT limit (500 months by default).
+bool ensureLogPartition(sqlite3* db, int month);
+
+// Drops the month's table and its daily_totals rows, and rebuilds the view.
+bool dropLogPartition(sqlite3* db, int month);
+
+// Drops every partition and empties daily_totals.
+bool dropAllLogPartitions(sqlite3* db);
+
+// Schema migration: moves an unpartitioned daily_log table into partitions.
+bool partitionDailyLog(sqlite3* db);
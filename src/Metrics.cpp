@@ -0,0 +1,491 @@
+#include "Metrics.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <unordered_map>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace {
+
+const char* const opNames[] = {
+    "open", "migrate", "prepare",
+    "add_food", "update_food", "get_food_by_barcode", "get_food_by_id", "find_food_id",
+    "search_foods_by_name",
+    "log_food_for_date", "insert_log_row", "get_total_calories_for_date", "get_entries_for_date",
+    "get_daily_totals", "get_daily_totals_range", "get_nutrition_series", "get_top_foods",
+    "rebuild_daily_totals", "clear_all_logs", "clear_all_foods", "factory_reset",
+    "set_daily_goal", "get_daily_goal",
+    "set_log_retention", "get_log_retention", "apply_log_retention",
+    "first_prompt", "catalog_warmup",
+    "begin_transaction", "commit", "rollback",
+    "vfs_write", "vfs_sync",
+};
+static_assert(sizeof(opNames) / sizeof(opNames[0]) == static_cast<size_t>(MetricOp::Count), "opNames");
+
+void writeEscaped(std::ostream& out, const std::string& s) {
+    for (char c : s) {
+        if (c == '\\' || c == '"') out << '\\' << c;
+        else if (c == '\n') out << "\\n";
+        else out << c;
+    }
+}
+
+} // namespace
+
+const char* metricOpName(MetricOp op) {
+    return opNames[static_cast<size_t>(op)];
+}
+
+double OpStats::percentileUs(double p) const {
+    if (calls == 0) return 0.0;
+    const uint64_t rank = static_cast<uint64_t>(p / 100.0 * static_cast<double>(calls - 1)) + 1;
+    uint64_t seen = 0;
+    for (const auto& b : buckets) {
+        seen += b.second;
+        if (seen >= rank) return std::min(b.first, maxNs) / 1000.0;
+    }
+    return maxNs / 1000.0;
+}
+
+// Collapses whitespace runs so multi-line DDL prints on one line, then truncates.
+static std::string oneLine(const std::string& sql, size_t maxChars) {
+    std::string out;
+    bool space = false;
+    for (char c : sql) {
+        if (c == ' ' || c == '\n' || c == '\t' || c == '\r') {
+            space = !out.empty();
+            continue;
+        }
+        if (space) out += ' ';
+        space = false;
+        out += c;
+        if (out.size() >= maxChars) return out + "...";
+    }
+    return out;
+}
+
+void writeMetricsText(std::ostream& out, const MetricsSnapshot& snapshot) {
+    if (!snapshot.enabled) {
+        out << "Metrics are disabled in this build (configure with -DCALORIE_ENABLE_METRICS=ON).\n";
+        return;
+    }
+
+    out << "operation                          calls   errors   avg us   p50 us   p99 us   max us\n";
+    for (const OpStats& s : snapshot.ops) {
+        char line[160];
+        std::snprintf(line, sizeof(line), "%-30s %9llu %8llu %8.1f %8.1f %8.1f %8.1f\n", metricOpName(s.op),
+                      static_cast<unsigned long long>(s.calls), static_cast<unsigned long long>(s.errors),
+                      s.totalNs / 1000.0 / static_cast<double>(s.calls), s.percentileUs(50), s.percentileUs(99),
+                      s.maxNs / 1000.0);
+        out << line;
+    }
+
+    const PageCacheStats& pc = snapshot.pageCache;
+    const long long lookups = pc.hits + pc.misses;
+    out << "\npage cache (" << pc.connections << " connections): " << pc.hits << " hits, " << pc.misses
+        << " misses (" << (lookups ? 100.0 * pc.hits / lookups : 0.0) << "% hit), " << pc.writes
+        << " writes, " << pc.usedBytes << " bytes used\n";
+
+    const size_t shown = std::min<size_t>(snapshot.statements.size(), 10);
+    if (shown > 0) out << "\nstatements by total time:\n";
+    for (size_t i = 0; i < shown; ++i) {
+        const StatementStats& s = snapshot.statements[i];
+        out << "  " << s.runs << " runs, " << s.totalNs / 1000 << " us total, " << s.maxNs / 1000
+            << " us max: " << oneLine(s.sql, 100) << "\n";
+    }
+}
+
+void writePrometheusText(std::ostream& out, const MetricsSnapshot& snapshot) {
+    out << "# HELP calorie_metrics_enabled Whether instrumentation is compiled in.\n"
+        << "# TYPE calorie_metrics_enabled gauge\n"
+        << "calorie_metrics_enabled " << (snapshot.enabled ? 1 : 0) << "\n";
+    if (!snapshot.enabled) return;
+
+    out << "# HELP calorie_op_errors_total Failed DatabaseManager operations.\n"
+        << "# TYPE calorie_op_errors_total counter\n";
+    for (const OpStats& s : snapshot.ops) {
+        out << "calorie_op_errors_total{op=\"" << metricOpName(s.op) << "\"} " << s.errors << "\n";
+    }
+
+    out << "# HELP calorie_op_duration_seconds Latency of DatabaseManager operations and file I/O.\n"
+        << "# TYPE calorie_op_duration_seconds histogram\n";
+    for (const OpStats& s : snapshot.ops) {
+        const char* name = metricOpName(s.op);
+        uint64_t cumulative = 0;
+        for (const auto& b : s.buckets) {
+            cumulative += b.second;
+            out << "calorie_op_duration_seconds_bucket{op=\"" << name << "\",le=\"" << b.first / 1e9 << "\"} "
+                << cumulative << "\n";
+        }
+        out << "calorie_op_duration_seconds_bucket{op=\"" << name << "\",le=\"+Inf\"} " << s.calls << "\n"
+            << "calorie_op_duration_seconds_sum{op=\"" << name << "\"} " << s.totalNs / 1e9 << "\n"
+            << "calorie_op_duration_seconds_count{op=\"" << name << "\"} " << s.calls << "\n";
+    }
+
+    const PageCacheStats& pc = snapshot.pageCache;
+    out << "# HELP calorie_sqlite_cache_hits Page cache hits on open connections.\n"
+        << "# TYPE calorie_sqlite_cache_hits gauge\n"
+        << "calorie_sqlite_cache_hits " << pc.hits << "\n"
+        << "# HELP calorie_sqlite_cache_misses Page cache misses on open connections.\n"
+        << "# TYPE calorie_sqlite_cache_misses gauge\n"
+        << "calorie_sqlite_cache_misses " << pc.misses << "\n"
+        << "# HELP calorie_sqlite_cache_writes Dirty pages written by open connections.\n"
+        << "# TYPE calorie_sqlite_cache_writes gauge\n"
+        << "calorie_sqlite_cache_writes " << pc.writes << "\n"
+        << "# HELP calorie_sqlite_cache_used_bytes Page cache memory of open connections.\n"
+        << "# TYPE calorie_sqlite_cache_used_bytes gauge\n"
+        << "calorie_sqlite_cache_used_bytes " << pc.usedBytes << "\n";
+
+    out << "# HELP calorie_statement_seconds_total Time spent stepping each statement.\n"
+        << "# TYPE calorie_statement_seconds_total counter\n";
+    for (const StatementStats& s : snapshot.statements) {
+        out << "calorie_statement_seconds_total{sql=\"";
+        writeEscaped(out, s.sql);
+        out << "\"} " << s.totalNs / 1e9 << "\n";
+    }
+}
+
+bool writePrometheusFile(const std::string& path, const MetricsSnapshot& snapshot) {
+    const std::string tmpPath = path + ".tmp";
+    {
+        std::ofstream out(tmpPath, std::ios::trunc);
+        writePrometheusText(out, snapshot);
+        if (!out.flush()) return false;
+    }
+    std::error_code ec;
+    std::filesystem::rename(tmpPath, path, ec);
+    if (ec) std::remove(tmpPath.c_str());
+    return !ec;
+}
+
+#if !CALORIE_ENABLE_METRICS
+
+MetricsSnapshot collectMetrics() {
+    return MetricsSnapshot();
+}
+
+#else
+
+namespace {
+
+// Log-linear buckets: values below 16 ns get their own bucket, then every
+// power of two is split into 16 steps (at most 6.25% error). Durations of
+// 2^42 ns (73 minutes) and above share the last bucket.
+constexpr int kSubBits = 4;
+constexpr int kSubCount = 1 << kSubBits;
+constexpr int kMaxExponent = 42;
+constexpr size_t kBuckets = kSubCount + (kMaxExponent - kSubBits + 1) * kSubCount;
+constexpr size_t kOps = static_cast<size_t>(MetricOp::Count);
+
+inline int highestBit(uint64_t v) {
+#ifdef _MSC_VER
+    unsigned long index = 0;
+    _BitScanReverse64(&index, v);
+    return static_cast<int>(index);
+#else
+    return 63 - __builtin_clzll(v);
+#endif
+}
+
+inline size_t bucketFor(uint64_t ns) {
+    if (ns < kSubCount) return static_cast<size_t>(ns);
+    int e = highestBit(ns);
+    if (e > kMaxExponent) return kBuckets - 1;
+    size_t sub = static_cast<size_t>(ns >> (e - kSubBits)) & (kSubCount - 1);
+    return kSubCount + static_cast<size_t>(e - kSubBits) * kSubCount + sub;
+}
+
+inline uint64_t bucketUpperBound(size_t index) {
+    if (index < kSubCount) return index;
+    const int e = static_cast<int>((index - kSubCount) / kSubCount) + kSubBits;
+    const uint64_t sub = (index - kSubCount) % kSubCount;
+    const uint64_t lower = (kSubCount + sub) << (e - kSubBits);
+    return lower + (uint64_t(1) << (e - kSubBits)) - 1;
+}
+
+// Counters owned by one thread. Only the owner writes (plain load + store, no
+// read-modify-write); collectors read with relaxed loads, so a snapshot can be
+// a few increments behind but never blocks the hot path.
+struct Shard {
+    struct Counters {
+        std::atomic<uint64_t> calls{ 0 };
+        std::atomic<uint64_t> errors{ 0 };
+        std::atomic<uint64_t> totalNs{ 0 };
+        std::atomic<uint64_t> maxNs{ 0 };
+        std::atomic<uint64_t> buckets[kBuckets] = {};
+    };
+
+    Counters ops[kOps];
+    std::atomic<bool> inUse{ true };
+
+    // Statement profiles are keyed by SQL text; the mutex is only contended
+    // while a collector copies the map.
+    std::mutex statementsMutex;
+    std::unordered_map<std::string, StatementStats> statements;
+};
+
+inline void bump(std::atomic<uint64_t>& counter, uint64_t by) {
+    counter.store(counter.load(std::memory_order_relaxed) + by, std::memory_order_relaxed);
+}
+
+struct Registry {
+    std::mutex mutex;
+    std::vector<std::unique_ptr<Shard>> shards;
+    std::vector<sqlite3*> connections;
+};
+
+Registry& registry() {
+    static Registry* r = new Registry();   // never destroyed: threads may record during exit
+    return *r;
+}
+
+// Hands a shard to the thread and releases it (counts intact) when the thread
+// exits, so thread pools that come and go do not grow the registry.
+struct ShardLease {
+    Shard* shard = nullptr;
+
+    ShardLease() {
+        Registry& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        for (auto& s : r.shards) {
+            bool expected = false;
+            if (s->inUse.compare_exchange_strong(expected, true)) {
+                shard = s.get();
+                return;
+            }
+        }
+        r.shards.push_back(std::make_unique<Shard>());
+        shard = r.shards.back().get();
+    }
+
+    ~ShardLease() { shard->inUse.store(false); }
+};
+
+Shard& localShard() {
+    thread_local ShardLease lease;
+    return *lease.shard;
+}
+
+int profileCallback(unsigned type, void*, void* p, void* x) {
+    if (type != SQLITE_TRACE_PROFILE) return 0;
+    const char* sql = sqlite3_sql(static_cast<sqlite3_stmt*>(p));
+    const uint64_t ns = static_cast<uint64_t>(*static_cast<sqlite3_int64*>(x));
+
+    Shard& shard = localShard();
+    std::lock_guard<std::mutex> lock(shard.statementsMutex);
+    StatementStats& s = shard.statements[sql ? sql : "?"];
+    ++s.runs;
+    s.totalNs += ns;
+    s.maxNs = std::max(s.maxNs, ns);
+    return 0;
+}
+
+// A VFS that forwards everything to the default one and times writes and
+// syncs, which is where commit latency hides.
+struct TimedFile {
+    sqlite3_file base;
+    sqlite3_file* inner() { return reinterpret_cast<sqlite3_file*>(this + 1); }
+};
+
+sqlite3_vfs* realVfs = nullptr;
+sqlite3_vfs timedVfs;
+
+TimedFile* asTimed(sqlite3_file* f) { return reinterpret_cast<TimedFile*>(f); }
+const sqlite3_io_methods* innerMethods(sqlite3_file* f) { return asTimed(f)->inner()->pMethods; }
+
+int timedClose(sqlite3_file* f) {
+    int rc = innerMethods(f)->xClose(asTimed(f)->inner());
+    f->pMethods = nullptr;
+    return rc;
+}
+int timedRead(sqlite3_file* f, void* buf, int amt, sqlite3_int64 off) {
+    return innerMethods(f)->xRead(asTimed(f)->inner(), buf, amt, off);
+}
+int timedWrite(sqlite3_file* f, const void* buf, int amt, sqlite3_int64 off) {
+    OpTimer timer(MetricOp::VfsWrite);
+    int rc = innerMethods(f)->xWrite(asTimed(f)->inner(), buf, amt, off);
+    if (rc != SQLITE_OK) timer.fail();
+    return rc;
+}
+int timedTruncate(sqlite3_file* f, sqlite3_int64 size) {
+    return innerMethods(f)->xTruncate(asTimed(f)->inner(), size);
+}
+int timedSync(sqlite3_file* f, int flags) {
+    OpTimer timer(MetricOp::VfsSync);
+    int rc = innerMethods(f)->xSync(asTimed(f)->inner(), flags);
+    if (rc != SQLITE_OK) timer.fail();
+    return rc;
+}
+int timedFileSize(sqlite3_file* f, sqlite3_int64* size) {
+    return innerMethods(f)->xFileSize(asTimed(f)->inner(), size);
+}
+int timedLock(sqlite3_file* f, int level) {
+    return innerMethods(f)->xLock(asTimed(f)->inner(), level);
+}
+int timedUnlock(sqlite3_file* f, int level) {
+    return innerMethods(f)->xUnlock(asTimed(f)->inner(), level);
+}
+int timedCheckReservedLock(sqlite3_file* f, int* out) {
+    return innerMethods(f)->xCheckReservedLock(asTimed(f)->inner(), out);
+}
+int timedFileControl(sqlite3_file* f, int op, void* arg) {
+    return innerMethods(f)->xFileControl(asTimed(f)->inner(), op, arg);
+}
+int timedSectorSize(sqlite3_file* f) {
+    return innerMethods(f)->xSectorSize(asTimed(f)->inner());
+}
+int timedDeviceCharacteristics(sqlite3_file* f) {
+    return innerMethods(f)->xDeviceCharacteristics(asTimed(f)->inner());
+}
+int timedShmMap(sqlite3_file* f, int region, int size, int extend, void volatile** out) {
+    const sqlite3_io_methods* m = innerMethods(f);
+    return m->iVersion >= 2 ? m->xShmMap(asTimed(f)->inner(), region, size, extend, out) : SQLITE_IOERR;
+}
+int timedShmLock(sqlite3_file* f, int offset, int n, int flags) {
+    const sqlite3_io_methods* m = innerMethods(f);
+    return m->iVersion >= 2 ? m->xShmLock(asTimed(f)->inner(), offset, n, flags) : SQLITE_IOERR;
+}
+void timedShmBarrier(sqlite3_file* f) {
+    const sqlite3_io_methods* m = innerMethods(f);
+    if (m->iVersion >= 2) m->xShmBarrier(asTimed(f)->inner());
+}
+int timedShmUnmap(sqlite3_file* f, int deleteFlag) {
+    const sqlite3_io_methods* m = innerMethods(f);
+    return m->iVersion >= 2 ? m->xShmUnmap(asTimed(f)->inner(), deleteFlag) : SQLITE_OK;
+}
+int timedFetch(sqlite3_file* f, sqlite3_int64 off, int amt, void** out) {
+    const sqlite3_io_methods* m = innerMethods(f);
+    if (m->iVersion >= 3) return m->xFetch(asTimed(f)->inner(), off, amt, out);
+    *out = nullptr;
+    return SQLITE_OK;
+}
+int timedUnfetch(sqlite3_file* f, sqlite3_int64 off, void* p) {
+    const sqlite3_io_methods* m = innerMethods(f);
+    return m->iVersion >= 3 ? m->xUnfetch(asTimed(f)->inner(), off, p) : SQLITE_OK;
+}
+
+const sqlite3_io_methods timedMethods = {
+    3, timedClose, timedRead, timedWrite, timedTruncate, timedSync, timedFileSize, timedLock, timedUnlock,
+    timedCheckReservedLock, timedFileControl, timedSectorSize, timedDeviceCharacteristics,
+    timedShmMap, timedShmLock, timedShmBarrier, timedShmUnmap, timedFetch, timedUnfetch,
+};
+
+int timedOpen(sqlite3_vfs*, const char* name, sqlite3_file* f, int flags, int* outFlags) {
+    TimedFile* timed = asTimed(f);
+    timed->base.pMethods = nullptr;
+    int rc = realVfs->xOpen(realVfs, name, timed->inner(), flags, outFlags);
+    if (timed->inner()->pMethods) timed->base.pMethods = &timedMethods;
+    return rc;
+}
+
+} // namespace
+
+void recordMetric(MetricOp op, uint64_t ns, bool failed) {
+    Shard::Counters& c = localShard().ops[static_cast<size_t>(op)];
+    bump(c.calls, 1);
+    if (failed) bump(c.errors, 1);
+    bump(c.totalNs, ns);
+    if (ns > c.maxNs.load(std::memory_order_relaxed)) c.maxNs.store(ns, std::memory_order_relaxed);
+    bump(c.buckets[bucketFor(ns)], 1);
+}
+
+const char* metricsVfsName() {
+    static std::once_flag once;
+    std::call_once(once, [] {
+        realVfs = sqlite3_vfs_find(nullptr);
+        if (!realVfs) return;
+        // Everything but xOpen goes straight to the default VFS, which reads
+        // its own state through pAppData (copied along).
+        timedVfs = *realVfs;
+        timedVfs.zName = "calorie-timed";
+        timedVfs.szOsFile = static_cast<int>(sizeof(TimedFile)) + realVfs->szOsFile;
+        timedVfs.pNext = nullptr;
+        timedVfs.xOpen = timedOpen;
+        if (sqlite3_vfs_register(&timedVfs, 0) != SQLITE_OK) realVfs = nullptr;
+    });
+    return realVfs ? timedVfs.zName : nullptr;
+}
+
+void attachMetrics(sqlite3* db) {
+    if (!db) return;
+    sqlite3_trace_v2(db, SQLITE_TRACE_PROFILE, profileCallback, nullptr);
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    r.connections.push_back(db);
+}
+
+void detachMetrics(sqlite3* db) {
+    if (!db) return;
+    sqlite3_trace_v2(db, 0, nullptr, nullptr);
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    r.connections.erase(std::remove(r.connections.begin(), r.connections.end(), db), r.connections.end());
+}
+
+MetricsSnapshot collectMetrics() {
+    MetricsSnapshot snapshot;
+    snapshot.enabled = true;
+
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+
+    std::vector<uint64_t> merged(kBuckets);
+    std::unordered_map<std::string, StatementStats> statements;
+
+    for (size_t op = 0; op < kOps; ++op) {
+        OpStats stats;
+        stats.op = static_cast<MetricOp>(op);
+        std::fill(merged.begin(), merged.end(), 0);
+
+        for (const auto& shard : r.shards) {
+            const Shard::Counters& c = shard->ops[op];
+            stats.calls += c.calls.load(std::memory_order_relaxed);
+            stats.errors += c.errors.load(std::memory_order_relaxed);
+            stats.totalNs += c.totalNs.load(std::memory_order_relaxed);
+            stats.maxNs = std::max(stats.maxNs, c.maxNs.load(std::memory_order_relaxed));
+            if (c.calls.load(std::memory_order_relaxed) == 0) continue;
+            for (size_t b = 0; b < kBuckets; ++b) merged[b] += c.buckets[b].load(std::memory_order_relaxed);
+        }
+        if (stats.calls == 0) continue;
+
+        for (size_t b = 0; b < kBuckets; ++b) {
+            if (merged[b]) stats.buckets.emplace_back(bucketUpperBound(b), merged[b]);
+        }
+        snapshot.ops.push_back(std::move(stats));
+    }
+
+    for (const auto& shard : r.shards) {
+        std::lock_guard<std::mutex> statementsLock(shard->statementsMutex);
+        for (const auto& entry : shard->statements) {
+            StatementStats& s = statements[entry.first];
+            s.sql = entry.first;
+            s.runs += entry.second.runs;
+            s.totalNs += entry.second.totalNs;
+            s.maxNs = std::max(s.maxNs, entry.second.maxNs);
+        }
+    }
+    for (auto& entry : statements) snapshot.statements.push_back(std::move(entry.second));
+    std::sort(snapshot.statements.begin(), snapshot.statements.end(),
+              [](const StatementStats& a, const StatementStats& b) { return a.totalNs > b.totalNs; });
+
+    for (sqlite3* db : r.connections) {
+        int current = 0, highwater = 0;
+        PageCacheStats& pc = snapshot.pageCache;
+        ++pc.connections;
+        if (sqlite3_db_status(db, SQLITE_DBSTATUS_CACHE_HIT, &current, &highwater, 0) == SQLITE_OK) pc.hits += current;
+        if (sqlite3_db_status(db, SQLITE_DBSTATUS_CACHE_MISS, &current, &highwater, 0) == SQLITE_OK) pc.misses += current;
+        if (sqlite3_db_status(db, SQLITE_DBSTATUS_CACHE_WRITE, &current, &highwater, 0) == SQLITE_OK) pc.writes += current;
+        if (sqlite3_db_status(db, SQLITE_DBSTATUS_CACHE_USED, &current, &highwater, 0) == SQLITE_OK) pc.usedBytes += current;
+    }
+    return snapshot;
+}
+
+#endif
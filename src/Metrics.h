@@ -0,0 +1,121 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <utility>
+#include <vector>
+#include "sqlite3.h"
+
+// Opt-in instrumentation, compiled in only with -DCALORIE_ENABLE_METRICS=1
+// (CMake option CALORIE_ENABLE_METRICS). When off, OpTimer is an empty object
+// and the connection hooks are empty inline functions, so instrumented code
+// compiles to what it was before.
+#ifndef CALORIE_ENABLE_METRICS
+#define CALORIE_ENABLE_METRICS 0
+#endif
+
+enum class MetricOp : uint8_t {
+    Open, Migrate, Prepare,
+    AddFood, UpdateFood, GetFoodByBarcode, GetFoodById, FindFoodId, SearchFoodsByName,
+    LogFoodForDate, InsertLogRow, GetTotalCaloriesForDate, GetEntriesForDate,
+    GetDailyTotals, GetDailyTotalsRange, GetNutritionSeries, GetTopFoods, RebuildDailyTotals,
+    ClearAllLogs, ClearAllFoods, FactoryReset, SetDailyGoal, GetDailyGoal,
+    SetLogRetention, GetLogRetention, ApplyLogRetention,
+    FirstPrompt, CatalogWarmup,   // startup: process start to menu, background catalog load
+    BeginTransaction, Commit, Rollback,
+    VfsWrite, VfsSync,   // file I/O below SQLite, timed by a VFS shim
+    Count
+};
+
+const char* metricOpName(MetricOp op);
+
+struct OpStats {
+    MetricOp op;
+    uint64_t calls = 0;
+    uint64_t errors = 0;
+    uint64_t totalNs = 0;
+    uint64_t maxNs = 0;
+    // Histogram buckets (upper bound in ns, count); only non-empty ones.
+    std::vector<std::pair<uint64_t, uint64_t>> buckets;
+
+    double percentileUs(double p) const;
+};
+
+// sqlite3_trace_v2 profile events, aggregated by statement text.
+struct StatementStats {
+    std::string sql;
+    uint64_t runs = 0;
+    uint64_t totalNs = 0;
+    uint64_t maxNs = 0;
+};
+
+// sqlite3_db_status counters summed over open connections.
+struct PageCacheStats {
+    int connections = 0;
+    long long hits = 0;
+    long long misses = 0;
+    long long writes = 0;
+    long long usedBytes = 0;
+};
+
+struct MetricsSnapshot {
+    bool enabled = false;
+    std::vector<OpStats> ops;               // operations with at least one call
+    std::vector<StatementStats> statements; // slowest total time first
+    PageCacheStats pageCache;
+};
+
+MetricsSnapshot collectMetrics();
+void writeMetricsText(std::ostream& out, const MetricsSnapshot& snapshot);
+void writePrometheusText(std::ostream& out, const MetricsSnapshot& snapshot);
+// Writes aside and renames, as the node_exporter textfile collector expects.
+bool writePrometheusFile(const std::string& path, const MetricsSnapshot& snapshot);
+
+#if CALORIE_ENABLE_METRICS
+
+void recordMetric(MetricOp op, uint64_t ns, bool failed);
+// Name of the timing VFS to pass to sqlite3_open_v2.
+const char* metricsVfsName();
+// Hooks sqlite3_trace_v2 and includes the connection in page cache totals.
+void attachMetrics(sqlite3* db);
+void detachMetrics(sqlite3* db);
+
+// Times one operation on the calling thread; call fail() on error paths.
+class OpTimer {
+public:
+    explicit OpTimer(MetricOp op) : op(op), start(std::chrono::steady_clock::now()) {}
+    // Times from an earlier point, for spans that start before the timer can exist.
+    OpTimer(MetricOp op, std::chrono::steady_clock::time_point since) : op(op), start(since) {}
+    ~OpTimer() {
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+        recordMetric(op, static_cast<uint64_t>(ns.count()), failed);
+    }
+    OpTimer(const OpTimer&) = delete;
+    OpTimer& operator=(const OpTimer&) = delete;
+
+    void fail() { failed = true; }
+    // Marks the call failed and passes `value` through: return timer.fail(false);
+    template <typename T> T fail(T value) { failed = true; return value; }
+
+private:
+    MetricOp op;
+    bool failed = false;
+    std::chrono::steady_clock::time_point start;
+};
+
+#else
+
+inline const char* metricsVfsName() { return nullptr; }
+inline void attachMetrics(sqlite3*) {}
+inline void detachMetrics(sqlite3*) {}
+
+class OpTimer {
+public:
+    explicit OpTimer(MetricOp) {}
+    OpTimer(MetricOp, std::chrono::steady_clock::time_point) {}
+    void fail() {}
+    template <typename T> T fail(T value) { return value; }
+};
+
+#endif
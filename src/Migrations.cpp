@@ -0,0 +1,533 @@
+#include "Migrations.h"
+#include "Gtin.h"
+#include "LogPartitions.h"
+#include "SqlExec.h"
+#include "Statement.h"
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Recomputes every row of daily_totals from daily_log.
+const char* const rebuildDailyTotalsSql = R"(
+    DELETE FROM daily_totals;
+    INSERT INTO daily_totals (day, calories, protein, carbs, fat, entries)
+    SELECT l.day,
+           SUM(f.calories_per_100g / 100.0 * l.grams),
+           SUM(COALESCE(f.protein, 0) / 100.0 * l.grams),
+           SUM(COALESCE(f.carbs, 0) / 100.0 * l.grams),
+           SUM(COALESCE(f.fat, 0) / 100.0 * l.grams),
+           COUNT(*)
+    FROM daily_log l
+    JOIN foods f ON f.id = l.food_id
+    GROUP BY l.day;
+    )";
+
+const char* const deferFoodSearchSyncSql = R"(
+    INSERT INTO settings (key, value)
+    SELECT 'fts_deferred_after', COALESCE(MAX(id), 0) FROM foods;
+    )";
+
+const char* const flushFoodSearchSyncSql = R"(
+    INSERT INTO foods_fts (rowid, name)
+    SELECT id, name FROM foods
+    WHERE id > (SELECT CAST(value AS INTEGER) FROM settings WHERE key = 'fts_deferred_after');
+    DELETE FROM settings WHERE key = 'fts_deferred_after';
+    )";
+
+namespace {
+
+bool normalizeFoodBarcodes(sqlite3* db);
+
+const Migration migrations[] = {
+    { 1, "base tables", R"(
+    CREATE TABLE IF NOT EXISTS foods (
+        id INTEGER PRIMARY KEY AUTOINCREMENT,
+        barcode TEXT UNIQUE NOT NULL,
+        name TEXT NOT NULL,
+        calories_per_100g REAL NOT NULL,
+        protein REAL,
+        carbs REAL,
+        fat REAL
+        );
+
+    CREATE TABLE IF NOT EXISTS daily_log (
+        id INTEGER PRIMARY KEY AUTOINCREMENT,
+        date TEXT NOT NULL,
+        food_id INTEGER NOT NULL,
+        grams REAL NOT NULL,
+        FOREIGN KEY(food_id) REFERENCES foods(id) ON DELETE CASCADE
+        );
+
+    CREATE TABLE IF NOT EXISTS settings (
+        key TEXT PRIMARY KEY,
+        value TEXT NOT NULL
+        );
+    )", nullptr },
+
+    // Per-date reads become index range scans that never touch the table, and
+    // ON DELETE CASCADE from foods no longer scans the whole log.
+    { 2, "daily_log indexes", R"(
+    CREATE INDEX IF NOT EXISTS idx_daily_log_date_food ON daily_log(date, food_id, grams);
+    CREATE INDEX IF NOT EXISTS idx_daily_log_food ON daily_log(food_id);
+    )", nullptr },
+
+    // Per-day nutrition rollup kept current by triggers, so it changes in the same
+    // transaction as the log row. Inserts add the entry's contribution; deletes and
+    // updates recompute the affected day from the (indexed) log, which stays correct
+    // when the food row is already gone because of ON DELETE CASCADE. Bulk wipes
+    // empty daily_totals first so the delete trigger's WHEN clause skips the work.
+    { 3, "daily_totals rollup", R"(
+    CREATE TABLE IF NOT EXISTS daily_totals (
+        date TEXT PRIMARY KEY,
+        calories REAL NOT NULL,
+        protein REAL NOT NULL,
+        carbs REAL NOT NULL,
+        fat REAL NOT NULL,
+        entries INTEGER NOT NULL
+        ) WITHOUT ROWID;
+
+    CREATE TRIGGER IF NOT EXISTS trg_daily_log_insert AFTER INSERT ON daily_log
+    BEGIN
+        INSERT INTO daily_totals (date, calories, protein, carbs, fat, entries)
+        SELECT NEW.date,
+               f.calories_per_100g / 100.0 * NEW.grams,
+               COALESCE(f.protein, 0) / 100.0 * NEW.grams,
+               COALESCE(f.carbs, 0) / 100.0 * NEW.grams,
+               COALESCE(f.fat, 0) / 100.0 * NEW.grams,
+               1
+        FROM foods f WHERE f.id = NEW.food_id
+        ON CONFLICT(date) DO UPDATE SET
+            calories = calories + excluded.calories,
+            protein = protein + excluded.protein,
+            carbs = carbs + excluded.carbs,
+            fat = fat + excluded.fat,
+            entries = entries + 1;
+    END;
+
+    CREATE TRIGGER IF NOT EXISTS trg_daily_log_delete AFTER DELETE ON daily_log
+    WHEN EXISTS (SELECT 1 FROM daily_totals WHERE date = OLD.date)
+    BEGIN
+        DELETE FROM daily_totals WHERE date = OLD.date;
+        INSERT INTO daily_totals (date, calories, protein, carbs, fat, entries)
+        SELECT l.date,
+               SUM(f.calories_per_100g / 100.0 * l.grams),
+               SUM(COALESCE(f.protein, 0) / 100.0 * l.grams),
+               SUM(COALESCE(f.carbs, 0) / 100.0 * l.grams),
+               SUM(COALESCE(f.fat, 0) / 100.0 * l.grams),
+               COUNT(*)
+        FROM daily_log l JOIN foods f ON f.id = l.food_id
+        WHERE l.date = OLD.date
+        GROUP BY l.date;
+    END;
+
+    CREATE TRIGGER IF NOT EXISTS trg_daily_log_update AFTER UPDATE OF date, food_id, grams ON daily_log
+    BEGIN
+        DELETE FROM daily_totals WHERE date IN (OLD.date, NEW.date);
+        INSERT INTO daily_totals (date, calories, protein, carbs, fat, entries)
+        SELECT l.date,
+               SUM(f.calories_per_100g / 100.0 * l.grams),
+               SUM(COALESCE(f.protein, 0) / 100.0 * l.grams),
+               SUM(COALESCE(f.carbs, 0) / 100.0 * l.grams),
+               SUM(COALESCE(f.fat, 0) / 100.0 * l.grams),
+               COUNT(*)
+        FROM daily_log l JOIN foods f ON f.id = l.food_id
+        WHERE l.date IN (OLD.date, NEW.date)
+        GROUP BY l.date;
+    END;
+
+    INSERT INTO daily_totals (date, calories, protein, carbs, fat, entries)
+    SELECT l.date,
+           SUM(f.calories_per_100g / 100.0 * l.grams),
+           SUM(COALESCE(f.protein, 0) / 100.0 * l.grams),
+           SUM(COALESCE(f.carbs, 0) / 100.0 * l.grams),
+           SUM(COALESCE(f.fat, 0) / 100.0 * l.grams),
+           COUNT(*)
+    FROM daily_log l
+    JOIN foods f ON f.id = l.food_id
+    GROUP BY l.date;
+    )", nullptr },
+
+    // TEXT dates become day numbers (days since 1970-01-01): smaller rows and
+    // indexes, integer comparisons, and no string handling on the hot paths.
+    // julianday() of a 'YYYY-MM-DD' string is always N.5, so the subtraction is
+    // exact. Rows with unparseable dates violate NOT NULL and stop the migration
+    // rather than being dropped.
+    { 4, "integer day numbers", R"(
+    CREATE TABLE daily_log_v4 (
+        id INTEGER PRIMARY KEY AUTOINCREMENT,
+        day INTEGER NOT NULL,
+        food_id INTEGER NOT NULL,
+        grams REAL NOT NULL,
+        FOREIGN KEY(food_id) REFERENCES foods(id) ON DELETE CASCADE
+        );
+    INSERT INTO daily_log_v4 (id, day, food_id, grams)
+    SELECT id, CAST(julianday(date) - 2440587.5 AS INTEGER), food_id, grams FROM daily_log;
+    DROP TABLE daily_log;
+    ALTER TABLE daily_log_v4 RENAME TO daily_log;
+
+    CREATE TABLE daily_totals_v4 (
+        day INTEGER PRIMARY KEY,
+        calories REAL NOT NULL,
+        protein REAL NOT NULL,
+        carbs REAL NOT NULL,
+        fat REAL NOT NULL,
+        entries INTEGER NOT NULL
+        );
+    INSERT INTO daily_totals_v4 (day, calories, protein, carbs, fat, entries)
+    SELECT CAST(julianday(date) - 2440587.5 AS INTEGER), calories, protein, carbs, fat, entries FROM daily_totals;
+    DROP TABLE daily_totals;
+    ALTER TABLE daily_totals_v4 RENAME TO daily_totals;
+
+    CREATE INDEX idx_daily_log_day_food ON daily_log(day, food_id, grams);
+    CREATE INDEX idx_daily_log_food ON daily_log(food_id);
+
+    CREATE TRIGGER trg_daily_log_insert AFTER INSERT ON daily_log
+    BEGIN
+        INSERT INTO daily_totals (day, calories, protein, carbs, fat, entries)
+        SELECT NEW.day,
+               f.calories_per_100g / 100.0 * NEW.grams,
+               COALESCE(f.protein, 0) / 100.0 * NEW.grams,
+               COALESCE(f.carbs, 0) / 100.0 * NEW.grams,
+               COALESCE(f.fat, 0) / 100.0 * NEW.grams,
+               1
+        FROM foods f WHERE f.id = NEW.food_id
+        ON CONFLICT(day) DO UPDATE SET
+            calories = calories + excluded.calories,
+            protein = protein + excluded.protein,
+            carbs = carbs + excluded.carbs,
+            fat = fat + excluded.fat,
+            entries = entries + 1;
+    END;
+
+    CREATE TRIGGER trg_daily_log_delete AFTER DELETE ON daily_log
+    WHEN EXISTS (SELECT 1 FROM daily_totals WHERE day = OLD.day)
+    BEGIN
+        DELETE FROM daily_totals WHERE day = OLD.day;
+        INSERT INTO daily_totals (day, calories, protein, carbs, fat, entries)
+        SELECT l.day,
+               SUM(f.calories_per_100g / 100.0 * l.grams),
+               SUM(COALESCE(f.protein, 0) / 100.0 * l.grams),
+               SUM(COALESCE(f.carbs, 0) / 100.0 * l.grams),
+               SUM(COALESCE(f.fat, 0) / 100.0 * l.grams),
+               COUNT(*)
+        FROM daily_log l JOIN foods f ON f.id = l.food_id
+        WHERE l.day = OLD.day
+        GROUP BY l.day;
+    END;
+
+    CREATE TRIGGER trg_daily_log_update AFTER UPDATE OF day, food_id, grams ON daily_log
+    BEGIN
+        DELETE FROM daily_totals WHERE day IN (OLD.day, NEW.day);
+        INSERT INTO daily_totals (day, calories, protein, carbs, fat, entries)
+        SELECT l.day,
+               SUM(f.calories_per_100g / 100.0 * l.grams),
+               SUM(COALESCE(f.protein, 0) / 100.0 * l.grams),
+               SUM(COALESCE(f.carbs, 0) / 100.0 * l.grams),
+               SUM(COALESCE(f.fat, 0) / 100.0 * l.grams),
+               COUNT(*)
+        FROM daily_log l JOIN foods f ON f.id = l.food_id
+        WHERE l.day IN (OLD.day, NEW.day)
+        GROUP BY l.day;
+    END;
+    )", nullptr },
+
+    // External-content FTS5 index over foods.name. The triggers keep it in step
+    // with every write path (addFood, clears and resets); the prefix indexes
+    // make short "type-ahead" queries cheap. Per-row FTS5 inserts are slow, so
+    // bulk writers may defer rows above a watermark (see deferFoodSearchSyncSql).
+    { 5, "food name search", R"(
+    CREATE VIRTUAL TABLE foods_fts USING fts5(
+        name,
+        content = 'foods',
+        content_rowid = 'id',
+        tokenize = 'unicode61 remove_diacritics 2',
+        prefix = '2 3'
+        );
+
+    CREATE TRIGGER trg_foods_fts_insert AFTER INSERT ON foods
+    WHEN NOT EXISTS (SELECT 1 FROM settings WHERE key = 'fts_deferred_after')
+    BEGIN
+        INSERT INTO foods_fts (rowid, name) VALUES (NEW.id, NEW.name);
+    END;
+
+    CREATE TRIGGER trg_foods_fts_delete AFTER DELETE ON foods
+    WHEN NOT EXISTS (SELECT 1 FROM settings WHERE key = 'fts_deferred_after' AND CAST(value AS INTEGER) < OLD.id)
+    BEGIN
+        INSERT INTO foods_fts (foods_fts, rowid, name) VALUES ('delete', OLD.id, OLD.name);
+    END;
+
+    CREATE TRIGGER trg_foods_fts_update AFTER UPDATE OF name ON foods
+    WHEN NOT EXISTS (SELECT 1 FROM settings WHERE key = 'fts_deferred_after' AND CAST(value AS INTEGER) < OLD.id)
+    BEGIN
+        INSERT INTO foods_fts (foods_fts, rowid, name) VALUES ('delete', OLD.id, OLD.name);
+        INSERT INTO foods_fts (rowid, name) VALUES (NEW.id, NEW.name);
+    END;
+
+    INSERT INTO foods_fts (foods_fts) VALUES ('rebuild');
+    )", nullptr },
+
+    // Replay watermarks for offline log journals (LogJournal.h): the byte offset
+    // after the last record ingested, committed with the rows it covers.
+    { 6, "log journal replay", R"(
+    CREATE TABLE journal_replay (
+        journal_id INTEGER PRIMARY KEY,
+        offset INTEGER NOT NULL,
+        updated_at INTEGER NOT NULL
+        );
+    )", nullptr },
+
+    // daily_log becomes a view over one table per month (LogPartitions.h), so
+    // retention and clears drop whole tables instead of deleting row by row.
+    { 7, "monthly log partitions", nullptr, partitionDailyLog },
+
+    // Recipes are foods rows whose nutrition is computed from recipe_items
+    // (ingredient foods or other recipes, by grams), so logging and reading them
+    // needs nothing new. A nutrition change marks the recipes that use the food
+    // directly; refreshRecipes (Recipes.h) recomputes them and their ancestors.
+    // Ingredients cannot be deleted while a recipe uses them. Log entries read
+    // the food's current values, so a change also moves the rollup of the days
+    // the food was logged on by the difference.
+    { 8, "recipes", R"(
+    CREATE TABLE recipes (
+        food_id INTEGER PRIMARY KEY REFERENCES foods(id) ON DELETE CASCADE,
+        yield_grams REAL,
+        dirty INTEGER NOT NULL DEFAULT 0
+        );
+
+    CREATE TABLE recipe_items (
+        recipe_id INTEGER NOT NULL REFERENCES recipes(food_id) ON DELETE CASCADE,
+        food_id INTEGER NOT NULL REFERENCES foods(id),
+        grams REAL NOT NULL CHECK (grams > 0),
+        PRIMARY KEY (recipe_id, food_id)
+        ) WITHOUT ROWID;
+
+    CREATE INDEX idx_recipe_items_food ON recipe_items(food_id, recipe_id);
+    CREATE INDEX idx_recipes_dirty ON recipes(food_id) WHERE dirty = 1;
+
+    CREATE TRIGGER trg_foods_recipe_dirty AFTER UPDATE OF calories_per_100g, protein, carbs, fat ON foods
+    WHEN OLD.calories_per_100g IS NOT NEW.calories_per_100g OR OLD.protein IS NOT NEW.protein
+         OR OLD.carbs IS NOT NEW.carbs OR OLD.fat IS NOT NEW.fat
+    BEGIN
+        UPDATE recipes SET dirty = 1
+        WHERE dirty = 0 AND food_id IN (SELECT recipe_id FROM recipe_items WHERE food_id = NEW.id);
+    END;
+
+    CREATE TRIGGER trg_foods_nutrition_totals AFTER UPDATE OF calories_per_100g, protein, carbs, fat ON foods
+    WHEN OLD.calories_per_100g IS NOT NEW.calories_per_100g OR OLD.protein IS NOT NEW.protein
+         OR OLD.carbs IS NOT NEW.carbs OR OLD.fat IS NOT NEW.fat
+    BEGIN
+        UPDATE daily_totals SET
+            calories = calories + (NEW.calories_per_100g - OLD.calories_per_100g) / 100.0 * g.grams,
+            protein = protein + (COALESCE(NEW.protein, 0) - COALESCE(OLD.protein, 0)) / 100.0 * g.grams,
+            carbs = carbs + (COALESCE(NEW.carbs, 0) - COALESCE(OLD.carbs, 0)) / 100.0 * g.grams,
+            fat = fat + (COALESCE(NEW.fat, 0) - COALESCE(OLD.fat, 0)) / 100.0 * g.grams
+        FROM (SELECT day, SUM(grams) AS grams FROM daily_log WHERE food_id = NEW.id GROUP BY day) AS g
+        WHERE daily_totals.day = g.day;
+    END;
+    )", nullptr },
+
+    // Change tracking for delta sync (Sync.h). food_changes holds one row per
+    // barcode, renumbered (seq) on every change and stamped with when and on
+    // which device the current values were written; the stamp decides barcode
+    // conflicts. Log rows need no tracking: ids only grow within a month, so
+    // per-peer, per-month id cursors find new rows. log_origins maps rows that
+    // came from other devices to their origin so they are applied only once.
+    // `via` is the device a change was received from, so it is not sent back.
+    { 9, "sync change tracking", R"(
+    INSERT INTO settings (key, value) VALUES ('device_id', CAST(abs(random() >> 1) AS TEXT));
+
+    CREATE TABLE food_changes (
+        seq INTEGER PRIMARY KEY AUTOINCREMENT,
+        barcode TEXT NOT NULL UNIQUE,
+        changed_at INTEGER NOT NULL,
+        device INTEGER NOT NULL,
+        via INTEGER
+        );
+
+    INSERT INTO food_changes (barcode, changed_at, device)
+    SELECT barcode, 0, (SELECT CAST(value AS INTEGER) FROM settings WHERE key = 'device_id')
+    FROM foods ORDER BY id;
+
+    CREATE TRIGGER trg_foods_changes_insert AFTER INSERT ON foods
+    BEGIN
+        DELETE FROM food_changes WHERE barcode = NEW.barcode;
+        INSERT INTO food_changes (barcode, changed_at, device)
+        VALUES (NEW.barcode, CAST((julianday('now') - 2440587.5) * 86400000 AS INTEGER),
+                (SELECT CAST(value AS INTEGER) FROM settings WHERE key = 'device_id'));
+    END;
+
+    CREATE TRIGGER trg_foods_changes_update AFTER UPDATE OF name, calories_per_100g, protein, carbs, fat ON foods
+    WHEN OLD.name IS NOT NEW.name OR OLD.calories_per_100g IS NOT NEW.calories_per_100g
+         OR OLD.protein IS NOT NEW.protein OR OLD.carbs IS NOT NEW.carbs OR OLD.fat IS NOT NEW.fat
+    BEGIN
+        DELETE FROM food_changes WHERE barcode = NEW.barcode;
+        INSERT INTO food_changes (barcode, changed_at, device)
+        VALUES (NEW.barcode, CAST((julianday('now') - 2440587.5) * 86400000 AS INTEGER),
+                (SELECT CAST(value AS INTEGER) FROM settings WHERE key = 'device_id'));
+    END;
+
+    CREATE TRIGGER trg_foods_changes_delete AFTER DELETE ON foods
+    BEGIN
+        DELETE FROM food_changes WHERE barcode = OLD.barcode;
+    END;
+
+    CREATE TABLE log_origins (
+        id INTEGER PRIMARY KEY,
+        device INTEGER NOT NULL,
+        origin_id INTEGER NOT NULL,
+        via INTEGER NOT NULL,
+        UNIQUE (device, origin_id)
+        );
+
+    CREATE TABLE sync_peers (
+        peer TEXT PRIMARY KEY,
+        device INTEGER,
+        food_seq INTEGER NOT NULL DEFAULT 0
+        );
+
+    CREATE TABLE sync_log_cursors (
+        peer TEXT NOT NULL REFERENCES sync_peers(peer) ON DELETE CASCADE,
+        month INTEGER NOT NULL,
+        last_id INTEGER NOT NULL,
+        PRIMARY KEY (peer, month)
+        ) WITHOUT ROWID;
+    )", nullptr },
+
+    // Barcodes are stored normalized (Gtin.h): valid GTINs as GTIN-14, other
+    // codes trimmed of scanner noise. Rows that become duplicates are merged
+    // into the one already in canonical form, or the oldest, with their log
+    // rows; rows that recipes use keep their old barcode.
+    { 10, "normalized barcodes", nullptr, normalizeFoodBarcodes },
+};
+
+bool normalizeFoodBarcodes(sqlite3* db) {
+    if (!registerGtinFunctions(db)) return false;
+
+    struct Change {
+        long long id;
+        std::string from;
+        std::string to;
+    };
+    // Oldest first: when no row has the canonical form yet, the first one
+    // renamed to it is the survivor the later duplicates merge into.
+    std::vector<Change> changes;
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db,
+            "SELECT id, barcode, gtin FROM (SELECT id, barcode, gtin_normalize(barcode) AS gtin FROM foods) "
+            "WHERE gtin <> barcode ORDER BY id;", -1, &stmt, nullptr) != SQLITE_OK) {
+        return false;
+    }
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        changes.push_back(Change{ sqlite3_column_int64(stmt, 0),
+                                  reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1)),
+                                  reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2)) });
+    }
+    if (sqlite3_finalize(stmt) != SQLITE_OK) return false;
+
+    Statement findId, rename, renameChange, inRecipes;
+    if (!findId.prepare(db, "SELECT id FROM foods WHERE barcode = ?;") ||
+        !rename.prepare(db, "UPDATE foods SET barcode = ? WHERE id = ?;") ||
+        !renameChange.prepare(db, "UPDATE OR REPLACE food_changes SET barcode = ? WHERE barcode = ?;") ||
+        !inRecipes.prepare(db,
+            "SELECT EXISTS (SELECT 1 FROM recipes WHERE food_id = ?1) "
+            "OR EXISTS (SELECT 1 FROM recipe_items WHERE food_id = ?1);")) {
+        return false;
+    }
+    const std::vector<int> months = listLogPartitions(db);
+    long long merged = 0;
+    long long kept = 0;
+
+    for (const Change& change : changes) {
+        sqlite3_bind_text(findId.get(), 1, change.to.c_str(), -1, SQLITE_STATIC);
+        const bool exists = sqlite3_step(findId.get()) == SQLITE_ROW;
+        const long long survivor = exists ? sqlite3_column_int64(findId.get(), 0) : 0;
+        sqlite3_reset(findId.get());
+
+        if (!exists) {
+            sqlite3_bind_text(rename.get(), 1, change.to.c_str(), -1, SQLITE_STATIC);
+            sqlite3_bind_int64(rename.get(), 2, change.id);
+            sqlite3_bind_text(renameChange.get(), 1, change.to.c_str(), -1, SQLITE_STATIC);
+            sqlite3_bind_text(renameChange.get(), 2, change.from.c_str(), -1, SQLITE_STATIC);
+            const bool ok = sqlite3_step(rename.get()) == SQLITE_DONE &&
+                            sqlite3_step(renameChange.get()) == SQLITE_DONE;
+            sqlite3_reset(rename.get());
+            sqlite3_reset(renameChange.get());
+            if (!ok) return false;
+            continue;
+        }
+
+        sqlite3_bind_int64(inRecipes.get(), 1, change.id);
+        const bool usedByRecipes = sqlite3_step(inRecipes.get()) == SQLITE_ROW &&
+                                   sqlite3_column_int(inRecipes.get(), 0) != 0;
+        sqlite3_reset(inRecipes.get());
+        if (usedByRecipes) {
+            ++kept;
+            continue;
+        }
+
+        // Log rows move to the survivor before the delete could cascade to them.
+        const std::string ids = std::to_string(survivor) + " WHERE food_id = " + std::to_string(change.id) + ";";
+        for (int month : months) {
+            if (!execSql(db, ("UPDATE " + logPartitionTable(month) + " SET food_id = " + ids).c_str())) return false;
+        }
+        if (!execSql(db, ("DELETE FROM foods WHERE id = " + std::to_string(change.id) + ";").c_str())) return false;
+        ++merged;
+    }
+
+    // Moved log rows now count with the survivor's nutrition.
+    if (merged > 0 && !execSql(db, rebuildDailyTotalsSql)) return false;
+    if (merged > 0 || kept > 0) {
+        std::cerr << "Barcode normalization merged " << merged << " duplicate foods";
+        if (kept > 0) std::cerr << "; " << kept << " used by recipes keep their barcode";
+        std::cerr << ".\n";
+    }
+    return true;
+}
+
+} // namespace
+
+int schemaVersion(sqlite3* db) {
+    sqlite3_stmt* stmt = nullptr;
+    int version = 0;
+    if (sqlite3_prepare_v2(db, "PRAGMA user_version;", -1, &stmt, nullptr) == SQLITE_OK &&
+        sqlite3_step(stmt) == SQLITE_ROW) {
+        version = sqlite3_column_int(stmt, 0);
+    }
+    sqlite3_finalize(stmt);
+    return version;
+}
+
+int latestSchemaVersion() {
+    return migrations[sizeof(migrations) / sizeof(migrations[0]) - 1].version;
+}
+
+bool applyMigrations(sqlite3* db) {
+    int current = schemaVersion(db);
+    if (current > latestSchemaVersion()) {
+        // Writing through an older schema's assumptions could corrupt data
+        // the newer build relies on.
+        std::cerr << "Database schema version " << current << " is newer than this build ("
+                  << latestSchemaVersion() << "); refusing to use it.\n";
+        return false;
+    }
+
+    for (const Migration& m : migrations) {
+        if (m.version <= current) continue;
+
+        if (!execSql(db, "BEGIN IMMEDIATE;")) return false;
+
+        bool ok = (!m.sql || execSql(db, m.sql)) && (!m.apply || m.apply(db));
+        if (ok) {
+            std::string bump = "PRAGMA user_version = " + std::to_string(m.version) + ";";
+            ok = execSql(db, bump.c_str());
+        }
+
+        if (!ok || !execSql(db, "COMMIT;")) {
+            std::cerr << "Migration " << m.version << " (" << m.description << ") failed.\n";
+            execSql(db, "ROLLBACK;");
+            return false;
+        }
+    }
+
+    return true;
+}
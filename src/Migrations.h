@@ -0,0 +1,27 @@
+#pragma once
+#include "sqlite3.h"
+
+// One step of the schema history. PRAGMA user_version records the last step
+// applied; each step runs in its own transaction.
+struct Migration {
+    int version;
+    const char* description;
+    const char* sql;                // may be null when `apply` does all the work
+    bool (*apply)(sqlite3* db);     // optional step run after `sql`
+};
+
+int schemaVersion(sqlite3* db);
+int latestSchemaVersion();
+
+// Brings the database up to latestSchemaVersion(), applying pending steps in
+// order. Fails for a database whose schema is newer than this build.
+bool applyMigrations(sqlite3* db);
+
+// Recomputes daily_totals from daily_log, e.g. after foods nutrition values change.
+extern const char* const rebuildDailyTotalsSql;
+
+// Bulk inserts into foods: run deferFoodSearchSyncSql after BEGIN so new rows
+// skip the per-row foods_fts trigger, and flushFoodSearchSyncSql before COMMIT
+// to index them in one statement. Both must run in the same transaction.
+extern const char* const deferFoodSearchSyncSql;
+extern const char* const flushFoodSearchSyncSql;
@@ -0,0 +1,38 @@
+#pragma once
+#include <cstddef>
+
+// Nutrient amounts for one log entry, one day, or 100 g of a food. The layout is
+// fixed at eight doubles (one 64-byte cache line), so adding two values or
+// summing an array is a plain loop over lanes that compiles to SIMD adds.
+// Fiber, sugar and sodium are reserved lanes; they stay 0 until foods stores them.
+struct alignas(64) Nutrients {
+    enum Lane { Calories, Protein, Carbs, Fat, Fiber, Sugar, Sodium, Reserved, LaneCount };
+
+    double lane[LaneCount] = {};
+
+    double calories() const { return lane[Calories]; }
+    double protein() const { return lane[Protein]; }
+    double carbs() const { return lane[Carbs]; }
+    double fat() const { return lane[Fat]; }
+    double fiber() const { return lane[Fiber]; }
+    double sugar() const { return lane[Sugar]; }
+    double sodium() const { return lane[Sodium]; }
+
+    Nutrients& operator+=(const Nutrients& other) {
+        for (int i = 0; i < LaneCount; ++i) lane[i] += other.lane[i];
+        return *this;
+    }
+
+    // Per-100 g amounts scaled to `grams`.
+    Nutrients scaledTo(double grams) const {
+        Nutrients out;
+        const double factor = grams / 100.0;
+        for (int i = 0; i < LaneCount; ++i) out.lane[i] = lane[i] * factor;
+        return out;
+    }
+};
+
+static_assert(sizeof(Nutrients) == 64, "Nutrients is one cache line");
+
+// Lane-wise sum of `count` values.
+Nutrients sumNutrients(const Nutrients* values, size_t count);
@@ -0,0 +1,62 @@
+#include "NutritionSeries.h"
+#include <algorithm>
+
+std::vector<double> toDailyValues(const NutritionSeries& series, const std::vector<double>& column, int dayCount) {
+    std::vector<double> daily(static_cast<size_t>(std::max(dayCount, 0)), 0.0);
+    for (size_t i = 0; i < series.size(); ++i) {
+        int day = series.dayOffset[i];
+        if (day >= 0 && day < dayCount) daily[day] = column[i];
+    }
+    return daily;
+}
+
+std::vector<double> rollingAverage(const std::vector<double>& values, int window) {
+    const size_t n = values.size();
+    std::vector<double> out(n);
+    if (window <= 0 || n == 0) return out;
+
+    // Prefix sums first, then one independent subtraction per element.
+    std::vector<double> prefix(n + 1, 0.0);
+    for (size_t i = 0; i < n; ++i) prefix[i + 1] = prefix[i] + values[i];
+
+    const size_t w = static_cast<size_t>(window);
+    const size_t head = std::min(w, n);
+    for (size_t i = 0; i < head; ++i) {
+        out[i] = prefix[i + 1] / static_cast<double>(i + 1);
+    }
+
+    const double inv = 1.0 / static_cast<double>(w);
+    const double* hi = prefix.data() + w + 1;
+    const double* lo = prefix.data() + 1;
+    for (size_t i = head; i < n; ++i) {
+        out[i] = (hi[i - w] - lo[i - w]) * inv;
+    }
+    return out;
+}
+
+std::vector<double> goalDeltas(const std::vector<double>& values, double goal) {
+    std::vector<double> out(values.size());
+    const double* in = values.data();
+    double* dst = out.data();
+    for (size_t i = 0, n = values.size(); i < n; ++i) {
+        dst[i] = in[i] - goal;
+    }
+    return out;
+}
+
+int longestStreakWithinGoal(const NutritionSeries& series, double goal) {
+    int best = 0;
+    int current = 0;
+    int previousDay = 0;
+
+    for (size_t i = 0; i < series.size(); ++i) {
+        const int day = series.dayOffset[i];
+        const bool within = series.calories[i] <= goal;
+        const bool consecutive = i > 0 && day == previousDay + 1;
+
+        current = within ? (consecutive ? current + 1 : 1) : 0;
+        best = std::max(best, current);
+        previousDay = day;
+    }
+    return best;
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include <vector>
+#include "Date.h"
+
+// Per-day nutrition totals for a date range, stored column by column so the
+// analytics below run as plain loops over contiguous arrays. Only days with
+// log entries are present; dayOffset[i] is the day's distance from `from`.
+struct NutritionSeries {
+    Date from;
+    Date to;
+    std::vector<int> dayOffset;
+    std::vector<double> calories;
+    std::vector<double> protein;
+    std::vector<double> carbs;
+    std::vector<double> fat;
+
+    size_t size() const { return dayOffset.size(); }
+};
+
+// Spreads one column over `dayCount` calendar days, filling days without entries with 0.
+std::vector<double> toDailyValues(const NutritionSeries& series, const std::vector<double>& column, int dayCount);
+
+// Average of the trailing `window` values at each position (shorter at the start).
+std::vector<double> rollingAverage(const std::vector<double>& values, int window);
+
+// values[i] - goal for every element.
+std::vector<double> goalDeltas(const std::vector<double>& values, double goal);
+
+// Longest run of consecutive logged days whose calories stay at or under `goal`.
+int longestStreakWithinGoal(const NutritionSeries& series, double goal);
@@ -0,0 +1,283 @@
+#include "Recipes.h"
+#include "Gtin.h"
+#include "SqlExec.h"
+#include <deque>
+#include <iostream>
+#include <unordered_map>
+
+namespace {
+
+// Dirty recipes plus everything that uses them, one row per (recipe, parent
+// recipe) edge; recipes nothing uses come back once with a NULL parent.
+const char* const affectedSql = R"(
+    WITH RECURSIVE affected(id) AS (
+        SELECT food_id FROM recipes WHERE dirty = 1
+        UNION
+        SELECT ri.recipe_id FROM recipe_items ri JOIN affected a ON ri.food_id = a.id
+    )
+    SELECT a.id, ri.recipe_id FROM affected a LEFT JOIN recipe_items ri ON ri.food_id = a.id;
+    )";
+
+// 1 when `ancestor` is `id` or one of its (transitive) ingredients.
+const char* const containsSql = R"(
+    WITH RECURSIVE below(id) AS (
+        SELECT ?1
+        UNION
+        SELECT ri.food_id FROM recipe_items ri JOIN below b ON ri.recipe_id = b.id
+    )
+    SELECT 1 FROM below WHERE id = ?2 LIMIT 1;
+    )";
+
+// The statements one refresh uses for every recipe it recomputes.
+struct RecomputeStatements {
+    Statement ingredients;
+    Statement writeFood;
+    Statement clearDirty;
+
+    bool prepare(sqlite3* db) {
+        return ingredients.prepare(db,
+                   "SELECT r.yield_grams, ri.grams, f.calories_per_100g, f.protein, f.carbs, f.fat "
+                   "FROM recipes r JOIN recipe_items ri ON ri.recipe_id = r.food_id "
+                   "JOIN foods f ON f.id = ri.food_id WHERE r.food_id = ?;") &&
+               writeFood.prepare(db,
+                   "UPDATE foods SET calories_per_100g = ?, protein = ?, carbs = ?, fat = ? WHERE id = ?;") &&
+               clearDirty.prepare(db, "UPDATE recipes SET dirty = 0 WHERE food_id = ? AND dirty = 1;");
+    }
+};
+
+// Sums the ingredients' current values and caches the per-100g result in the
+// recipe's foods row. The write marks recipes using this one dirty, which the
+// caller clears when it reaches them.
+bool recompute(RecomputeStatements& s, long long recipeId) {
+    double yieldGrams = 0.0, totalGrams = 0.0;
+    double calories = 0.0, protein = 0.0, carbs = 0.0, fat = 0.0;
+    {
+        sqlite3_stmt* stmt = s.ingredients.get();
+        StatementReset reset(stmt);
+        sqlite3_bind_int64(stmt, 1, recipeId);
+        int rc;
+        while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+            yieldGrams = sqlite3_column_double(stmt, 0);
+            const double grams = sqlite3_column_double(stmt, 1);
+            totalGrams += grams;
+            calories += sqlite3_column_double(stmt, 2) / 100.0 * grams;
+            protein += sqlite3_column_double(stmt, 3) / 100.0 * grams;
+            carbs += sqlite3_column_double(stmt, 4) / 100.0 * grams;
+            fat += sqlite3_column_double(stmt, 5) / 100.0 * grams;
+        }
+        if (rc != SQLITE_DONE) return false;
+    }
+
+    const double weight = yieldGrams > 0.0 ? yieldGrams : totalGrams;
+    const double per100g = weight > 0.0 ? 100.0 / weight : 0.0;
+    {
+        sqlite3_stmt* stmt = s.writeFood.get();
+        StatementReset reset(stmt);
+        sqlite3_bind_double(stmt, 1, calories * per100g);
+        sqlite3_bind_double(stmt, 2, protein * per100g);
+        sqlite3_bind_double(stmt, 3, carbs * per100g);
+        sqlite3_bind_double(stmt, 4, fat * per100g);
+        sqlite3_bind_int64(stmt, 5, recipeId);
+        if (sqlite3_step(stmt) != SQLITE_DONE) return false;
+    }
+    sqlite3_stmt* stmt = s.clearDirty.get();
+    StatementReset reset(stmt);
+    sqlite3_bind_int64(stmt, 1, recipeId);
+    return sqlite3_step(stmt) == SQLITE_DONE;
+}
+
+// Kahn's algorithm over the affected subgraph: a recipe is recomputed once all
+// of its affected ingredients have been.
+int refreshDirty(sqlite3* db) {
+    std::unordered_map<long long, int> pendingIngredients;
+    std::unordered_map<long long, std::vector<long long>> usedBy;
+    {
+        sqlite3_stmt* stmt = nullptr;
+        if (sqlite3_prepare_v2(db, affectedSql, -1, &stmt, nullptr) != SQLITE_OK) return -1;
+        int rc;
+        while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+            const long long id = sqlite3_column_int64(stmt, 0);
+            pendingIngredients.emplace(id, 0);
+            if (sqlite3_column_type(stmt, 1) == SQLITE_NULL) continue;
+            const long long parent = sqlite3_column_int64(stmt, 1);
+            usedBy[id].push_back(parent);
+            ++pendingIngredients[parent];
+        }
+        sqlite3_finalize(stmt);
+        if (rc != SQLITE_DONE) return -1;
+    }
+    if (pendingIngredients.empty()) return 0;
+
+    RecomputeStatements statements;
+    if (!statements.prepare(db)) return -1;
+
+    std::deque<long long> ready;
+    for (const auto& entry : pendingIngredients) {
+        if (entry.second == 0) ready.push_back(entry.first);
+    }
+    int recomputed = 0;
+    while (!ready.empty()) {
+        const long long id = ready.front();
+        ready.pop_front();
+        if (!recompute(statements, id)) return -1;
+        ++recomputed;
+        auto parents = usedBy.find(id);
+        if (parents == usedBy.end()) continue;
+        for (long long parent : parents->second) {
+            if (--pendingIngredients[parent] == 0) ready.push_back(parent);
+        }
+    }
+
+    if (recomputed != static_cast<int>(pendingIngredients.size())) {
+        std::cerr << "Recipe refresh found a cycle.\n";
+        return -1;
+    }
+    return recomputed;
+}
+
+// Resolves and stores the ingredients; repeated barcodes add up. With
+// `checkCycles`, refuses an ingredient that is the recipe itself or contains
+// it; a recipe nothing uses yet cannot be contained by its ingredients.
+bool writeItems(DatabaseManager& db, long long recipeId, const std::vector<RecipeItem>& items, bool checkCycles) {
+    sqlite3* handle = db.handle();
+    Statement insert, contains;
+    if (!insert.prepare(handle,
+            "INSERT INTO recipe_items (recipe_id, food_id, grams) VALUES (?, ?, ?) "
+            "ON CONFLICT(recipe_id, food_id) DO UPDATE SET grams = grams + excluded.grams;") ||
+        !contains.prepare(handle, containsSql)) {
+        return false;
+    }
+
+    for (const RecipeItem& item : items) {
+        auto foodId = db.findFoodId(item.barcode);
+        if (!foodId) {
+            std::cerr << "Unknown ingredient: " << item.barcode << "\n";
+            return false;
+        }
+        if (!(item.grams > 0.0)) {
+            std::cerr << "Ingredient " << item.barcode << " needs a positive weight.\n";
+            return false;
+        }
+        if (checkCycles || *foodId == recipeId) {
+            StatementReset reset(contains.get());
+            sqlite3_bind_int64(contains.get(), 1, *foodId);
+            sqlite3_bind_int64(contains.get(), 2, recipeId);
+            if (sqlite3_step(contains.get()) == SQLITE_ROW) {
+                std::cerr << "Ingredient " << item.barcode << " would make the recipe contain itself.\n";
+                return false;
+            }
+        }
+        StatementReset reset(insert.get());
+        sqlite3_bind_int64(insert.get(), 1, recipeId);
+        sqlite3_bind_int64(insert.get(), 2, *foodId);
+        sqlite3_bind_double(insert.get(), 3, item.grams);
+        if (sqlite3_step(insert.get()) != SQLITE_DONE) {
+            std::cerr << "Ingredient insert failed: " << sqlite3_errmsg(handle) << "\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+bool markDirty(sqlite3* db, long long recipeId, double yieldGrams) {
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db,
+            "INSERT INTO recipes (food_id, yield_grams, dirty) VALUES (?, NULLIF(?, 0), 1) "
+            "ON CONFLICT(food_id) DO UPDATE SET yield_grams = excluded.yield_grams, dirty = 1;",
+            -1, &stmt, nullptr) != SQLITE_OK) {
+        return false;
+    }
+    sqlite3_bind_int64(stmt, 1, recipeId);
+    sqlite3_bind_double(stmt, 2, yieldGrams > 0.0 ? yieldGrams : 0.0);
+    const bool ok = sqlite3_step(stmt) == SQLITE_DONE;
+    sqlite3_finalize(stmt);
+    return ok;
+}
+
+} // namespace
+
+bool addRecipe(DatabaseManager& db, const Recipe& recipe) {
+    if (recipe.barcode.empty() || recipe.name.empty() || recipe.items.empty()) {
+        std::cerr << "A recipe needs a barcode, a name and at least one ingredient.\n";
+        return false;
+    }
+
+    // Nutrition starts at zero and is computed before the transaction commits.
+    const bool ok = inTransaction(db.handle(), "recipes", [&] {
+        if (!db.addFood(Food{ recipe.barcode, recipe.name, 0.0, 0.0, 0.0, 0.0 })) return false;
+        auto recipeId = db.findFoodId(recipe.barcode);
+        return recipeId && markDirty(db.handle(), *recipeId, recipe.yieldGrams) &&
+               writeItems(db, *recipeId, recipe.items, false) && refreshDirty(db.handle()) >= 0;
+    });
+    db.invalidateBarcodeCache();
+    return ok;
+}
+
+bool setRecipeItems(DatabaseManager& db, const std::string& barcode, const std::vector<RecipeItem>& items,
+                    double yieldGrams) {
+    if (items.empty()) {
+        std::cerr << "A recipe needs at least one ingredient.\n";
+        return false;
+    }
+    auto recipe = getRecipe(db, barcode);
+    if (!recipe) {
+        std::cerr << "No recipe with barcode " << barcode << "\n";
+        return false;
+    }
+
+    const bool ok = inTransaction(db.handle(), "recipes", [&] {
+        auto recipeId = db.findFoodId(barcode);
+        if (!recipeId) return false;
+        sqlite3_stmt* stmt = nullptr;
+        if (sqlite3_prepare_v2(db.handle(), "DELETE FROM recipe_items WHERE recipe_id = ?;", -1, &stmt, nullptr) !=
+            SQLITE_OK) {
+            return false;
+        }
+        sqlite3_bind_int64(stmt, 1, *recipeId);
+        const bool cleared = sqlite3_step(stmt) == SQLITE_DONE;
+        sqlite3_finalize(stmt);
+        return cleared && markDirty(db.handle(), *recipeId, yieldGrams) && writeItems(db, *recipeId, items, true) &&
+               refreshDirty(db.handle()) >= 0;
+    });
+    db.invalidateBarcodeCache();
+    return ok;
+}
+
+std::optional<Recipe> getRecipe(DatabaseManager& db, const std::string& input) {
+    const std::string barcode = normalizeBarcode(input);
+    sqlite3* handle = db.handle();
+    Statement head, items;
+    if (!head.prepare(handle,
+            "SELECT r.food_id, f.name, COALESCE(r.yield_grams, 0) FROM recipes r "
+            "JOIN foods f ON f.id = r.food_id WHERE f.barcode = ?;") ||
+        !items.prepare(handle,
+            "SELECT f.barcode, ri.grams FROM recipe_items ri JOIN foods f ON f.id = ri.food_id "
+            "WHERE ri.recipe_id = ? ORDER BY f.barcode;")) {
+        return std::nullopt;
+    }
+
+    sqlite3_bind_text(head.get(), 1, barcode.c_str(), -1, SQLITE_STATIC);
+    if (sqlite3_step(head.get()) != SQLITE_ROW) return std::nullopt;
+
+    Recipe recipe;
+    recipe.barcode = barcode;
+    recipe.name = reinterpret_cast<const char*>(sqlite3_column_text(head.get(), 1));
+    recipe.yieldGrams = sqlite3_column_double(head.get(), 2);
+
+    sqlite3_bind_int64(items.get(), 1, sqlite3_column_int64(head.get(), 0));
+    while (sqlite3_step(items.get()) == SQLITE_ROW) {
+        recipe.items.push_back(RecipeItem{ reinterpret_cast<const char*>(sqlite3_column_text(items.get(), 0)),
+                                           sqlite3_column_double(items.get(), 1) });
+    }
+    return recipe;
+}
+
+int refreshRecipes(DatabaseManager& db) {
+    int recomputed = 0;
+    const bool ok = inTransaction(db.handle(), "recipes", [&] {
+        recomputed = refreshDirty(db.handle());
+        return recomputed >= 0;
+    });
+    if (recomputed > 0) db.invalidateBarcodeCache();
+    return ok ? recomputed : -1;
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include <optional>
+#include <string>
+#include <vector>
+#include "DatabaseManager.h"
+
+// Recipes are named compositions of foods, stored as foods rows whose per-100g
+// nutrition is computed from their ingredients and cached in the row. Logging
+// a recipe is one daily_log insert, and every read path treats it as a food.
+// Ingredients may themselves be recipes, as long as no recipe contains itself.
+
+struct RecipeItem {
+    std::string barcode;
+    double grams = 0.0;
+};
+
+struct Recipe {
+    std::string barcode;            // recipes are looked up and logged by barcode
+    std::string name;
+    std::vector<RecipeItem> items;
+    double yieldGrams = 0.0;        // weight after cooking; 0 uses the sum of item grams
+};
+
+// Adds the recipe and computes its nutrition. Every ingredient must exist.
+bool addRecipe(DatabaseManager& db, const Recipe& recipe);
+
+// Replaces an existing recipe's ingredients and yield, then recomputes it and
+// every recipe that uses it. Refuses changes that would create a cycle.
+bool setRecipeItems(DatabaseManager& db, const std::string& barcode, const std::vector<RecipeItem>& items,
+                    double yieldGrams = 0.0);
+
+std::optional<Recipe> getRecipe(DatabaseManager& db, const std::string& barcode);
+
+// Recomputes the recipes marked dirty by nutrition changes and every recipe
+// that (transitively) uses them, each exactly once with its ingredients first.
+// Runs in the caller's transaction if one is open. Returns the number of
+// recipes recomputed, or -1 on error.
+int refreshRecipes(DatabaseManager& db);
@@ -0,0 +1,351 @@
+#include "ReportEngine.h"
+#include "Migrations.h"
+#include "WorkStealingPool.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+
+namespace {
+
+Date weekKey(Date d) {
+    // 1970-01-01 was a Thursday; weeks start on Monday.
+    const int weekday = ((d.days() + 3) % 7 + 7) % 7;
+    return d + -weekday;
+}
+
+Date monthKey(Date d) {
+    int y = 0, m = 0, day = 0;
+    d.ymd(y, m, day);
+    return Date::fromYmd(y, m, 1);
+}
+
+Date monthEnd(Date monthStart) {
+    int y = 0, m = 0, day = 0;
+    monthStart.ymd(y, m, day);
+    return Date::fromYmd(y, m, daysInMonth(y, m));
+}
+
+void addDay(PeriodSummary& p, const DailyTotals& d, double goal) {
+    ++p.daysLogged;
+    if (goal > 0 && d.calories <= goal) ++p.daysWithinGoal;
+    p.entries += d.entries;
+    p.calories += d.calories;
+    p.protein += d.protein;
+    p.carbs += d.carbs;
+    p.fat += d.fat;
+}
+
+PeriodSummary clippedPeriod(Date start, Date end, const ReportJob& job) {
+    PeriodSummary p;
+    p.start = job.from < start ? start : job.from;
+    p.end = end < job.to ? end : job.to;
+    return p;
+}
+
+double adherence(const PeriodSummary& p) {
+    return p.daysLogged > 0 ? static_cast<double>(p.daysWithinGoal) / p.daysLogged : 0.0;
+}
+
+// Output is built per report into a string outside the writer lock.
+void appendNumber(std::string& out, double v) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%.2f", v);
+    out += buf;
+}
+
+void appendInt(std::string& out, long long v) {
+    out += std::to_string(v);
+}
+
+void appendDate(std::string& out, Date d) {
+    char buf[10];
+    d.format(buf);
+    out.append(buf, sizeof(buf));
+}
+
+void appendCsvField(std::string& out, const std::string& s) {
+    if (s.find_first_of(",\"\r\n") == std::string::npos) {
+        out += s;
+        return;
+    }
+    out += '"';
+    for (char c : s) {
+        if (c == '"') out += '"';
+        out += c;
+    }
+    out += '"';
+}
+
+void appendJsonString(std::string& out, const std::string& s) {
+    out += '"';
+    for (char c : s) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            out += ' ';
+        } else {
+            out += c;
+        }
+    }
+    out += '"';
+}
+
+const char* const csvHeader =
+    "user,period,start,end,days_logged,days_within_goal,adherence,entries,"
+    "calories,protein,carbs,fat,goal,food_barcode,food_name,grams\n";
+
+void appendCsvPeriod(std::string& out, const UserReport& r, const char* kind, const PeriodSummary& p) {
+    appendCsvField(out, r.job->user);
+    out += ',';
+    out += kind;
+    out += ',';
+    appendDate(out, p.start);
+    out += ',';
+    appendDate(out, p.end);
+    out += ',';
+    appendInt(out, p.daysLogged);
+    out += ',';
+    appendInt(out, p.daysWithinGoal);
+    out += ',';
+    appendNumber(out, adherence(p));
+    out += ',';
+    appendInt(out, p.entries);
+    for (double v : { p.calories, p.protein, p.carbs, p.fat, r.goal }) {
+        out += ',';
+        appendNumber(out, v);
+    }
+    out += ",,,\n";
+}
+
+long long appendCsv(std::string& out, const UserReport& r) {
+    const ReportJob& job = *r.job;
+    if (!r.error.empty()) {
+        appendCsvField(out, job.user);
+        out += ",error,";
+        appendDate(out, job.from);
+        out += ',';
+        appendDate(out, job.to);
+        out += ",,,,,,,,,,,";
+        appendCsvField(out, r.error);
+        out += ",\n";
+        return 1;
+    }
+
+    appendCsvPeriod(out, r, "total", r.total);
+    for (const PeriodSummary& p : r.months) appendCsvPeriod(out, r, "month", p);
+    for (const PeriodSummary& p : r.weeks) appendCsvPeriod(out, r, "week", p);
+
+    for (const FoodUsage& f : r.topFoods) {
+        appendCsvField(out, job.user);
+        out += ",top_food,";
+        appendDate(out, job.from);
+        out += ',';
+        appendDate(out, job.to);
+        out += ",,,,";
+        appendInt(out, f.entries);
+        for (double v : { f.calories, f.protein, f.carbs, f.fat, r.goal }) {
+            out += ',';
+            appendNumber(out, v);
+        }
+        out += ',';
+        appendCsvField(out, f.barcode);
+        out += ',';
+        appendCsvField(out, f.name);
+        out += ',';
+        appendNumber(out, f.grams);
+        out += '\n';
+    }
+    return 1 + static_cast<long long>(r.months.size() + r.weeks.size() + r.topFoods.size());
+}
+
+void appendJsonPeriod(std::string& out, const PeriodSummary& p) {
+    out += "{\"start\":\"";
+    appendDate(out, p.start);
+    out += "\",\"end\":\"";
+    appendDate(out, p.end);
+    out += "\",\"days_logged\":";
+    appendInt(out, p.daysLogged);
+    out += ",\"days_within_goal\":";
+    appendInt(out, p.daysWithinGoal);
+    out += ",\"adherence\":";
+    appendNumber(out, adherence(p));
+    out += ",\"entries\":";
+    appendInt(out, p.entries);
+    out += ",\"calories\":";
+    appendNumber(out, p.calories);
+    out += ",\"protein\":";
+    appendNumber(out, p.protein);
+    out += ",\"carbs\":";
+    appendNumber(out, p.carbs);
+    out += ",\"fat\":";
+    appendNumber(out, p.fat);
+    out += '}';
+}
+
+void appendJsonPeriods(std::string& out, const char* key, const std::vector<PeriodSummary>& periods) {
+    out += ",\"";
+    out += key;
+    out += "\":[";
+    for (size_t i = 0; i < periods.size(); ++i) {
+        if (i) out += ',';
+        appendJsonPeriod(out, periods[i]);
+    }
+    out += ']';
+}
+
+long long appendJson(std::string& out, const UserReport& r) {
+    const ReportJob& job = *r.job;
+    out += "{\"user\":";
+    appendJsonString(out, job.user);
+    out += ",\"from\":\"";
+    appendDate(out, job.from);
+    out += "\",\"to\":\"";
+    appendDate(out, job.to);
+    out += '"';
+    if (!r.error.empty()) {
+        out += ",\"error\":";
+        appendJsonString(out, r.error);
+        out += '}';
+        return 1;
+    }
+
+    out += ",\"goal\":";
+    appendNumber(out, r.goal);
+    out += ",\"total\":";
+    appendJsonPeriod(out, r.total);
+    appendJsonPeriods(out, "months", r.months);
+    appendJsonPeriods(out, "weeks", r.weeks);
+
+    out += ",\"top_foods\":[";
+    for (size_t i = 0; i < r.topFoods.size(); ++i) {
+        const FoodUsage& f = r.topFoods[i];
+        out += i ? ",{\"barcode\":" : "{\"barcode\":";
+        appendJsonString(out, f.barcode);
+        out += ",\"name\":";
+        appendJsonString(out, f.name);
+        out += ",\"entries\":";
+        appendInt(out, f.entries);
+        out += ",\"grams\":";
+        appendNumber(out, f.grams);
+        out += ",\"calories\":";
+        appendNumber(out, f.calories);
+        out += ",\"protein\":";
+        appendNumber(out, f.protein);
+        out += ",\"carbs\":";
+        appendNumber(out, f.carbs);
+        out += ",\"fat\":";
+        appendNumber(out, f.fat);
+        out += '}';
+    }
+    out += "]}";
+    return 1 + static_cast<long long>(r.months.size() + r.weeks.size() + r.topFoods.size());
+}
+
+} // namespace
+
+UserReport buildUserReport(const ReportJob& job, size_t topFoods) {
+    UserReport report;
+    report.job = &job;
+    report.total.start = job.from;
+    report.total.end = job.to;
+
+    OpenProfile profile;
+    profile.readOnly = true;
+    profile.verbose = false;
+    profile.cacheSizeKiB = 2048;   // one connection per worker, each reading one range once
+    DatabaseManager db(job.dbPath, profile);
+    if (!db.open()) {
+        report.error = "cannot open " + job.dbPath;
+        return report;
+    }
+    // A read-only connection cannot migrate, and older layouts lack the day columns.
+    const int version = schemaVersion(db.handle());
+    if (version != latestSchemaVersion()) {
+        report.error = "schema version " + std::to_string(version) + ", expected " +
+                       std::to_string(latestSchemaVersion()) + "; open it with the tracker once to migrate";
+        return report;
+    }
+
+    // One read transaction so the totals and the top foods see the same data.
+    if (!db.beginTransaction()) {
+        report.error = "cannot start a read transaction";
+        return report;
+    }
+    const std::vector<DailyTotals> days = db.getDailyTotalsRange(job.from, job.to);
+    report.goal = db.getDailyGoal();
+    if (topFoods > 0) report.topFoods = db.getTopFoods(job.from, job.to, topFoods);
+    db.commit();
+
+    Date currentWeek, currentMonth;
+    for (const DailyTotals& d : days) {
+        const Date week = weekKey(d.day);
+        if (report.weeks.empty() || week != currentWeek) {
+            currentWeek = week;
+            report.weeks.push_back(clippedPeriod(week, week + 6, job));
+        }
+        const Date month = monthKey(d.day);
+        if (report.months.empty() || month != currentMonth) {
+            currentMonth = month;
+            report.months.push_back(clippedPeriod(month, monthEnd(month), job));
+        }
+        addDay(report.weeks.back(), d, report.goal);
+        addDay(report.months.back(), d, report.goal);
+        addDay(report.total, d, report.goal);
+    }
+    return report;
+}
+
+std::vector<ReportJob> splitByMonth(const ReportJob& job) {
+    std::vector<ReportJob> parts;
+    for (Date start = job.from; start <= job.to;) {
+        Date end = monthEnd(monthKey(start));
+        if (job.to < end) end = job.to;
+        parts.push_back(ReportJob{ job.user, job.dbPath, start, end });
+        start = end + 1;
+    }
+    return parts;
+}
+
+ReportRunStats runReports(const std::vector<ReportJob>& jobs, const ReportOptions& options, std::ostream& out) {
+    const auto started = std::chrono::steady_clock::now();
+    ReportRunStats stats;
+    stats.jobs = jobs.size();
+
+    size_t threads = options.threads;
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    threads = std::max<size_t>(1, std::min(threads, jobs.size()));
+
+    const bool json = options.format == ReportFormat::Json;
+    out << (json ? "[\n" : csvHeader);
+
+    std::mutex outMutex;
+    bool firstReport = true;
+    {
+        WorkStealingPool pool(threads);
+        for (const ReportJob& job : jobs) {
+            pool.submit([&, jobPtr = &job](size_t) {
+                const UserReport report = buildUserReport(*jobPtr, options.topFoods);
+                std::string text;
+                const long long rows = json ? appendJson(text, report) : appendCsv(text, report);
+
+                std::lock_guard<std::mutex> lock(outMutex);
+                if (json && !firstReport) out << ",\n";
+                firstReport = false;
+                out << text;
+                stats.rowsWritten += rows;
+                stats.daysLogged += report.total.daysLogged;
+                if (!report.error.empty()) ++stats.failed;
+            });
+        }
+        pool.wait();
+        stats.steals = pool.steals();
+    }
+
+    if (json) out << "\n]\n";
+    out.flush();
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    return stats;
+}
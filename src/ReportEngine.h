@@ -0,0 +1,73 @@
+#pragma once
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "DatabaseManager.h"
+#include "Date.h"
+
+enum class ReportFormat { Csv, Json };
+
+// One unit of report work: a user's database over an inclusive date range.
+struct ReportJob {
+    std::string user;     // label written with every output row
+    std::string dbPath;
+    Date from;
+    Date to;
+};
+
+struct ReportOptions {
+    ReportFormat format = ReportFormat::Csv;
+    size_t threads = 0;       // 0: one per hardware thread
+    size_t topFoods = 5;      // per job; 0 skips the top-foods query
+};
+
+// Totals for one calendar week (Monday first), calendar month, or a whole job.
+// Periods are clipped to the job's range, and only days with entries count.
+struct PeriodSummary {
+    Date start;
+    Date end;
+    int daysLogged = 0;
+    int daysWithinGoal = 0;   // calories at or under the goal (0 when no goal is set)
+    int entries = 0;
+    double calories = 0.0;
+    double protein = 0.0;
+    double carbs = 0.0;
+    double fat = 0.0;
+};
+
+struct UserReport {
+    const ReportJob* job = nullptr;
+    double goal = 0.0;
+    PeriodSummary total;
+    std::vector<PeriodSummary> weeks;
+    std::vector<PeriodSummary> months;
+    std::vector<FoodUsage> topFoods;
+    std::string error;        // non-empty when the job failed
+};
+
+struct ReportRunStats {
+    size_t jobs = 0;
+    size_t failed = 0;
+    long long daysLogged = 0;
+    long long rowsWritten = 0;   // CSV lines or JSON period/food objects
+    uint64_t steals = 0;
+    double seconds = 0.0;
+};
+
+// Builds the report for one job on its own read-only connection.
+UserReport buildUserReport(const ReportJob& job, size_t topFoods);
+
+// Splits a job into one job per calendar month, for spreading a single large
+// database across workers. Weekly rows are then clipped at month boundaries.
+std::vector<ReportJob> splitByMonth(const ReportJob& job);
+
+// Runs every job on a work-stealing pool and streams each finished report to
+// `out` straight away, so memory stays at one report per worker. Reports appear
+// in completion order; every row carries its job's user label.
+//
+// CSV columns: user,period,start,end,days_logged,days_within_goal,adherence,
+// entries,calories,protein,carbs,fat,goal,food_barcode,food_name,grams.
+// `period` is total, month, week, top_food, or error (message in food_name).
+// JSON: an array with one object per job.
+ReportRunStats runReports(const std::vector<ReportJob>& jobs, const ReportOptions& options, std::ostream& out);
@@ -0,0 +1,12 @@
+#include "SqlExec.h"
+#include <iostream>
+
+bool execSql(sqlite3* db, const char* sql) {
+    char* errMsg = nullptr;
+    if (sqlite3_exec(db, sql, nullptr, nullptr, &errMsg) != SQLITE_OK) {
+        std::cerr << "SQL error: " << (errMsg ? errMsg : "unknown") << "\n";
+        sqlite3_free(errMsg);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,23 @@
+#pragma once
+#include <string>
+#include "sqlite3.h"
+
+// Runs one or more SQL statements without results, printing SQLite's error
+// message on failure.
+bool execSql(sqlite3* db, const char* sql);
+inline bool execSql(sqlite3* db, const std::string& sql) { return execSql(db, sql.c_str()); }
+
+// Runs `body` in a savepoint named `savepoint` when the caller has a
+// transaction open, and otherwise in its own BEGIN IMMEDIATE: a deferred
+// transaction that reads first cannot upgrade to a write lock once another
+// connection has committed, and fails with SQLITE_BUSY instead of waiting.
+// Rolls back to where it started if `body` returns false.
+template <typename Body>
+bool inTransaction(sqlite3* db, const char* savepoint, Body body) {
+    const bool nested = !sqlite3_get_autocommit(db);
+    const std::string name(savepoint);
+    if (!execSql(db, nested ? "SAVEPOINT " + name + ";" : std::string("BEGIN IMMEDIATE;"))) return false;
+    if (body() && execSql(db, nested ? "RELEASE " + name + ";" : std::string("COMMIT;"))) return true;
+    execSql(db, nested ? "ROLLBACK TO " + name + "; RELEASE " + name + ";" : std::string("ROLLBACK;"));
+    return false;
+}
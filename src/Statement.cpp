@@ -0,0 +1,36 @@
+#include "Statement.h"
+#include <utility>
+
+Statement::~Statement() {
+    finalize();
+}
+
+Statement::Statement(Statement&& other) noexcept
+    : stmt(std::exchange(other.stmt, nullptr)) {}
+
+Statement& Statement::operator=(Statement&& other) noexcept {
+    if (this != &other) {
+        finalize();
+        stmt = std::exchange(other.stmt, nullptr);
+    }
+    return *this;
+}
+
+bool Statement::prepare(sqlite3* db, const char* sql) {
+    finalize();
+    return sqlite3_prepare_v3(db, sql, -1, SQLITE_PREPARE_PERSISTENT, &stmt, nullptr) == SQLITE_OK;
+}
+
+void Statement::finalize() {
+    if (stmt) {
+        sqlite3_finalize(stmt);
+        stmt = nullptr;
+    }
+}
+
+StatementReset::~StatementReset() {
+    if (stmt) {
+        sqlite3_reset(stmt);
+        sqlite3_clear_bindings(stmt);
+    }
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include "sqlite3.h"
+
+// Owns a prepared statement for the lifetime of a connection.
+class Statement {
+public:
+    Statement() = default;
+    ~Statement();
+
+    Statement(const Statement&) = delete;
+    Statement& operator=(const Statement&) = delete;
+    Statement(Statement&& other) noexcept;
+    Statement& operator=(Statement&& other) noexcept;
+
+    bool prepare(sqlite3* db, const char* sql);
+    void finalize();
+
+    sqlite3_stmt* get() const { return stmt; }
+    explicit operator bool() const { return stmt != nullptr; }
+
+private:
+    sqlite3_stmt* stmt = nullptr;
+};
+
+// Resets a cached statement and clears its bindings when the calling scope exits,
+// so the statement never holds a read transaction open between calls.
+class StatementReset {
+public:
+    explicit StatementReset(sqlite3_stmt* s) : stmt(s) {}
+    ~StatementReset();
+
+    StatementReset(const StatementReset&) = delete;
+    StatementReset& operator=(const StatementReset&) = delete;
+
+private:
+    sqlite3_stmt* stmt;
+};
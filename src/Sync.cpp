@@ -0,0 +1,357 @@
+#include "Sync.h"
+#include "Gtin.h"
+#include "LogPartitions.h"
+#include "Recipes.h"
+#include "SqlExec.h"
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+
+namespace {
+
+const int changesetFormat = 1;
+
+std::string quoted(const std::string& text) {
+    std::string out = "'";
+    for (char c : text) {
+        out += c;
+        if (c == '\'') out += '\'';
+    }
+    return out + "'";
+}
+
+long long queryInt(sqlite3* db, const std::string& sql, long long fallback = 0) {
+    Statement stmt;
+    if (!stmt.prepare(db, sql.c_str()) || sqlite3_step(stmt.get()) != SQLITE_ROW ||
+        sqlite3_column_type(stmt.get(), 0) == SQLITE_NULL) {
+        return fallback;
+    }
+    return sqlite3_column_int64(stmt.get(), 0);
+}
+
+const char* const changesetSchemaSql = R"(
+    CREATE TABLE changeset.meta (
+        key TEXT PRIMARY KEY,
+        value INTEGER NOT NULL
+        );
+    CREATE TABLE changeset.foods (
+        barcode TEXT PRIMARY KEY,
+        name TEXT NOT NULL,
+        calories_per_100g REAL NOT NULL,
+        protein REAL,
+        carbs REAL,
+        fat REAL,
+        changed_at INTEGER NOT NULL,
+        device INTEGER NOT NULL
+        );
+    CREATE TABLE changeset.log_rows (
+        device INTEGER NOT NULL,
+        origin_id INTEGER NOT NULL,
+        day INTEGER NOT NULL,
+        barcode TEXT NOT NULL,
+        grams REAL NOT NULL,
+        PRIMARY KEY (device, origin_id)
+        ) WITHOUT ROWID;
+    )";
+
+// True when `path` is a changeset file exportChanges may replace.
+bool isChangesetFile(const std::string& path) {
+    sqlite3* file = nullptr;
+    bool ok = sqlite3_open_v2(path.c_str(), &file, SQLITE_OPEN_READONLY, nullptr) == SQLITE_OK &&
+              queryInt(file, "SELECT value FROM meta WHERE key = 'format';", -1) == changesetFormat;
+    sqlite3_close(file);
+    return ok;
+}
+
+// Attaches the changeset file for the lifetime of the object. ATTACH and
+// DETACH are not allowed inside a transaction, so this wraps the transaction.
+class AttachedChangeset {
+public:
+    AttachedChangeset(sqlite3* db, const std::string& path)
+        : db(db), attached(execSql(db, "ATTACH DATABASE " + quoted(path) + " AS changeset;")) {}
+    ~AttachedChangeset() {
+        if (attached) execSql(db, "DETACH DATABASE changeset;");
+    }
+    bool ok() const { return attached; }
+
+private:
+    sqlite3* db;
+    bool attached;
+};
+
+// Adds this month's rows above the peer's cursor, except those received from
+// the peer, and moves the cursor to the partition's last id. Rows that came
+// from elsewhere keep their origin.
+bool exportMonth(sqlite3* db, const std::string& peer, long long device, long long peerDevice, int month,
+                 SyncStats& stats) {
+    const std::string table = logPartitionTable(month);
+    const long long cursor = queryInt(db, "SELECT last_id FROM sync_log_cursors WHERE peer = " + quoted(peer) +
+                                              " AND month = " + std::to_string(month) + ";");
+    const long long lastId = queryInt(db, "SELECT MAX(id) FROM " + table + ";", cursor);
+    if (lastId <= cursor) return true;
+
+    if (!execSql(db, "INSERT INTO changeset.log_rows (device, origin_id, day, barcode, grams) "
+                  "SELECT COALESCE(o.device, " + std::to_string(device) + "), COALESCE(o.origin_id, l.id), "
+                  "l.day, f.barcode, l.grams FROM " + table + " l JOIN foods f ON f.id = l.food_id "
+                  "LEFT JOIN log_origins o ON o.id = l.id WHERE l.id > " + std::to_string(cursor) +
+                  " AND (o.via IS NULL OR o.via <> " + std::to_string(peerDevice) + ");")) {
+        return false;
+    }
+    stats.logRowsSent += sqlite3_changes(db);
+    return execSql(db, "INSERT INTO sync_log_cursors (peer, month, last_id) VALUES (" + quoted(peer) + ", " +
+                        std::to_string(month) + ", " + std::to_string(lastId) + ") "
+                        "ON CONFLICT(peer, month) DO UPDATE SET last_id = excluded.last_id;");
+}
+
+bool exportAll(sqlite3* db, const std::string& peer, long long device, SyncStats& stats) {
+    if (!execSql(db, changesetSchemaSql) ||
+        !execSql(db, "INSERT INTO changeset.meta (key, value) VALUES ('format', " + std::to_string(changesetFormat) +
+                      "), ('device', " + std::to_string(device) + ");") ||
+        !execSql(db, "INSERT INTO sync_peers (peer) VALUES (" + quoted(peer) + ") ON CONFLICT(peer) DO NOTHING;")) {
+        return false;
+    }
+
+    // Unknown until a changeset from the peer has been applied.
+    const long long peerDevice =
+        queryInt(db, "SELECT device FROM sync_peers WHERE peer = " + quoted(peer) + ";", -1);
+    for (int month : listLogPartitions(db)) {
+        if (!exportMonth(db, peer, device, peerDevice, month, stats)) return false;
+    }
+
+    // Changed foods, then unchanged ones the new log rows refer to.
+    const long long foodSeq = queryInt(db, "SELECT food_seq FROM sync_peers WHERE peer = " + quoted(peer) + ";");
+    if (!execSql(db, "INSERT INTO changeset.foods SELECT f.barcode, f.name, f.calories_per_100g, f.protein, f.carbs, "
+                  "f.fat, c.changed_at, c.device FROM food_changes c JOIN foods f ON f.barcode = c.barcode "
+                  "WHERE c.seq > " + std::to_string(foodSeq) + " AND (c.via IS NULL OR c.via <> " +
+                  std::to_string(peerDevice) + ");")) {
+        return false;
+    }
+    stats.foodsSent = sqlite3_changes(db);
+    if (!execSql(db, "INSERT OR IGNORE INTO changeset.foods SELECT f.barcode, f.name, f.calories_per_100g, f.protein, "
+                  "f.carbs, f.fat, COALESCE(c.changed_at, 0), COALESCE(c.device, " + std::to_string(device) + ") "
+                  "FROM foods f LEFT JOIN food_changes c ON c.barcode = f.barcode "
+                  "WHERE f.barcode IN (SELECT DISTINCT barcode FROM changeset.log_rows);")) {
+        return false;
+    }
+    stats.foodsSent += sqlite3_changes(db);
+
+    return execSql(db, "UPDATE sync_peers SET food_seq = (SELECT COALESCE(MAX(seq), food_seq) FROM food_changes) "
+                    "WHERE peer = " + quoted(peer) + ";");
+}
+
+// The changeset's foods keyed by normalized barcode, as this database stores
+// them. A peer built before normalization may send two forms of one code; the
+// newest version stands for both.
+const char* const changesetFoodsSql = R"(
+    CREATE TEMP TABLE sync_foods AS
+    SELECT barcode, name, calories_per_100g, protein, carbs, fat, changed_at, device FROM (
+        SELECT gtin_normalize(barcode) AS barcode, name, calories_per_100g, protein, carbs, fat, changed_at, device,
+               ROW_NUMBER() OVER (PARTITION BY gtin_normalize(barcode) ORDER BY changed_at DESC, device DESC) AS rank
+        FROM changeset.foods)
+    WHERE rank = 1;
+    )";
+
+// Incoming foods that win against the local version: newer stamp, or no local
+// row. Ties (the same version coming back) and recipes stay as they are.
+const char* const incomingFoodsSql = R"(
+    CREATE TEMP TABLE sync_incoming AS
+    SELECT c.* FROM temp.sync_foods c
+    LEFT JOIN food_changes l ON l.barcode = c.barcode
+    WHERE (l.barcode IS NULL OR (c.changed_at, c.device) > (l.changed_at, l.device))
+      AND c.barcode NOT IN (SELECT f.barcode FROM recipes r JOIN foods f ON f.id = r.food_id);
+    )";
+
+const char* const keptLocalSql = R"(
+    SELECT COUNT(*) FROM temp.sync_foods c JOIN food_changes l ON l.barcode = c.barcode
+    WHERE (c.changed_at, c.device) < (l.changed_at, l.device);
+    )";
+
+// The foods upsert stamps food_changes as a local change; the incoming stamp
+// replaces it so every database agrees on which version is newest.
+const char* const applyFoodsSql = R"(
+    INSERT INTO foods (barcode, name, calories_per_100g, protein, carbs, fat)
+    SELECT barcode, name, calories_per_100g, protein, carbs, fat FROM temp.sync_incoming WHERE true
+    ON CONFLICT(barcode) DO UPDATE SET
+        name = excluded.name,
+        calories_per_100g = excluded.calories_per_100g,
+        protein = excluded.protein,
+        carbs = excluded.carbs,
+        fat = excluded.fat;
+    )";
+
+const char* const incomingLogRowsSql = R"(
+    SELECT c.device, c.origin_id, c.day, f.id, c.grams FROM changeset.log_rows c
+    LEFT JOIN foods f ON f.barcode = gtin_normalize(c.barcode)
+    WHERE c.device <> ?1
+      AND NOT EXISTS (SELECT 1 FROM log_origins o WHERE o.device = c.device AND o.origin_id = c.origin_id)
+    ORDER BY c.day;
+    )";
+
+// `source` is the device that wrote the changeset, remembered as `peer`'s.
+bool applyAll(DatabaseManager& database, long long device, long long source, const std::string& peer,
+              SyncStats& stats) {
+    sqlite3* db = database.handle();
+    if (!execSql(db, "INSERT INTO sync_peers (peer, device) VALUES (" + quoted(peer) + ", " + std::to_string(source) +
+                      ") ON CONFLICT(peer) DO UPDATE SET device = excluded.device;")) {
+        return false;
+    }
+
+    if (!registerGtinFunctions(db) || !execSql(db, changesetFoodsSql)) return false;
+    stats.foodsKeptLocal = queryInt(db, keptLocalSql);
+    if (!execSql(db, incomingFoodsSql)) return false;
+    stats.foodsApplied = queryInt(db, "SELECT COUNT(*) FROM temp.sync_incoming;");
+    const bool foodsOk =
+        execSql(db, applyFoodsSql) &&
+        execSql(db, "UPDATE food_changes SET changed_at = i.changed_at, device = i.device, via = " +
+                     std::to_string(source) + " FROM temp.sync_incoming i WHERE food_changes.barcode = i.barcode;");
+    execSql(db, "DROP TABLE temp.sync_incoming; DROP TABLE temp.sync_foods;");
+    if (!foodsOk) return false;
+
+    Statement incoming, origin;
+    if (!incoming.prepare(db, incomingLogRowsSql) ||
+        !origin.prepare(db, "INSERT INTO log_origins (id, device, origin_id, via) VALUES (?, ?, ?, ?);")) {
+        return false;
+    }
+    sqlite3_bind_int64(incoming.get(), 1, device);
+    const long long rowsInChangeset = queryInt(db, "SELECT COUNT(*) FROM changeset.log_rows;");
+    int rc;
+    while ((rc = sqlite3_step(incoming.get())) == SQLITE_ROW) {
+        sqlite3_stmt* row = incoming.get();
+        if (sqlite3_column_type(row, 3) == SQLITE_NULL) {
+            std::cerr << "Changeset log row refers to a food it does not contain.\n";
+            return false;
+        }
+        const Date day = Date::fromDays(sqlite3_column_int(row, 2));
+        if (!DatabaseManager::isLoggableDay(day)) {
+            // A peer with a wrong clock must not stop every later apply.
+            ++stats.logRowsSkipped;
+            continue;
+        }
+        if (!database.insertLogRow(day, sqlite3_column_int64(row, 3), sqlite3_column_double(row, 4))) {
+            return false;
+        }
+        StatementReset reset(origin.get());
+        sqlite3_bind_int64(origin.get(), 1, sqlite3_last_insert_rowid(db));
+        sqlite3_bind_int64(origin.get(), 2, sqlite3_column_int64(row, 0));
+        sqlite3_bind_int64(origin.get(), 3, sqlite3_column_int64(row, 1));
+        sqlite3_bind_int64(origin.get(), 4, source);
+        if (sqlite3_step(origin.get()) != SQLITE_DONE) return false;
+        ++stats.logRowsApplied;
+    }
+    if (rc != SQLITE_DONE) return false;
+    stats.logRowsSkipped = rowsInChangeset - stats.logRowsApplied;
+
+    return refreshRecipes(database) >= 0;
+}
+
+} // namespace
+
+long long syncDeviceId(DatabaseManager& db) {
+    return queryInt(db.handle(), "SELECT CAST(value AS INTEGER) FROM settings WHERE key = 'device_id';");
+}
+
+SyncStats exportChanges(DatabaseManager& database, const std::string& path, const std::string& peer) {
+    SyncStats stats;
+    auto started = std::chrono::steady_clock::now();
+    auto finish = [&]() -> SyncStats& {
+        stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+        return stats;
+    };
+
+    sqlite3* db = database.handle();
+    // Only an earlier changeset may be replaced: a mistyped path must not
+    // unlink a database, least of all this one.
+    std::error_code ec;
+    const char* mainFile = sqlite3_db_filename(db, "main");
+    if (mainFile && *mainFile && std::filesystem::equivalent(path, mainFile, ec)) {
+        stats.error = path + " is this database";
+        return finish();
+    }
+    if (std::filesystem::exists(path, ec) && !isChangesetFile(path)) {
+        stats.error = path + " exists and is not a changeset; not overwriting it";
+        return finish();
+    }
+
+    // Written next to the target and renamed over it once complete.
+    const std::string tmpPath = path + ".tmp";
+    std::remove(tmpPath.c_str());
+    std::remove((tmpPath + "-journal").c_str());
+    {
+        AttachedChangeset changeset(db, tmpPath);
+        if (!changeset.ok()) {
+            stats.error = "cannot create " + tmpPath;
+            return finish();
+        }
+        // The cursors only move if the changeset is written completely.
+        if (!execSql(db, "BEGIN IMMEDIATE;")) {
+            stats.error = "could not begin transaction";
+            return finish();
+        }
+        if (!exportAll(db, peer, syncDeviceId(database), stats) || !execSql(db, "COMMIT;")) {
+            stats.error = std::string("export failed: ") + sqlite3_errmsg(db);
+            execSql(db, "ROLLBACK;");
+        }
+    }
+    if (!stats.error.empty()) {
+        std::remove(tmpPath.c_str());
+        return finish();
+    }
+    std::filesystem::rename(tmpPath, path, ec);
+    if (ec) {
+        // The cursors already moved, so the changes are in tmpPath only.
+        stats.error = "exported to " + tmpPath + " but could not rename it to " + path + ": " + ec.message();
+        return finish();
+    }
+
+    stats.completed = true;
+    return finish();
+}
+
+SyncStats applyChanges(DatabaseManager& database, const std::string& path, const std::string& peer) {
+    SyncStats stats;
+    auto started = std::chrono::steady_clock::now();
+    auto finish = [&]() -> SyncStats& {
+        stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+        return stats;
+    };
+
+    // ATTACH would create a missing file.
+    std::error_code ec;
+    if (!std::filesystem::is_regular_file(path, ec)) {
+        stats.error = "cannot open " + path;
+        return finish();
+    }
+
+    sqlite3* db = database.handle();
+    AttachedChangeset changeset(db, path);
+    if (!changeset.ok() ||
+        queryInt(db, "SELECT value FROM changeset.meta WHERE key = 'format';", -1) != changesetFormat) {
+        stats.error = path + " is not a changeset";
+        return finish();
+    }
+    const long long device = syncDeviceId(database);
+    const long long source = queryInt(db, "SELECT value FROM changeset.meta WHERE key = 'device';");
+    if (source == device) {
+        // Our own export: everything in it is already here.
+        stats.logRowsSkipped = queryInt(db, "SELECT COUNT(*) FROM changeset.log_rows;");
+        stats.completed = true;
+        return finish();
+    }
+
+    if (!execSql(db, "BEGIN IMMEDIATE;")) {
+        stats.error = "could not begin transaction";
+        return finish();
+    }
+    if (!applyAll(database, device, source, peer, stats) || !execSql(db, "COMMIT;")) {
+        stats.error = std::string("apply failed: ") + sqlite3_errmsg(db) + "; nothing was applied";
+        execSql(db, "ROLLBACK;");
+        stats.foodsApplied = stats.logRowsApplied = 0;
+        database.invalidateBarcodeCache();
+        return finish();
+    }
+    database.invalidateBarcodeCache();
+
+    stats.completed = true;
+    return finish();
+}
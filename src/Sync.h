@@ -0,0 +1,41 @@
+#pragma once
+#include <string>
+#include "DatabaseManager.h"
+
+// Delta sync between tracker databases through changeset files. A changeset is
+// a small SQLite file holding the foods changed and the log rows added since
+// the previous export to the same peer, found through the change tracking of
+// schema migration 9, so its cost follows the number of changes rather than
+// the size of the database.
+//
+// Foods are matched by barcode. When both sides changed one, the version
+// written last wins, with the device id breaking ties, so every database ends
+// up with the same values whatever order changesets are applied in. Recipes
+// keep their own computed values. Log rows carry their origin device and id
+// and are added once; rows that came from the applying device are skipped.
+// Nothing received from a peer is exported back to it. Deletions (clears,
+// retention, food deletes) and recipe definitions are not synced.
+
+struct SyncStats {
+    long long foodsSent = 0;
+    long long logRowsSent = 0;
+    long long foodsApplied = 0;
+    long long foodsKeptLocal = 0;   // barcode conflicts the local version won
+    long long logRowsApplied = 0;
+    long long logRowsSkipped = 0;   // already present, from this device, or dated out of range
+    double seconds = 0.0;
+    bool completed = false;
+    std::string error;
+};
+
+// Writes the changes not yet exported to `peer` into a new changeset file at
+// `path` and advances the peer's cursors. An existing file at `path` is only
+// replaced if it is a changeset; this database's own file is refused.
+SyncStats exportChanges(DatabaseManager& db, const std::string& path, const std::string& peer = "default");
+
+// Applies a changeset file from `peer` in one transaction. The peer's device
+// is remembered so that exports to it leave out what it sent.
+SyncStats applyChanges(DatabaseManager& db, const std::string& path, const std::string& peer = "default");
+
+// This database's device id, as stamped on its changes.
+long long syncDeviceId(DatabaseManager& db);
@@ -0,0 +1,171 @@
+#include "TrigramIndex.h"
+#include <algorithm>
+#include <iostream>
+
+namespace {
+
+// 0 pads word boundaries; 1-26 letters, 27-36 digits, 37 any non-ASCII byte.
+constexpr int kAlphabet = 38;
+constexpr uint32_t kTrigramCount = kAlphabet * kAlphabet * kAlphabet;
+
+int charCode(unsigned char c) {
+    if (c >= 'a' && c <= 'z') return c - 'a' + 1;
+    if (c >= 'A' && c <= 'Z') return c - 'A' + 1;
+    if (c >= '0' && c <= '9') return c - '0' + 27;
+    if (c >= 0x80) return 37;
+    return 0;
+}
+
+// Appends the distinct trigram keys of `text`. With `typing`, the last word is
+// treated as a prefix and gets no trailing pad.
+void collectTrigrams(std::string_view text, bool typing, std::vector<uint16_t>& out) {
+    const size_t first = out.size();
+    int a = 0, b = 0;      // the two previous codes of the current word
+    bool inWord = false;
+
+    for (size_t i = 0; i <= text.size(); ++i) {
+        int code = i < text.size() ? charCode(static_cast<unsigned char>(text[i])) : 0;
+        if (code == 0) {
+            if (inWord && !(typing && i == text.size())) {
+                out.push_back(static_cast<uint16_t>((a * kAlphabet + b) * kAlphabet));
+            }
+            inWord = false;
+            a = b = 0;
+            continue;
+        }
+        out.push_back(static_cast<uint16_t>((a * kAlphabet + b) * kAlphabet + code));
+        a = b;
+        b = code;
+        inWord = true;
+    }
+
+    std::sort(out.begin() + first, out.end());
+    out.erase(std::unique(out.begin() + first, out.end()), out.end());
+}
+
+} // namespace
+
+static_assert(kTrigramCount <= 65536, "trigram keys must fit in uint16_t");
+
+void TrigramIndex::clear() {
+    offsets.clear();
+    postings.clear();
+    foodIds.clear();
+    nameLengths.clear();
+}
+
+bool TrigramIndex::build(sqlite3* db) {
+    clear();
+
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db, "SELECT id, name FROM foods ORDER BY id;", -1, &stmt, nullptr) != SQLITE_OK) {
+        std::cerr << "Trigram index build failed: " << sqlite3_errmsg(db) << "\n";
+        return false;
+    }
+
+    // Pass 1: per-document trigram lists, flattened.
+    std::vector<uint16_t> grams;
+    std::vector<uint32_t> docEnd;
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        const char* name = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
+        std::string_view view(name ? name : "", static_cast<size_t>(sqlite3_column_bytes(stmt, 1)));
+
+        collectTrigrams(view, false, grams);
+        docEnd.push_back(static_cast<uint32_t>(grams.size()));
+        foodIds.push_back(sqlite3_column_int64(stmt, 0));
+        nameLengths.push_back(static_cast<uint16_t>(std::min<size_t>(view.size(), 65535)));
+    }
+    sqlite3_finalize(stmt);
+
+    if (rc != SQLITE_DONE) {
+        std::cerr << "Trigram index build failed: " << sqlite3_errmsg(db) << "\n";
+        clear();
+        return false;
+    }
+
+    // Pass 2: counting sort into postings; documents stay in id order per list.
+    offsets.assign(kTrigramCount + 1, 0);
+    for (uint16_t g : grams) ++offsets[g + 1];
+    for (uint32_t t = 0; t < kTrigramCount; ++t) offsets[t + 1] += offsets[t];
+
+    postings.resize(grams.size());
+    std::vector<uint32_t> cursor(offsets.begin(), offsets.end() - 1);
+    uint32_t begin = 0;
+    for (uint32_t doc = 0; doc < docEnd.size(); ++doc) {
+        for (uint32_t i = begin; i < docEnd[doc]; ++i) {
+            postings[cursor[grams[i]]++] = doc;
+        }
+        begin = docEnd[doc];
+    }
+    return true;
+}
+
+TrigramIndex::Result TrigramIndex::search(std::string_view query, size_t limit,
+                                          std::chrono::steady_clock::time_point deadline) const {
+    Result result;
+    if (foodIds.empty() || limit == 0) return result;
+
+    std::vector<uint16_t> grams;
+    collectTrigrams(query, true, grams);
+    if (grams.empty()) return result;
+    if (grams.size() > 255) grams.resize(255);   // counts are 8-bit
+
+    const int total = static_cast<int>(grams.size());
+    // A typo costs up to three trigrams, so beyond two trigrams only a third
+    // of them must match; ranking puts the closest names first anyway.
+    const int required = total <= 2 ? total : std::max(2, (total + 2) / 3);
+
+    // Rarest trigrams first: they admit few candidates, and once fewer lists
+    // remain than a new document could still need, common lists only add
+    // counts to documents already seen.
+    std::sort(grams.begin(), grams.end(), [&](uint16_t x, uint16_t y) {
+        return offsets[x + 1] - offsets[x] < offsets[y + 1] - offsets[y];
+    });
+
+    std::vector<uint8_t> counts(foodIds.size(), 0);
+    std::vector<uint32_t> candidates;
+    const int admitUntil = total - required;
+
+    for (int i = 0; i < total && !result.truncated; ++i) {
+        const uint32_t* it = postings.data() + offsets[grams[i]];
+        const uint32_t* end = postings.data() + offsets[grams[i] + 1];
+        const bool admit = i <= admitUntil;
+
+        while (it != end) {
+            const uint32_t* chunkEnd = end - it > 65536 ? it + 65536 : end;
+            for (; it != chunkEnd; ++it) {
+                uint8_t& c = counts[*it];
+                if (c == 0) {
+                    if (!admit) continue;
+                    candidates.push_back(*it);
+                }
+                ++c;
+            }
+            if (std::chrono::steady_clock::now() >= deadline) {
+                result.truncated = true;
+                break;
+            }
+        }
+    }
+
+    std::vector<uint32_t> ranked;
+    for (uint32_t doc : candidates) {
+        if (counts[doc] >= required) ranked.push_back(doc);
+    }
+
+    // More shared trigrams first, then shorter names (closer to the query), then id.
+    auto better = [&](uint32_t x, uint32_t y) {
+        if (counts[x] != counts[y]) return counts[x] > counts[y];
+        if (nameLengths[x] != nameLengths[y]) return nameLengths[x] < nameLengths[y];
+        return x < y;
+    };
+    const size_t keep = std::min(limit, ranked.size());
+    std::partial_sort(ranked.begin(), ranked.begin() + keep, ranked.end(), better);
+
+    result.matches.reserve(keep);
+    for (size_t i = 0; i < keep; ++i) {
+        result.matches.push_back({ foodIds[ranked[i]], counts[ranked[i]], total });
+    }
+    return result;
+}
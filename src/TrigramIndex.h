@@ -0,0 +1,46 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+#include "sqlite3.h"
+
+// In-memory trigram index over food names for typo-tolerant prefix search.
+// Names are folded to lowercase ASCII letters and digits (other bytes >= 0x80
+// share one code) and split into words; each word contributes its trigrams,
+// padded at both ends. Query words are padded only at the front while typing,
+// so "chick" matches "chicken" and "chikcen" still shares most trigrams.
+//
+// The index is a snapshot: build() again after the catalog changes. search()
+// is const and safe to call from several threads.
+class TrigramIndex {
+public:
+    struct Match {
+        long long foodId;
+        int shared;          // query trigrams found in the name
+        int queryTrigrams;
+    };
+
+    struct Result {
+        std::vector<Match> matches;   // best first
+        bool truncated = false;       // budget ran out before all postings were read
+    };
+
+    // Indexes every row of foods (id, name).
+    bool build(sqlite3* db);
+    void clear();
+
+    Result search(std::string_view query, size_t limit,
+                  std::chrono::steady_clock::time_point deadline) const;
+
+    size_t size() const { return foodIds.size(); }
+    size_t postingCount() const { return postings.size(); }
+
+private:
+    // Postings are stored CSR-style: documents containing trigram t are
+    // postings[offsets[t] .. offsets[t + 1]).
+    std::vector<uint32_t> offsets;
+    std::vector<uint32_t> postings;
+    std::vector<long long> foodIds;
+    std::vector<uint16_t> nameLengths;
+};
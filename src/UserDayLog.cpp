@@ -0,0 +1,132 @@
+#include "UserDayLog.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include "DatabaseManager.h"
+#include "FoodDatabase.h"
+
+static_assert(std::is_trivially_copyable<UserDayLog::Entry>::value, "entries are moved with memcpy");
+
+MonotonicArena::MonotonicArena(size_t firstBlockBytes) {
+    addBlock(firstBlockBytes);
+}
+
+void MonotonicArena::addBlock(size_t bytes) {
+    blocks.push_back(Block{ std::unique_ptr<unsigned char[]>(new unsigned char[bytes]), bytes });
+    offset = 0;
+}
+
+void* MonotonicArena::allocate(size_t bytes, size_t align) {
+    for (;;) {
+        Block& block = blocks.back();
+        const uintptr_t base = reinterpret_cast<uintptr_t>(block.data.get());
+        const uintptr_t start = (base + offset + align - 1) & ~static_cast<uintptr_t>(align - 1);
+        if (start + bytes <= base + block.size) {
+            offset = start + bytes - base;
+            return reinterpret_cast<void*>(start);
+        }
+        // Blocks double so a growing day needs only a few of them.
+        addBlock(std::max(block.size * 2, bytes + align));
+    }
+}
+
+void MonotonicArena::reset() {
+    if (blocks.size() > 1) {
+        const size_t total = capacity();
+        blocks.clear();
+        addBlock(total);
+    }
+    offset = 0;
+}
+
+size_t MonotonicArena::capacity() const {
+    size_t total = 0;
+    for (const Block& block : blocks) total += block.size;
+    return total;
+}
+
+bool UserDayLog::load(DatabaseManager& db, Date day) {
+    reset(day);
+    const bool ok = db.visitEntriesForDate(day, [this](std::string_view name, std::string_view barcode,
+                                                       double grams, const Nutrients& per100g) {
+        append(name, barcode, grams, per100g.scaledTo(grams));
+    });
+    if (!ok) reset(day);
+    return ok;
+}
+
+void UserDayLog::reset(Date day) {
+    storage.reset();
+    date = day;
+    entries = nullptr;
+    count = 0;
+    entryCapacity = 0;
+    interned = nullptr;
+    internedCount = 0;
+    internedSlots = 0;
+}
+
+void UserDayLog::add(const FoodItem& food, double grams) {
+    append(food.name, food.barcode, grams, food.nutrientsFor(grams));
+}
+
+bool UserDayLog::add(FoodDatabase& foods, std::string_view barcode, double grams) {
+    auto food = foods.find(barcode);
+    if (!food) return false;
+    add(*food, grams);
+    return true;
+}
+
+Nutrients UserDayLog::totals() const {
+    Nutrients sum;
+    for (const Entry& e : *this) sum += e.nutrients;
+    return sum;
+}
+
+void UserDayLog::append(std::string_view name, std::string_view barcode, double grams, const Nutrients& nutrients) {
+    if (count == entryCapacity) {
+        // The old array stays in the arena until the next reset; at most half
+        // of what the entries use is wasted that way.
+        const size_t capacity = entryCapacity ? entryCapacity * 2 : 64;
+        auto* grown = static_cast<Entry*>(storage.allocate(capacity * sizeof(Entry), alignof(Entry)));
+        if (count) std::memcpy(static_cast<void*>(grown), entries, count * sizeof(Entry));
+        entries = grown;
+        entryCapacity = capacity;
+    }
+    new (&entries[count++]) Entry{ intern(name), intern(barcode), grams, nutrients };
+}
+
+std::string_view UserDayLog::intern(std::string_view text) {
+    if (text.empty()) return {};
+
+    // Keep the load factor at or below one half.
+    if ((internedCount + 1) * 2 > internedSlots) {
+        const size_t slots = internedSlots ? internedSlots * 2 : 256;
+        auto* table = static_cast<std::string_view*>(storage.allocate(slots * sizeof(std::string_view),
+                                                                      alignof(std::string_view)));
+        for (size_t i = 0; i < slots; ++i) new (&table[i]) std::string_view();
+        for (size_t i = 0; i < internedSlots; ++i) {
+            if (interned[i].empty()) continue;
+            size_t j = std::hash<std::string_view>()(interned[i]) & (slots - 1);
+            while (!table[j].empty()) j = (j + 1) & (slots - 1);
+            table[j] = interned[i];
+        }
+        interned = table;
+        internedSlots = slots;
+    }
+
+    size_t i = std::hash<std::string_view>()(text) & (internedSlots - 1);
+    while (!interned[i].empty()) {
+        if (interned[i] == text) return interned[i];
+        i = (i + 1) & (internedSlots - 1);
+    }
+
+    auto* copy = static_cast<char*>(storage.allocate(text.size(), 1));
+    std::memcpy(copy, text.data(), text.size());
+    interned[i] = std::string_view(copy, text.size());
+    ++internedCount;
+    return interned[i];
+}
@@ -0,0 +1,94 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <string_view>
+#include <vector>
+#include "Date.h"
+#include "FoodItem.h"
+#include "Nutrients.h"
+
+class DatabaseManager;
+class FoodDatabase;
+
+// Bump allocator for one day's data. Nothing is freed individually; reset()
+// rewinds to the start. When the previous fill spilled into several blocks
+// they are merged into one on reset, so filling it the same way again does
+// not allocate.
+class MonotonicArena {
+public:
+    explicit MonotonicArena(size_t firstBlockBytes = 16 * 1024);
+
+    MonotonicArena(const MonotonicArena&) = delete;
+    MonotonicArena& operator=(const MonotonicArena&) = delete;
+
+    // `align` must be a power of two.
+    void* allocate(size_t bytes, size_t align);
+    void reset();
+
+    size_t capacity() const;
+    size_t blockCount() const { return blocks.size(); }
+
+private:
+    struct Block {
+        std::unique_ptr<unsigned char[]> data;
+        size_t size;
+    };
+
+    void addBlock(size_t bytes);
+
+    std::vector<Block> blocks;
+    size_t offset = 0;   // into blocks.back()
+};
+
+// One day's log entries held in a MonotonicArena: the entry array and every
+// name and barcode live in it, and each distinct string is stored once, so
+// entries are plain views. Reloading a day reuses the arena instead of
+// allocating per entry. The views stay valid until the next load() or reset().
+class UserDayLog {
+public:
+    struct Entry {
+        std::string_view name;
+        std::string_view barcode;
+        double grams;
+        Nutrients nutrients;   // for `grams` of the food
+    };
+
+    UserDayLog() = default;
+    UserDayLog(const UserDayLog&) = delete;
+    UserDayLog& operator=(const UserDayLog&) = delete;
+
+    // Replaces the contents with `day`'s entries from `db`, in logged order.
+    bool load(DatabaseManager& db, Date day);
+    // Empties the log and starts `day`.
+    void reset(Date day);
+
+    void add(const FoodItem& food, double grams);
+    // Looks `barcode` up in `foods`; false when it is unknown.
+    bool add(FoodDatabase& foods, std::string_view barcode, double grams);
+
+    Date day() const { return date; }
+    const Entry* begin() const { return entries; }
+    const Entry* end() const { return entries + count; }
+    const Entry& operator[](size_t i) const { return entries[i]; }
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    Nutrients totals() const;
+    // Distinct names and barcodes stored.
+    size_t internedStrings() const { return internedCount; }
+    const MonotonicArena& arena() const { return storage; }
+
+private:
+    void append(std::string_view name, std::string_view barcode, double grams, const Nutrients& nutrients);
+    std::string_view intern(std::string_view text);
+
+    MonotonicArena storage;
+    Date date;
+    Entry* entries = nullptr;
+    size_t count = 0;
+    size_t entryCapacity = 0;
+    // Open-addressing set of the interned strings; an empty view marks a free slot.
+    std::string_view* interned = nullptr;
+    size_t internedCount = 0;
+    size_t internedSlots = 0;
+};
@@ -0,0 +1,101 @@
+#include "WorkStealingPool.h"
+
+namespace {
+
+// Lets submit() recognise calls made from inside a running task.
+thread_local const WorkStealingPool* currentPool = nullptr;
+thread_local size_t currentWorker = 0;
+
+} // namespace
+
+WorkStealingPool::WorkStealingPool(size_t threadCount) {
+    if (threadCount == 0) threadCount = 1;
+    for (size_t i = 0; i < threadCount; ++i) {
+        queues.push_back(std::make_unique<Queue>());
+    }
+    for (size_t i = 0; i < threadCount; ++i) {
+        threads.emplace_back(&WorkStealingPool::workerLoop, this, i);
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    wait();
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        stopping = true;
+    }
+    workAvailable.notify_all();
+    for (auto& t : threads) t.join();
+}
+
+void WorkStealingPool::submit(Task task) {
+    const size_t target = currentPool == this
+        ? currentWorker
+        : nextQueue.fetch_add(1, std::memory_order_relaxed) % queues.size();
+
+    // Counted before the push so a worker can never see a task it has not been
+    // told about; at worst an awake worker retries take() once.
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        ++queued;
+        ++pending;
+    }
+    {
+        std::lock_guard<std::mutex> lock(queues[target]->mutex);
+        queues[target]->tasks.push_back(std::move(task));
+    }
+    workAvailable.notify_one();
+}
+
+void WorkStealingPool::wait() {
+    std::unique_lock<std::mutex> lock(stateMutex);
+    allDone.wait(lock, [&] { return pending == 0; });
+}
+
+bool WorkStealingPool::take(size_t index, Task& out) {
+    {
+        Queue& own = *queues[index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            out = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+
+    for (size_t step = 1; step < queues.size(); ++step) {
+        Queue& victim = *queues[(index + step) % queues.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            out = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            stealCount.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkStealingPool::workerLoop(size_t index) {
+    currentPool = this;
+    currentWorker = index;
+
+    for (;;) {
+        Task task;
+        if (take(index, task)) {
+            {
+                std::lock_guard<std::mutex> lock(stateMutex);
+                --queued;
+            }
+            task(index);
+
+            std::lock_guard<std::mutex> lock(stateMutex);
+            if (--pending == 0) allDone.notify_all();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(stateMutex);
+        workAvailable.wait(lock, [&] { return stopping || queued > 0; });
+        if (stopping && queued == 0) return;
+    }
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads, each with its own task deque. A worker runs its
+// newest task first and, when its deque is empty, steals the oldest task from
+// another worker, so a few large tasks do not leave the other threads idle.
+// Tasks receive the index of the worker running them (0..threadCount()-1).
+class WorkStealingPool {
+public:
+    using Task = std::function<void(size_t worker)>;
+
+    explicit WorkStealingPool(size_t threads);
+    ~WorkStealingPool();   // waits for queued tasks, then joins
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    // From a worker thread the task goes on that worker's deque; otherwise the
+    // deques are filled round-robin.
+    void submit(Task task);
+    // Blocks until every submitted task has finished.
+    void wait();
+
+    size_t threadCount() const { return threads.size(); }
+    uint64_t steals() const { return stealCount.load(std::memory_order_relaxed); }
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    void workerLoop(size_t index);
+    bool take(size_t index, Task& out);
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> threads;
+
+    std::mutex stateMutex;
+    std::condition_variable workAvailable;
+    std::condition_variable allDone;
+    size_t queued = 0;    // tasks sitting in a deque
+    size_t pending = 0;   // tasks submitted and not yet finished
+    bool stopping = false;
+
+    std::atomic<size_t> nextQueue{ 0 };
+    std::atomic<uint64_t> stealCount{ 0 };
+};
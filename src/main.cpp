@@ -2,11 +2,25 @@
 #include <string>
 #include <limits>
 #include "DatabaseManager.h"
+#include "Date.h"
+#include "FoodImporter.h"
+#include "BatchRunner.h"
+#include "CatalogSnapshot.h"
+#include "FoodSearch.h"
+#include "LogJournal.h"
+#include "Metrics.h"
+#include "Recipes.h"
+#include "ReportEngine.h"
+#include "Sync.h"
+#include "UserDayLog.h"
+#include <fstream>
 #include <chrono>
 #include <ctime>
 #include <iomanip>
 #include <sstream>
 #include <cctype>
+#include <cstdlib>
+#include <filesystem>
 
 static void clearInput() {
     std::cin.clear();
@@ -27,38 +41,13 @@ static std::string todayDateISO() {
     return oss.str();
 }
 
-static bool isLeapYear(int y) {
-    return (y % 4 == 0 && y % 100 != 0) || (y % 400 == 0);
-}
-
-static int daysInMonth(int y, int m) {
-    static const int days[] = { 31,28,31,30,31,30,31,31,30,31,30,31 };
-    if (m == 2) return isLeapYear(y) ? 29 : 28;
-    return days[m - 1];
-}
-
 static bool isValidISODate(const std::string& s) {
-    // Format: YYYY-MM-DD (length 10, digits and dashes in right spots)
-    if (s.size() != 10) return false;
-    for (int i = 0; i < 10; ++i) {
-        if (i == 4 || i == 7) {
-            if (s[i] != '-') return false;
-        } else {
-            if (!std::isdigit(static_cast<unsigned char>(s[i]))) return false;
-        }
-    }
-
-    int y = std::stoi(s.substr(0, 4));
-    int m = std::stoi(s.substr(5, 2));
-    int d = std::stoi(s.substr(8, 2));
-
-    if (y < 1900 || y > 2100) return false;   // reasonable bounds
-    if (m < 1 || m > 12) return false;
+    // Format: YYYY-MM-DD with a real calendar day
+    auto date = Date::parse(s);
+    if (!date) return false;
 
-    int dim = daysInMonth(y, m);
-    if (d < 1 || d > dim) return false;
-
-    return true;
+    int y = date->year();
+    return y >= 1900 && y <= 2100;   // reasonable bounds
 }
 
 static std::string chooseDateOrToday() {
@@ -77,13 +66,415 @@ static std::string chooseDateOrToday() {
     }
 }
 
-int main() {
-    DatabaseManager db("../data/calories.db");
+// Dumps collected metrics when main returns, whichever mode ran.
+struct MetricsOnExit {
+    std::string prometheusPath;
+    bool printStats = false;
+
+    ~MetricsOnExit() {
+        if (prometheusPath.empty() && !printStats) return;
+        MetricsSnapshot snapshot = collectMetrics();
+        if (printStats) writeMetricsText(std::cerr, snapshot);
+        if (!prometheusPath.empty() && !writePrometheusFile(prometheusPath, snapshot)) {
+            std::cerr << "Cannot write " << prometheusPath << "\n";
+        }
+    }
+};
+
+static void printUsage() {
+    std::cout << "Usage:\n"
+              << "  CPPCalorieTracker [--db <path>]\n"
+              << "  CPPCalorieTracker [--db <path>] --import <file> [--format csv|jsonl]\n"
+              << "                    [--batch <rows>] [--on-conflict skip|replace|fail]\n"
+              << "  CPPCalorieTracker [--db <path>] --rebuild-totals\n"
+              << "  CPPCalorieTracker [--db <path>] --script [file|-] [--commit-every <writes>]\n"
+              << "  CPPCalorieTracker [--db <path>] --export-snapshot <file>\n"
+              << "  CPPCalorieTracker --journal <journal> [file|-]   (lines: <YYYY-MM-DD> <barcode> <grams>)\n"
+              << "  CPPCalorieTracker [--db <path>] --replay-journal <journal> [--batch <rows>] [--compact]\n"
+              << "  CPPCalorieTracker [--db <path>] --retention <months|off>   (keep whole months of log history)\n"
+              << "  CPPCalorieTracker [--db <path>] --sync-export <changeset> [--peer <name>]\n"
+              << "  CPPCalorieTracker [--db <path>] --sync-apply <changeset> [--peer <name>]\n"
+              << "  CPPCalorieTracker --report <from> <to> [--format csv|json] [--threads <n>] [--top <n>]\n"
+              << "                    [--split-months] [--output <file>] <db>...\n"
+              << "Any mode also accepts, after --db:\n"
+              << "  --snapshot <file>       fall back to a catalog snapshot\n"
+              << "  --metrics-file <file>   write Prometheus metrics on exit (CALORIE_ENABLE_METRICS builds)\n"
+              << "  --stats                 print operation statistics to stderr on exit\n"
+              << "  --warm                  load the food catalog into memory in the background\n";
+}
+
+static int runScript(DatabaseManager& db, int argc, char** argv, int i) {
+    std::string path = "-";
+    BatchOptions options;
+
+    if (i < argc && std::string(argv[i]) != "--commit-every") {
+        path = argv[i++];
+    }
+    if (i + 1 < argc && std::string(argv[i]) == "--commit-every") {
+        options.writesPerTransaction = std::atoll(argv[i + 1]);
+        i += 2;
+    }
+    if (i < argc || options.writesPerTransaction <= 0) {
+        printUsage();
+        return 1;
+    }
+
+    std::ifstream file;
+    if (path != "-") {
+        file.open(path);
+        if (!file) {
+            std::cerr << "Cannot open " << path << "\n";
+            return 1;
+        }
+    }
+
+    BatchRunner runner(db, std::cout, options);
+    BatchStats stats = runner.run(path == "-" ? std::cin : file);
+
+    std::cerr << stats.commands << " commands, " << stats.failed << " failed, "
+              << stats.transactions << " transactions in " << stats.seconds << " s\n";
+    return stats.failed == 0 ? 0 : 2;
+}
+
+static int runImport(DatabaseManager& db, const std::string& path, int argc, char** argv, int i) {
+    ImportOptions options;
+
+    for (; i + 1 < argc; i += 2) {
+        std::string arg = argv[i];
+        std::string value = argv[i + 1];
+
+        bool ok = true;
+        if (arg == "--format") {
+            ok = value == "csv" || value == "jsonl";
+            options.format = value == "csv" ? ImportFormat::Csv : ImportFormat::Jsonl;
+        } else if (arg == "--batch") {
+            options.batchSize = std::atoll(value.c_str());
+            ok = options.batchSize > 0;
+        } else if (arg == "--on-conflict") {
+            ok = parseConflictPolicy(value, options.onConflict);
+        } else {
+            ok = false;
+        }
+
+        if (!ok) {
+            printUsage();
+            return 1;
+        }
+    }
+
+    if (i < argc) {
+        printUsage();
+        return 1;
+    }
+
+    FoodImporter importer(db);
+    ImportStats stats = importer.importFile(path, options);
+
+    std::cout << "Rows read: " << stats.rowsRead << "\n"
+              << "Written: " << stats.rowsWritten << "\n"
+              << "Skipped (existing barcode): " << stats.rowsSkipped << "\n"
+              << "Rejected: " << stats.rowsRejected << "\n"
+              << "Batches: " << stats.batches << "\n"
+              << "Time: " << stats.seconds << " s (" << static_cast<long long>(stats.rowsPerSecond()) << " rows/sec)\n";
+
+    if (!stats.completed) {
+        std::cerr << "Import stopped: " << stats.error << "\n";
+        return 1;
+    }
+    return 0;
+}
+
+// Offline logging: appends events to a journal without touching the database.
+static int runJournalAppend(int argc, char** argv, int i) {
+    if (i >= argc || i + 2 < argc) {
+        printUsage();
+        return 1;
+    }
+    const std::string journalPath = argv[i];
+    const std::string inputPath = i + 1 < argc ? argv[i + 1] : "-";
+
+    std::ifstream file;
+    if (inputPath != "-") {
+        file.open(inputPath);
+        if (!file) {
+            std::cerr << "Cannot open " << inputPath << "\n";
+            return 1;
+        }
+    }
+    std::istream& in = inputPath == "-" ? std::cin : file;
+
+    LogJournalWriter journal;
+    if (!journal.open(journalPath)) return 1;
+    if (journal.tornBytesDropped() > 0) {
+        std::cerr << "Dropped a torn record (" << journal.tornBytesDropped() << " bytes) at the end of the journal.\n";
+    }
+
+    std::string line;
+    long long lineNumber = 0, appended = 0, rejected = 0;
+    while (std::getline(in, line)) {
+        ++lineNumber;
+        std::istringstream fields(line);
+        std::string dateText, barcode;
+        double grams = 0.0;
+        if (!(fields >> dateText)) continue;   // blank line
+        auto day = Date::parse(dateText);
+        if (!day || !(fields >> barcode >> grams) || grams <= 0 || !journal.append(*day, barcode, grams)) {
+            std::cerr << "line " << lineNumber << ": expected <YYYY-MM-DD> <barcode> <grams>\n";
+            ++rejected;
+            continue;
+        }
+        ++appended;
+    }
+    journal.close();
+
+    std::cerr << appended << " events journaled, " << rejected << " rejected\n";
+    return rejected == 0 ? 0 : 2;
+}
+
+static int printSyncStats(const SyncStats& stats, bool exported) {
+    if (exported) {
+        std::cout << "Foods sent: " << stats.foodsSent << "\n"
+                  << "Log rows sent: " << stats.logRowsSent << "\n";
+    } else {
+        std::cout << "Foods applied: " << stats.foodsApplied << "\n"
+                  << "Foods kept (local version newer): " << stats.foodsKeptLocal << "\n"
+                  << "Log rows applied: " << stats.logRowsApplied << "\n"
+                  << "Log rows already present: " << stats.logRowsSkipped << "\n";
+    }
+    std::cout << "Time: " << stats.seconds << " s\n";
+    if (!stats.completed) {
+        std::cerr << "Sync failed: " << stats.error << "\n";
+        return 1;
+    }
+    return 0;
+}
+
+static int runJournalReplay(DatabaseManager& db, const std::string& journalPath, int argc, char** argv, int i) {
+    long long batch = 10000;
+    bool compact = false;
+    for (; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--compact") {
+            compact = true;
+        } else if (arg == "--batch" && i + 1 < argc) {
+            batch = std::atoll(argv[++i]);
+        } else {
+            printUsage();
+            return 1;
+        }
+    }
+    if (batch <= 0) {
+        printUsage();
+        return 1;
+    }
+
+    JournalReplayStats stats = replayJournal(db, journalPath, batch);
+    std::cout << "Records replayed: " << stats.records << "\n"
+              << "Inserted: " << stats.inserted << "\n"
+              << "Unknown barcodes: " << stats.unknownBarcodes << "\n"
+              << "Dates out of range: " << stats.outOfRange << "\n"
+              << "Torn tail ignored: " << stats.tornBytes << " bytes\n"
+              << "Batches: " << stats.batches << "\n"
+              << "Time: " << stats.seconds << " s\n";
+    if (!stats.completed) {
+        std::cerr << "Replay stopped: " << stats.error << "\n";
+        return 1;
+    }
+    if (compact) {
+        if (!compactJournal(db, journalPath)) return 1;
+        std::cout << "Journal compacted.\n";
+    }
+    return 0;
+}
+
+// Reports over many user databases; each file's stem is its user label.
+static int runReportMode(int argc, char** argv, int i) {
+    if (i + 1 >= argc) {
+        printUsage();
+        return 1;
+    }
+    auto from = Date::parse(argv[i]);
+    auto to = Date::parse(argv[i + 1]);
+    if (!from || !to || *to < *from) {
+        std::cerr << "Report range must be two ISO dates, oldest first.\n";
+        return 1;
+    }
+    i += 2;
+
+    ReportOptions options;
+    std::string outputPath;
+    bool splitMonths = false;
+    for (; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--split-months") {
+            splitMonths = true;
+            continue;
+        }
+        if (arg.compare(0, 2, "--") != 0) break;
+        if (i + 1 >= argc) {
+            printUsage();
+            return 1;
+        }
+        std::string value = argv[++i];
+
+        bool ok = true;
+        if (arg == "--format") {
+            ok = value == "csv" || value == "json";
+            options.format = value == "json" ? ReportFormat::Json : ReportFormat::Csv;
+        } else if (arg == "--threads") {
+            options.threads = static_cast<size_t>(std::atoll(value.c_str()));
+        } else if (arg == "--top") {
+            options.topFoods = static_cast<size_t>(std::atoll(value.c_str()));
+        } else if (arg == "--output") {
+            outputPath = value;
+        } else {
+            ok = false;
+        }
+        if (!ok) {
+            printUsage();
+            return 1;
+        }
+    }
+    if (i >= argc) {
+        printUsage();
+        return 1;
+    }
+
+    std::vector<ReportJob> jobs;
+    for (; i < argc; ++i) {
+        ReportJob job{ std::filesystem::path(argv[i]).stem().string(), argv[i], *from, *to };
+        if (splitMonths) {
+            for (ReportJob& part : splitByMonth(job)) jobs.push_back(std::move(part));
+        } else {
+            jobs.push_back(std::move(job));
+        }
+    }
+
+    std::ofstream file;
+    if (!outputPath.empty()) {
+        file.open(outputPath, std::ios::binary);
+        if (!file) {
+            std::cerr << "Cannot open " << outputPath << "\n";
+            return 1;
+        }
+    }
+
+    ReportRunStats stats = runReports(jobs, options, outputPath.empty() ? std::cout : file);
+    std::cerr << stats.jobs << " jobs (" << stats.failed << " failed), " << stats.rowsWritten << " rows, "
+              << stats.daysLogged << " logged days in " << stats.seconds << " s\n";
+    return stats.failed == 0 ? 0 : 2;
+}
+
+int main(int argc, char** argv) {
+    const auto processStart = std::chrono::steady_clock::now();
+    std::string dbPath = "../data/calories.db";
+    int argi = 1;
+
+    // Reports open their own read-only connections and journaling works without
+    // the database, so neither involves --db.
+    if (argi < argc && std::string(argv[argi]) == "--report") {
+        return runReportMode(argc, argv, argi + 1);
+    }
+    if (argi < argc && std::string(argv[argi]) == "--journal") {
+        return runJournalAppend(argc, argv, argi + 1);
+    }
+
+    if (argi + 1 < argc && std::string(argv[argi]) == "--db") {
+        dbPath = argv[argi + 1];
+        argi += 2;
+    }
+    std::string snapshotPath;
+    std::string metricsPath;
+    bool printStats = false;
+    bool warmCatalog = false;
+    while (argi < argc) {
+        std::string option = argv[argi];
+        if (option == "--snapshot" && argi + 1 < argc) {
+            snapshotPath = argv[argi + 1];
+            argi += 2;
+        } else if (option == "--metrics-file" && argi + 1 < argc) {
+            metricsPath = argv[argi + 1];
+            argi += 2;
+        } else if (option == "--stats") {
+            printStats = true;
+            ++argi;
+        } else if (option == "--warm") {
+            warmCatalog = true;
+            ++argi;
+        } else {
+            break;
+        }
+    }
+
+    // Script output is meant for other programs, so keep stdout clean.
+    OpenProfile profile;
+    profile.verbose = !(argi < argc && std::string(argv[argi]) == "--script");
+
+    DatabaseManager db(dbPath, profile);
+    // Declared after db so it reports while the connection is still open.
+    MetricsOnExit metricsOnExit{ metricsPath, printStats };
 
     if (!db.open()) return 1;
     if (!db.createTables()) return 1;
+    if (!snapshotPath.empty() && !db.attachSnapshot(snapshotPath)) return 1;
+    if (warmCatalog) db.startCatalogWarmup();
 
-    std::cout << "\n1) Add food\n2) Lookup food by barcode\n3) Log food eaten\n4) Show total calories for a date\n5) Set daily calorie goal\n9) Admin\nChoose: ";
+    if (argi < argc) {
+        std::string mode = argv[argi];
+        if (mode == "--import" && argi + 1 < argc) {
+            return runImport(db, argv[argi + 1], argc, argv, argi + 2);
+        }
+        if (mode == "--rebuild-totals" && argi + 1 == argc) {
+            bool ok = db.rebuildDailyTotals();
+            std::cout << (ok ? "Daily totals rebuilt.\n" : "Rebuild failed.\n");
+            return ok ? 0 : 1;
+        }
+        if (mode == "--export-snapshot" && argi + 2 == argc) {
+            SnapshotExportStats stats;
+            if (!CatalogSnapshot::write(db.handle(), argv[argi + 1], stats)) return 1;
+            std::cout << "Exported " << stats.foods << " foods (" << stats.bytes << " bytes)";
+            if (stats.skipped > 0) std::cout << "; skipped " << stats.skipped << " non-numeric barcodes";
+            std::cout << ".\n";
+            return 0;
+        }
+        if (mode == "--replay-journal" && argi + 1 < argc) {
+            return runJournalReplay(db, argv[argi + 1], argc, argv, argi + 2);
+        }
+        if (mode == "--sync-export" && (argi + 2 == argc ||
+                                        (argi + 4 == argc && std::string(argv[argi + 2]) == "--peer"))) {
+            std::string peer = argi + 4 == argc ? argv[argi + 3] : "default";
+            return printSyncStats(exportChanges(db, argv[argi + 1], peer), true);
+        }
+        if (mode == "--sync-apply" && (argi + 2 == argc ||
+                                       (argi + 4 == argc && std::string(argv[argi + 2]) == "--peer"))) {
+            std::string peer = argi + 4 == argc ? argv[argi + 3] : "default";
+            return printSyncStats(applyChanges(db, argv[argi + 1], peer), false);
+        }
+        if (mode == "--script") {
+            return runScript(db, argc, argv, argi + 1);
+        }
+        if (mode == "--retention" && argi + 2 == argc) {
+            std::string value = argv[argi + 1];
+            int months = value == "off" ? 0 : std::atoi(value.c_str());
+            if ((months <= 0 && value != "off") || !db.setLogRetentionMonths(months)) {
+                printUsage();
+                return 1;
+            }
+            int dropped = db.applyLogRetention(*Date::parse(todayDateISO()));
+            if (dropped < 0) return 1;
+            std::cout << "Log retention: " << (months > 0 ? std::to_string(months) + " months" : "off")
+                      << "; dropped " << dropped << " expired months.\n";
+            return 0;
+        }
+        printUsage();
+        return 1;
+    }
+
+    // Expired months are dropped once per interactive session.
+    if (db.applyLogRetention(*Date::parse(todayDateISO())) < 0) return 1;
+
+    { OpTimer firstPrompt(MetricOp::FirstPrompt, processStart); }
+    std::cout << "\n1) Add food\n2) Lookup food by barcode\n3) Log food eaten\n4) Show total calories for a date\n5) Set daily calorie goal\n6) Report for a date range\n7) Search foods by name\n8) Create recipe\n9) Admin\nChoose: ";
     int choice = 0;
     std::cin >> choice;
 
@@ -166,20 +557,22 @@ int main() {
         std::string date = chooseDateOrToday();
         std::cout << "Showing today's entries (" << date << ")\n";
         
-        auto entries = db.getEntriesForDate(date);
-
-        if(entries.empty()) {
+        auto day = Date::parse(date);
+        UserDayLog entries;
+        if (!day || !entries.load(db, *day) || entries.empty()) {
             std::cout << "No entries for " << date << ".\n";
             return 0;
         }
 
         std::cout << "\nEntries for " << date << ":\n";
         for (const auto& e : entries) {
-            std::cout << "- " << e.name << " (" << e.barcode << ") " << e.grams << "g -> " << e.calories << " kcal\n";
+            std::cout << "- " << e.name << " (" << e.barcode << ") " << e.grams << "g -> " << e.nutrients.calories() << " kcal\n";
         }
+        const Nutrients sum = entries.totals();
 
-        double total = db.getTotalCaloriesForDate(date);
-        std::cout << "Total: " << total << " kcal\n";
+        double total = sum.calories();
+        std::cout << "Total: " << total << " kcal (protein " << sum.protein() << " g, carbs " << sum.carbs()
+                  << " g, fat " << sum.fat() << " g)\n";
 
         double goal = db.getDailyGoal();
 
@@ -211,6 +604,90 @@ int main() {
             std::cout << "Failed to set goal.\n";
         }
     }
+    else if (choice == 6) {
+        std::cout << "From:\n";
+        std::string from = chooseDateOrToday();
+        std::cout << "To:\n";
+        std::string to = chooseDateOrToday();
+
+        NutritionSeries series = db.getNutritionSeries(from, to);
+        if (series.size() == 0) {
+            std::cout << "No entries between " << from << " and " << to << ".\n";
+            return 0;
+        }
+
+        double calories = 0, protein = 0, carbs = 0, fat = 0;
+        for (size_t i = 0; i < series.size(); ++i) {
+            calories += series.calories[i];
+            protein += series.protein[i];
+            carbs += series.carbs[i];
+            fat += series.fat[i];
+        }
+
+        const double days = static_cast<double>(series.size());
+        std::cout << "\nLogged days: " << series.size() << "\n";
+        std::cout << "Average per logged day: " << calories / days << " kcal | "
+                  << "P " << protein / days << "g, "
+                  << "C " << carbs / days << "g, "
+                  << "F " << fat / days << "g\n";
+
+        double goal = db.getDailyGoal();
+        if (goal > 0) {
+            std::cout << "Longest streak within goal: " << longestStreakWithinGoal(series, goal) << " day(s)\n";
+        }
+    }
+    else if (choice == 7) {
+        std::string query;
+        std::cout << "Name (or part of it): ";
+        std::getline(std::cin, query);
+
+        FoodSearch search(db);
+        SearchResult result = search.search(query, 10);
+        if (result.hits.empty()) {
+            // Nothing matched whole words; try the typo-tolerant index.
+            search.buildIndex();
+            result = search.searchFuzzy(query, 10, std::chrono::milliseconds(200));
+        }
+
+        if (result.hits.empty()) {
+            std::cout << "No foods match \"" << query << "\".\n";
+            return 0;
+        }
+
+        for (const auto& hit : result.hits) {
+            std::cout << "- " << hit.food.name << " (" << hit.food.barcode << ") "
+                      << hit.food.calories_per_100g << " kcal/100g"
+                      << (hit.fuzzy ? " [similar]" : "") << "\n";
+        }
+    }
+    else if (choice == 8) {
+        Recipe recipe;
+        std::cout << "Recipe barcode: ";
+        std::cin >> recipe.barcode;
+
+        clearInput();
+        std::cout << "Name: ";
+        std::getline(std::cin, recipe.name);
+
+        std::cout << "Ingredients, one \"<barcode> <grams>\" per line, empty line to finish:\n";
+        std::string line;
+        while (std::getline(std::cin, line) && !line.empty()) {
+            std::istringstream in(line);
+            RecipeItem item;
+            if (in >> item.barcode >> item.grams) recipe.items.push_back(item);
+            else std::cout << "Skipped: " << line << "\n";
+        }
+
+        std::cout << "Cooked weight in grams (0 = sum of ingredients): ";
+        std::cin >> recipe.yieldGrams;
+
+        if (addRecipe(db, recipe)) {
+            auto food = db.getFoodByBarcode(recipe.barcode);
+            std::cout << "Recipe added: " << (food ? food->calories_per_100g : 0.0) << " kcal per 100g.\n";
+        } else {
+            std::cout << "Failed to add recipe.\n";
+        }
+    }
     else if (choice == 9) {
         std::string code;
         std::cout << "Admin code: ";
@@ -225,6 +702,7 @@ int main() {
         std::cout << "1) Clear all daily logs\n";
         std::cout << "2) Clear all foods (also clears logs)\n";
         std::cout << "3) Factory reset (wipe everything)\n";
+        std::cout << "4) Rebuild daily totals (after editing food nutrition)\n";
         std::cout << "Choose: ";
 
         int adminChoice = 0;
@@ -246,6 +724,7 @@ int main() {
         if (adminChoice == 1) ok = db.clearAllLogs();
         else if (adminChoice == 2) ok = db.clearAllFoods();
         else if (adminChoice == 3) ok = db.factoryReset();
+        else if (adminChoice == 4) ok = db.rebuildDailyTotals();
         else { std::cout << "Unknown option.\n"; return 0; }
 
         std::cout << (ok ? "Done.\n" : "Operation failed.\n");
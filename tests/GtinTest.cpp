@@ -0,0 +1,130 @@
+#include "FoodDatabase.h"
+#include "Gtin.h"
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Expected {
+    const char* raw;
+    const char* normalized;
+};
+
+const Expected known[] = {
+    { "4006381333931", "04006381333931" },
+    { " 4006381333931\r\n", "04006381333931" },
+    { "]E04006381333931", "04006381333931" },
+    { "036000291452", "00036000291452" },
+    { "0036000291452", "00036000291452" },
+    { "0 36000 29145 2", "00036000291452" },
+    { "0-36000-29145-2", "00036000291452" },
+    { "96385074", "00000096385074" },
+    { "10012345678902", "10012345678902" },
+    { "9780306406157", "09780306406157" },
+    { "4006381333932", "4006381333932" },
+    { "ABC-123", "ABC-123" },
+    { "900001", "900001" },
+    { "", "" },
+};
+
+uint64_t nextRandom(uint64_t& state) {
+    uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+char checkDigit(const std::string& body) {
+    int sum = 0;
+    for (size_t i = 0; i < body.size(); ++i) {
+        const int digit = body[body.size() - 1 - i] - '0';
+        sum += (i % 2 == 0) ? digit * 3 : digit;
+    }
+    return static_cast<char>('0' + (10 - sum % 10) % 10);
+}
+
+// Valid and misread GTINs of every length from 1 to 16 digits, plus text,
+// so both kernels see every lane alignment and rejection path.
+std::string generateCode(uint64_t& state) {
+    const uint64_t kind = nextRandom(state) % 10;
+    if (kind == 0) return "SKU-" + std::to_string(nextRandom(state) % 100000);
+
+    std::string code;
+    const size_t length = 1 + nextRandom(state) % 16;
+    for (size_t i = 0; i + 1 < length; ++i) code += static_cast<char>('0' + nextRandom(state) % 10);
+    char check = checkDigit(code);
+    if (kind == 1) check = static_cast<char>('0' + (check - '0' + 1) % 10);
+    code += check;
+    return code;
+}
+
+int checkKnownCodes() {
+    int failures = 0;
+    for (const Expected& e : known) {
+        const std::string got = normalizeBarcode(e.raw);
+        if (got != e.normalized) {
+            std::cout << "normalizeBarcode(\"" << e.raw << "\") = \"" << got << "\", expected \"" << e.normalized
+                      << "\"\n";
+            ++failures;
+        }
+    }
+    return failures;
+}
+
+// The batch kernel against the scalar one and against isValidGtin plus
+// normalizedBarcodeKey, code by code.
+int checkBatchKeys(size_t count) {
+    uint64_t state = 24;
+    std::vector<std::string> storage;
+    for (size_t i = 0; i < count; ++i) storage.push_back(generateCode(state));
+    std::vector<std::string_view> codes(storage.begin(), storage.end());
+    std::vector<uint64_t> scalarKeys(count);
+    std::vector<uint64_t> batchKeys(count);
+    const size_t scalarValid = gtinKeysScalar(codes.data(), count, scalarKeys.data());
+    const size_t batchValid = gtinKeys(codes.data(), count, batchKeys.data());
+
+    int failures = scalarValid == batchValid ? 0 : 1;
+    for (size_t i = 0; i < count; ++i) {
+        uint64_t key = 0;
+        const uint64_t expected = isValidGtin(codes[i]) && normalizedBarcodeKey(codes[i], key) ? key : 0;
+        if (scalarKeys[i] != expected || batchKeys[i] != expected) {
+            if (failures++ < 5) {
+                std::cout << "key \"" << codes[i] << "\": scalar " << scalarKeys[i] << ", batch " << batchKeys[i]
+                          << ", expected " << expected << "\n";
+            }
+        } else if (expected != 0 && gtin14FromKey(expected) != normalizeBarcode(codes[i])) {
+            if (failures++ < 5) std::cout << "gtin14FromKey mismatch for \"" << codes[i] << "\"\n";
+        }
+    }
+    return failures;
+}
+
+// The in-memory catalog matches barcodes the way DatabaseManager does.
+int checkMemoryCatalog() {
+    MemoryFoodDatabase catalog;
+    int failures = 0;
+    auto check = [&](bool ok, const char* what) {
+        if (!ok) {
+            std::cout << "memory catalog: " << what << "\n";
+            ++failures;
+        }
+    };
+    check(catalog.add(Food{ "036000291452", "Cereal", 380, 8, 80, 3 }), "add a UPC-A code");
+    check(!catalog.add(Food{ "0036000291452", "Cereal", 380, 8, 80, 3 }), "the EAN-13 form is a duplicate");
+    auto found = catalog.find("0 36000 29145 2");
+    check(found && found->barcode == "00036000291452", "find by a spaced UPC-A returns the GTIN-14");
+    check(catalog.update(Food{ "00036000291452", "Cereal 2", 381, 8, 80, 3 }), "update by the GTIN-14");
+    found = catalog.find("036000291452");
+    check(found && found->name == "Cereal 2", "the update is found by the UPC-A");
+    return failures;
+}
+
+} // namespace
+
+int main() {
+    const int failures = checkKnownCodes() + checkBatchKeys(200000) + checkMemoryCatalog();
+    std::cout << (failures == 0 ? "gtin: all checks passed\n" : "gtin: checks failed\n");
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,158 @@
+#include "DatabaseManager.h"
+#include "LogJournal.h"
+#include <csignal>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+int failures = 0;
+
+void expect(bool ok, const std::string& what) {
+    if (!ok) {
+        std::cout << "FAILED: " << what << "\n";
+        ++failures;
+    }
+}
+
+const int kFoods = 100;
+const Date kDay = Date::fromYmd(2025, 6, 1);
+
+std::string barcodeFor(long long i) {
+    return std::to_string(4000000000000LL + i % kFoods);
+}
+
+OpenProfile quietProfile() {
+    OpenProfile profile = throughputProfile();
+    profile.verbose = false;
+    return profile;
+}
+
+bool createCatalog(const std::string& path) {
+    DatabaseManager db(path, quietProfile());
+    if (!db.open() || !db.createTables()) return false;
+    db.beginTransaction();
+    for (int i = 0; i < kFoods; ++i) {
+        db.addFood(Food{ barcodeFor(i), "Journal food " + std::to_string(i), 100.0 + i, 5.0, 10.0, 2.0 });
+    }
+    return db.commit();
+}
+
+// Row count and SUM(grams) of the replayed log. Record i is written with
+// grams = i + 1, so a gap-free, duplicate-free prefix of n records sums to n(n+1)/2.
+void logShape(const std::string& path, long long& rows, double& grams) {
+    DatabaseManager db(path, quietProfile());
+    rows = 0;
+    grams = 0.0;
+    if (!db.open()) return;
+    sqlite3_stmt* stmt = nullptr;
+    sqlite3_prepare_v2(db.handle(), "SELECT COUNT(*), TOTAL(grams) FROM daily_log;", -1, &stmt, nullptr);
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        rows = sqlite3_column_int64(stmt, 0);
+        grams = sqlite3_column_double(stmt, 1);
+    }
+    sqlite3_finalize(stmt);
+}
+
+void expectReplayed(const std::string& dbPath, long long expected, const std::string& what) {
+    long long rows = 0;
+    double grams = 0.0;
+    logShape(dbPath, rows, grams);
+    expect(rows == expected && grams == static_cast<double>(expected) * (expected + 1) / 2,
+           what + ": " + std::to_string(rows) + " rows, expected " + std::to_string(expected));
+}
+
+// Runs `work` in a child process and SIGKILLs it after `ms` milliseconds.
+template <typename Work>
+void runAndKill(int ms, Work work) {
+    const pid_t pid = fork();
+    if (pid == 0) {
+        work();
+        _exit(0);
+    }
+    usleep(static_cast<useconds_t>(ms) * 1000);
+    kill(pid, SIGKILL);
+    waitpid(pid, nullptr, 0);
+}
+
+} // namespace
+
+// A writer and a replay are each SIGKILLed mid-stream and a torn record is
+// left at the tail; replay must still produce exactly the journaled rows,
+// once, and reopening the journal must cut the torn tail off.
+int main() {
+    const fs::path dir = fs::temp_directory_path() / ("calorie_journal_test_" + std::to_string(getpid()));
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    const std::string journalPath = (dir / "scans.jrnl").string();
+    const std::string dbPath = (dir / "journal.db").string();
+    if (!createCatalog(dbPath)) {
+        std::cout << "cannot create " << dbPath << "\n";
+        return 1;
+    }
+
+    runAndKill(150, [&] {
+        JournalOptions options;
+        options.syncEveryRecords = 64;
+        LogJournalWriter journal;
+        if (!journal.open(journalPath, options)) return;
+        for (long long i = 0;; ++i) journal.append(kDay, barcodeFor(i), static_cast<double>(i + 1));
+    });
+
+    // SIGKILL cannot split a write(), so tear the tail by hand: a record
+    // header whose payload never made it to disk.
+    {
+        std::ofstream tail(journalPath, std::ios::binary | std::ios::app);
+        const unsigned char torn[] = { 33, 0, 0, 0, 0xde, 0xad, 0xbe, 0xef, 1, 2, 3 };
+        tail.write(reinterpret_cast<const char*>(torn), sizeof(torn));
+    }
+
+    long long journaled = 0;
+    {
+        runAndKill(20, [&] {
+            DatabaseManager db(dbPath, quietProfile());
+            if (db.open()) replayJournal(db, journalPath, 500);
+        });
+        long long partialRows = 0;
+        double partialGrams = 0.0;
+        logShape(dbPath, partialRows, partialGrams);
+
+        DatabaseManager db(dbPath, quietProfile());
+        if (!db.open()) return 1;
+        JournalReplayStats stats = replayJournal(db, journalPath, 500);
+        journaled = partialRows + stats.records;
+        expect(stats.completed && journaled > 0, "replay after the killed replay completes");
+        expect(stats.tornBytes == 11, "replay ignores the 11 torn bytes (got " + std::to_string(stats.tornBytes) + ")");
+        expectReplayed(dbPath, journaled, "replay after the killed replay");
+
+        JournalReplayStats again = replayJournal(db, journalPath, 500);
+        expect(again.inserted == 0, "a second replay inserts nothing (got " + std::to_string(again.inserted) + ")");
+    }
+
+    {
+        LogJournalWriter journal;
+        expect(journal.open(journalPath), "reopen the journal for writing");
+        expect(journal.tornBytesDropped() == 11, "reopening drops the torn tail");
+        for (long long i = journaled; i < journaled + 1000; ++i) {
+            journal.append(kDay, barcodeFor(i), static_cast<double>(i + 1));
+        }
+        journal.close();
+
+        DatabaseManager db(dbPath, quietProfile());
+        if (!db.open()) return 1;
+        JournalReplayStats stats = replayJournal(db, journalPath);
+        expect(stats.inserted == 1000, "replay after reopening inserts the 1000 new records");
+        expectReplayed(dbPath, journaled + 1000, "replay after reopening");
+    }
+
+    std::error_code ec;
+    fs::remove_all(dir, ec);
+    std::cout << (failures == 0 ? "journal: all checks passed\n" : "journal: checks failed\n");
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,170 @@
+#include "DatabaseManager.h"
+#include "Statement.h"
+#include "Sync.h"
+#include <chrono>
+#include <cstdlib>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+int failures = 0;
+
+void expect(bool ok, const std::string& what) {
+    if (!ok) {
+        std::cout << "FAILED: " << what << "\n";
+        ++failures;
+    }
+}
+
+const Date today = Date::fromDays(static_cast<int32_t>(std::time(nullptr) / 86400));
+
+// A fresh database in the test directory; each one gets its own device id.
+std::unique_ptr<DatabaseManager> openDatabase(const fs::path& dir, const std::string& name) {
+    auto db = std::make_unique<DatabaseManager>((dir / (name + ".db")).string());
+    if (!db->open() || !db->createTables()) {
+        std::cout << "cannot create " << name << ".db\n";
+        std::exit(1);
+    }
+    return db;
+}
+
+std::string foodName(DatabaseManager& db, const std::string& barcode) {
+    auto food = db.getFoodByBarcode(barcode);
+    return food ? food->name : "<missing>";
+}
+
+std::string readFile(const fs::path& path) {
+    std::ifstream in(path, std::ios::binary);
+    std::ostringstream text;
+    text << in.rdbuf();
+    return text.str();
+}
+
+// Applying the same changeset twice inserts nothing the second time, and
+// nothing received from a peer goes back to it.
+void checkIdempotentApplyAndNoEcho(const fs::path& dir) {
+    auto a = openDatabase(dir, "idem_a");
+    auto b = openDatabase(dir, "idem_b");
+    a->addFood({ "4006381333931", "Oats", 370, 13, 60, 7 });
+    a->logFoodForDate(today, "4006381333931", 80);
+    a->logFoodForDate(today, "4006381333931", 40);
+
+    const fs::path changeset = dir / "idem_a.changeset";
+    expect(exportChanges(*a, changeset.string(), "b").completed, "export a -> b");
+    SyncStats first = applyChanges(*b, changeset.string(), "a");
+    expect(first.completed && first.foodsApplied == 1 && first.logRowsApplied == 2, "first apply adds 1 food, 2 rows");
+    SyncStats second = applyChanges(*b, changeset.string(), "a");
+    expect(second.completed && second.foodsApplied == 0 && second.logRowsApplied == 0, "second apply adds nothing");
+    expect(b->getEntriesForDate(today).size() == 2, "b has 2 entries after applying twice");
+
+    b->logFoodForDate(today, "4006381333931", 25);
+    SyncStats back = exportChanges(*b, (dir / "idem_b.changeset").string(), "a");
+    expect(back.completed && back.foodsSent == 1 && back.logRowsSent == 1,
+           "export b -> a holds only b's own row (and its food)");
+}
+
+// Both sides edit one barcode; every database ends with the same version
+// whichever order the changesets arrive in.
+void checkConflictOrder(const fs::path& dir) {
+    auto a = openDatabase(dir, "conflict_a");
+    auto b = openDatabase(dir, "conflict_b");
+    a->addFood({ "036000291452", "Cereal", 380, 8, 80, 3 });
+    expect(exportChanges(*a, (dir / "conflict_a0.changeset").string(), "b").completed, "export a0");
+    expect(applyChanges(*b, (dir / "conflict_a0.changeset").string(), "a").completed, "apply a0 to b");
+
+    a->updateFood({ "036000291452", "Cereal (a)", 381, 8, 80, 3 });
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    b->updateFood({ "036000291452", "Cereal (b)", 382, 8, 80, 3 });
+    const std::string fromA = (dir / "conflict_a1.changeset").string();
+    const std::string fromB = (dir / "conflict_b1.changeset").string();
+    expect(exportChanges(*a, fromA, "b").completed, "export a1");
+    expect(exportChanges(*b, fromB, "a").completed, "export b1");
+
+    auto c = openDatabase(dir, "conflict_c");
+    auto d = openDatabase(dir, "conflict_d");
+    expect(applyChanges(*c, fromA, "a").completed && applyChanges(*c, fromB, "b").completed, "c applies a1, b1");
+    expect(applyChanges(*d, fromB, "b").completed && applyChanges(*d, fromA, "a").completed, "d applies b1, a1");
+    expect(applyChanges(*a, fromB, "b").completed, "apply b1 to a");
+    expect(applyChanges(*b, fromA, "a").completed, "apply a1 to b");
+
+    const std::string winner = foodName(*c, "036000291452");
+    expect(winner == "Cereal (b)", "the later edit wins (got " + winner + ")");
+    expect(foodName(*d, "036000291452") == winner, "d agrees with c");
+    expect(foodName(*a, "036000291452") == winner, "a agrees with c");
+    expect(foodName(*b, "036000291452") == winner, "b agrees with c");
+}
+
+// A changeset from a peer that stored raw barcodes lands on the normalized food.
+void checkRawBarcodesNormalized(const fs::path& dir) {
+    auto a = openDatabase(dir, "raw_a");
+    auto b = openDatabase(dir, "raw_b");
+    b->addFood({ "4006381333931", "Old name", 100, 1, 1, 1 });
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    a->addFood({ "4006381333931", "New name", 200, 2, 2, 2 });
+    a->logFoodForDate(today, "4006381333931", 50);
+
+    const fs::path changeset = dir / "raw_a.changeset";
+    expect(exportChanges(*a, changeset.string(), "b").completed, "export raw_a");
+    sqlite3* file = nullptr;
+    sqlite3_open(changeset.string().c_str(), &file);
+    expect(sqlite3_exec(file, "UPDATE foods SET barcode = '4006381333931';"
+                              "UPDATE log_rows SET barcode = '4006381333931';", nullptr, nullptr, nullptr) == SQLITE_OK,
+           "rewrite the changeset with raw barcodes");
+    sqlite3_close(file);
+
+    SyncStats stats = applyChanges(*b, changeset.string(), "a");
+    expect(stats.completed && stats.logRowsApplied == 1, "apply the raw changeset");
+    expect(foodName(*b, "4006381333931") == "New name", "the raw barcode updates the normalized food");
+    Statement count;
+    count.prepare(b->handle(), "SELECT COUNT(*) FROM foods;");
+    expect(sqlite3_step(count.get()) == SQLITE_ROW && sqlite3_column_int(count.get(), 0) == 1,
+           "no second food for the raw form");
+}
+
+// An export replaces an earlier changeset, but never another file.
+void checkExportTargets(const fs::path& dir) {
+    auto a = openDatabase(dir, "target_a");
+    a->addFood({ "96385074", "Milk", 64, 3, 5, 4 });
+
+    const fs::path notes = dir / "notes.txt";
+    std::ofstream(notes) << "not a changeset\n";
+    expect(!exportChanges(*a, notes.string(), "b").completed, "export refuses a text file");
+    expect(readFile(notes) == "not a changeset\n", "the text file is untouched");
+
+    const fs::path other = dir / "idem_b.db";
+    const std::string before = readFile(other);
+    expect(!exportChanges(*a, other.string(), "b").completed, "export refuses another database");
+    expect(readFile(other) == before, "the other database is untouched");
+    expect(!exportChanges(*a, (dir / "target_a.db").string(), "b").completed, "export refuses its own database");
+
+    const fs::path changeset = dir / "target_a.changeset";
+    expect(exportChanges(*a, changeset.string(), "b").completed, "first export");
+    expect(exportChanges(*a, changeset.string(), "b").completed, "an export replaces an earlier changeset");
+}
+
+} // namespace
+
+int main() {
+    const fs::path dir = fs::temp_directory_path() / ("calorie_sync_test_" + std::to_string(std::time(nullptr)));
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+
+    checkIdempotentApplyAndNoEcho(dir);
+    checkConflictOrder(dir);
+    checkRawBarcodesNormalized(dir);
+    checkExportTargets(dir);
+
+    std::error_code ec;
+    fs::remove_all(dir, ec);
+    std::cout << (failures == 0 ? "sync: all checks passed\n" : "sync: checks failed\n");
+    return failures == 0 ? 0 : 1;
+}